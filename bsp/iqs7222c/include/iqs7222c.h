@@ -13,12 +13,12 @@
 #ifndef IQS7222C_h
 #define IQS7222C_h
 
-#include <nrf_drv_twi.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
 // Include Files
+#include "i2c_touch.h"
 #include "iqs7222c_addresses.h"
 
 /* Device Firmware version select */
@@ -50,6 +50,18 @@
 #define NORMAL_POWER_BIT 0x00
 #define LOW_POWER_BIT 0x01
 #define ULP_BIT 0x02
+// Info flags lsb fields tracked for events, see IQS7222C_INFO_FLAGS.
+#define IQS7222C_INFO_ATI_ERROR 0x02
+#define IQS7222C_INFO_POWER_MODE 0x30
+
+// Events Word Bits (IQS7222C_MM_EVENTS, 16 bit).
+#define IQS7222C_EVENTS_PROX 0x0001
+#define IQS7222C_EVENTS_TOUCH 0x0002
+#define IQS7222C_EVENTS_SLIDER0 0x0100
+#define IQS7222C_EVENTS_SLIDER1 0x0200
+#define IQS7222C_EVENTS_SLIDERS (IQS7222C_EVENTS_SLIDER0 | IQS7222C_EVENTS_SLIDER1)
+#define IQS7222C_EVENTS_ATI 0x1000
+#define IQS7222C_EVENTS_POWER 0x2000
 
 // Utility Bits
 #define ACK_RESET_BIT 0x01
@@ -59,13 +71,41 @@
 #define EVENT_MODE_BIT 0x40
 #define STREAM_IN_TOUCH_BIT 0x80
 
+// Init sequence timing
+#define IQS7222C_RESET_DELAY_MS 100
+#define IQS7222C_RDY_TIMEOUT_MS 100
+
+// Decoded event queue, power of two
+#ifndef IQS7222C_EVENT_QUEUE_SIZE
+#define IQS7222C_EVENT_QUEUE_SIZE 32
+#endif
+#define IQS7222C_SLIDER_NO_TOUCH 0xFFFF
+
+// Event subscribers per device, see iqs7222c_subscribe
+#ifndef IQS7222C_MAX_SUBSCRIBERS
+#define IQS7222C_MAX_SUBSCRIBERS 8
+#endif
+// All ten channels, for the channels mask of iqs7222c_subscribe
+#define IQS7222C_ALL_CHANNELS 0x03FF
+#define IQS7222C_CHANNELS 10
+
+// Per window read plan blocks, see iqs7222c_setReadPlan
+#define IQS7222C_READ_SLIDER0 0x01
+#define IQS7222C_READ_SLIDER1 0x02
+#define IQS7222C_READ_COUNTS 0x04
+#define IQS7222C_READ_LTA 0x08
+#define IQS7222C_READ_SLIDERS (IQS7222C_READ_SLIDER0 | IQS7222C_READ_SLIDER1)
+// Info flags, events, prox and touch states, then the slider outputs
+#define IQS7222C_STATUS_BYTES 8
+#define IQS7222C_STATUS_MAX_BYTES 12
+
 #define FINGER_1 1
 #define FINGER_2 2
 
 // Type Definitions.
 /* Infoflags - address 0x10 - Read Only */
 /* Infoflags - address 0x10 - Read Only */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     union {
@@ -90,10 +130,10 @@ typedef union {
   };
   uint8_t buffer[2];
 } IQS7222C_INFO_FLAGS;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Events - address 0x11 - Read Only */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     union {
@@ -107,7 +147,9 @@ typedef union {
 
     union {
       struct {
-        uint8_t events_res_8 : 4;
+        uint8_t slider0_event : 1;
+        uint8_t slider1_event : 1;
+        uint8_t events_res_10 : 2;
         uint8_t ati_event : 1;
         uint8_t power_event : 1;
         uint8_t events_res_14 : 2;
@@ -117,10 +159,10 @@ typedef union {
   };
   uint8_t buffer[2];
 } IQS7222C_EVENTS;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Proximity Event States - address 0x12 - Read Only */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     union {
@@ -148,10 +190,10 @@ typedef union {
   };
   uint8_t buffer[2];
 } IQS7222C_PROX_EVENT_STATES;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Touch Event States - address 0x13 - Read Only */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     union {
@@ -179,10 +221,10 @@ typedef union {
   };
   uint8_t buffer[2];
 } IQS7222C_TOUCH_EVENT_STATES;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Slider/Wheel outputs - address 0x14-0x15 - Read Only */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     union {
@@ -215,10 +257,10 @@ typedef union {
   };
   uint8_t buffer[4];
 } IQS7222C_SLIDER_WHEEL_OUT;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Channel Counts - address 0x20-0x29 - Read Only */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* Channel 0 Counts */
@@ -373,10 +415,10 @@ typedef union {
   };
   uint8_t buffer[20];
 } IQS7222C_CHANNEL_COUTS;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Channel LTA - address 0x30-0x39 - Read Only */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* Channel 0 LTA */
@@ -531,10 +573,10 @@ typedef union {
   };
   uint8_t buffer[20];
 } IQS7222C_CHANNEL_LTA;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Cycle Setup - Address 0x8000 - 0x8502 */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* Cycle 0 Setup 0 */
@@ -894,10 +936,10 @@ typedef union {
   };
   uint8_t buffer[36];
 } IQS7222C_CYCLE_SETUP;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Button Setup - Address 0x9000 - 0x9902 */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
 
@@ -1363,10 +1405,10 @@ typedef union {
   };
   uint8_t buffer[60];
 } IQS7222C_BUTTON_SETUP;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Channel Setup - Address 0xA000 - 0xA905 */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* Crx Select and General Channel Setup Channel 0*/
@@ -2441,10 +2483,10 @@ typedef union {
   };
   uint8_t buffer[120];
 } IQS7222C_CHANNEL_SETUP;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Filter Betas Addresses from 0xAA00 to 0xAA01 */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* Filter Betas */
@@ -2482,10 +2524,10 @@ typedef union {
   };
   uint8_t buffer[4];
 } IQS7222C_FILTER_BETAS;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Slider and Wheel Setup Addresses from 0x60 to 0x69 */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* Slider & Wheel 0 Setup 0 */
@@ -2814,10 +2856,10 @@ typedef union {
   };
   uint8_t buffer[40];
 } IQS7222C_SLIDER_SETUP;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* GPIO Settings Addresses from 0xC000 to 0xC202 */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* GPIO 0 Enable and Configuration Settings */
@@ -3002,11 +3044,11 @@ typedef union {
   };
   uint8_t buffer[18];
 } IQS7222C_GPIO_SETTINGS;
-#pragma pack(4)
+#pragma pack(pop)
 /***********************************************************************************************************************************/
 
 /* PMU and System Settings Addresses from 0xD0 to 0xD9 */
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     /* Control settings */
@@ -3166,9 +3208,9 @@ typedef union {
   };
   uint8_t buffer[20];
 } IQS7222C_PMU_SYS_SETTINGS;
-#pragma pack(4)
+#pragma pack(pop)
 
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef union {
   struct {
     IQS7222C_INFO_FLAGS iqs7222c_info_flags;
@@ -3194,7 +3236,7 @@ typedef union {
   };
   uint8_t buffer[52];
 } IQS7222C_MEMORY_MAP;
-#pragma pack(4)
+#pragma pack(pop)
 
 /* Defines and structs for IQS7222C states */
 /**
@@ -3207,6 +3249,7 @@ typedef enum {
   IQS7222C_INIT_VERIFY_PRODUCT,
   IQS7222C_INIT_UPDATE_SETTINGS,
   IQS7222C_INIT_CHECK_RESET,
+  IQS7222C_INIT_VERIFY_CONFIG,
   IQS7222C_INIT_ACK_RESET,
   IQS7222C_INIT_ATI,
   IQS7222C_ACTIVATE_EVENT_MODE,
@@ -3244,47 +3287,391 @@ typedef enum {
   ULP,
 } IQS7222C_power_modes;
 
-#pragma pack(1)
+#pragma pack(push, 1)
 typedef struct {
   iqs7222c_init_e init_state;
 } iqs7222c_s;
-#pragma pack(4)
+#pragma pack(pop)
+
+/* Driver context, see struct iqs7222c below */
+typedef struct iqs7222c iqs7222c_t;
+
+/* Status burst completion, see iqs7222c_startAsyncUpdates */
+typedef void (*iqs7222c_update_handler_t)(iqs7222c_t *dev, int result);
+
+/* Decoded events, see iqs7222c_readEvents */
+typedef enum {
+  IQS7222C_EVENT_TOUCH = (uint8_t)0x00,
+  IQS7222C_EVENT_RELEASE,
+  IQS7222C_EVENT_PROX,
+  IQS7222C_EVENT_PROX_RELEASE,
+  IQS7222C_EVENT_SLIDER,
+  IQS7222C_EVENT_ATI_ERROR,  /* value 1 when set, 0 when cleared */
+  IQS7222C_EVENT_POWER_MODE, /* value is the new IQS7222C_power_modes */
+} iqs7222c_event_type_e;
+
+/* Bit of an event type in the types mask of iqs7222c_subscribe */
+#define IQS7222C_EVENT_MASK(type) (1u << (type))
+
+typedef struct {
+  uint32_t timestamp_us; /* RDY falling edge of the window it was read in */
+  uint16_t value;        /* Slider coordinate, 0 for channel events */
+  uint8_t type;          /* iqs7222c_event_type_e */
+  uint8_t index;         /* IQS7222C_Channel_e or IQS7222C_slider_e */
+} iqs7222c_event_t;
+
+/* All channel states at once, see iqs7222c_getChannelMasks. Bit n is
+ * IQS7222C_CHn. */
+typedef struct {
+  uint16_t touch;
+  uint16_t prox;
+  uint16_t touch_changed; /* bits that changed in the last decoded window */
+  uint16_t prox_changed;
+} iqs7222c_channel_masks_t;
+
+/* One decoded RDY window, see iqs7222c_readFrame */
+typedef struct {
+  uint32_t timestamp_us; /* RDY falling edge of the window */
+  uint16_t info_flags;
+  uint16_t events;
+  uint16_t prox;
+  uint16_t touch;
+  uint16_t prox_changed; /* bits that changed since the previous frame */
+  uint16_t touch_changed;
+  uint16_t slider[2];    /* IQS7222C_SLIDER_NO_TOUCH when not touched */
+} iqs7222c_frame_t;
+
+/* Called from the context that decodes the status burst (iqs7222c_run, or
+ * interrupt context with iqs7222c_startAsyncUpdates) */
+typedef void (*iqs7222c_event_handler_t)(iqs7222c_t *dev, const iqs7222c_event_t *event,
+                                         void *p_context);
+
+typedef struct {
+  iqs7222c_event_handler_t handler;
+  void *p_context;
+  uint16_t channels; /* channel events from these IQS7222C_Channel_e bits only */
+  uint8_t types;     /* IQS7222C_EVENT_MASK of the wanted types */
+} iqs7222c_subscriber_t;
+
+typedef struct {
+  uint32_t queued;       /* events written to the queue */
+  uint32_t dropped;      /* events lost because the queue was full */
+  uint32_t rdy_overruns; /* RDY windows opened before the previous one was read */
+  uint16_t high_water;   /* highest queue depth seen */
+} iqs7222c_event_stats_t;
+
+/* How the blocks of the read plan are chosen each RDY window */
+typedef enum {
+  IQS7222C_READ_LEARNED = (uint8_t)0x00, /* one burst sized from the previous window */
+  IQS7222C_READ_EVENTS_FIRST,            /* read the events word, then only what it needs */
+  IQS7222C_READ_FIXED,                   /* every planned block every window */
+} iqs7222c_read_mode_e;
+
+typedef struct {
+  uint32_t windows;   /* RDY windows read */
+  uint32_t transfers; /* register reads issued for them */
+  uint32_t bytes;     /* payload bytes read for them */
+  uint32_t misses;    /* learned bursts that left out slider outputs that changed */
+} iqs7222c_read_stats_t;
+
+/* Bus traffic classes, told apart by register address, see
+ * iqs7222c_getBusStats */
+typedef enum {
+  IQS7222C_BUS_STATUS = (uint8_t)0x00, /* info flags to slider outputs, per window */
+  IQS7222C_BUS_DATA,                   /* channel counts and LTA */
+  IQS7222C_BUS_CONFIG,                 /* setup and system registers, written or read back */
+  IQS7222C_BUS_CONTROL,                /* control settings word, commands and their reads */
+  IQS7222C_BUS_FORCE,                  /* forced communication requests */
+  IQS7222C_BUS_OTHER,                  /* product number and versions */
+  IQS7222C_BUS_OPS
+} iqs7222c_bus_op_e;
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t bytes;   /* register address and payload bytes */
+  uint32_t nacks;   /* address or data NACK */
+  uint32_t wire_us; /* backend clock from start to end of each transfer */
+} iqs7222c_bus_op_stats_t;
+
+typedef struct {
+  iqs7222c_bus_op_stats_t op[IQS7222C_BUS_OPS]; /* indexed by iqs7222c_bus_op_e */
+} iqs7222c_bus_stats_t;
+
+/* Per channel counts and LTA, indexed by IQS7222C_Channel_e, see
+ * iqs7222c_readTelemetry */
+typedef struct {
+  uint16_t counts[IQS7222C_CHANNELS];
+  uint16_t lta[IQS7222C_CHANNELS];
+  int16_t delta[IQS7222C_CHANNELS]; /* counts - LTA */
+} iqs7222c_telemetry_t;
+
+/* RDY window servicing since init completed, see iqs7222c_getWindowStats */
+typedef struct {
+  uint32_t rdy_edges; /* RDY falling edges seen by the interrupt */
+  uint32_t serviced;  /* windows read before the comms timeout */
+  uint32_t missed;    /* windows that closed without a transaction */
+  uint32_t late;      /* of those, reads started after the comms timeout */
+  uint32_t overruns;  /* RDY edges while the previous window was still pending */
+} iqs7222c_window_stats_t;
+
+/* Called with true when windows start being missed and with false once a
+ * window is serviced in time again. Runs from the RDY interrupt or the
+ * context that reads the status burst. */
+typedef void (*iqs7222c_overrun_handler_t)(iqs7222c_t *dev, bool overrun, void *p_context);
+
+/* RDY to application latency histograms, see iqs7222c_getLatency */
+#ifndef IQS7222C_LATENCY_STATS
+#define IQS7222C_LATENCY_STATS 1
+#endif
+/* Two buckets per power of two, the last one collects everything from
+ * 1.5 * 2^23 us (~12.6 s) up */
+#define IQS7222C_LATENCY_BUCKETS 48
+
+/* Measured from the RDY falling edge of the window to */
+typedef enum {
+  IQS7222C_LATENCY_TWI_START = (uint8_t)0x00, /* status read started */
+  IQS7222C_LATENCY_TWI_DONE,                  /* status read complete */
+  IQS7222C_LATENCY_DECODE,                    /* frame published */
+  IQS7222C_LATENCY_DISPATCH,                  /* each subscriber call */
+  IQS7222C_LATENCY_STAGES
+} iqs7222c_latency_stage_e;
+
+typedef struct {
+  uint32_t count;
+  uint32_t max_us;
+  uint32_t buckets[IQS7222C_LATENCY_BUCKETS];
+} iqs7222c_latency_hist_t;
+
+/* Percentiles are the upper edge of their bucket (within 25 %), capped at
+ * max_us */
+typedef struct {
+  uint32_t count;
+  uint32_t p50_us;
+  uint32_t p99_us;
+  uint32_t max_us;
+} iqs7222c_latency_t;
+
+/* Skip the reset, configuration writes and ATI when a device that did not
+ * reset still matches IQS7222C_init.h */
+#ifndef IQS7222C_WARM_START
+#define IQS7222C_WARM_START 1
+#endif
+
+/* Init sequence timing, see iqs7222c_getInitStats */
+typedef struct {
+  uint32_t wall_us;      /* iqs7222c_begin to init done */
+  uint32_t busy_us;      /* time spent inside iqs7222c_init */
+  uint16_t calls;        /* iqs7222c_init calls */
+  uint16_t rdy_timeouts; /* RDY waits that expired and forced communication */
+  bool warm_start;       /* configuration still matched, writes and ATI skipped */
+  bool done;
+} iqs7222c_init_stats_t;
+
+/* Shadow copy of the writable registers */
+/* Extended setup blocks 0x8000 - 0xC202: 139 words */
+#define IQS7222C_SHADOW_SETUP_BYTES 278
+/* PMU & system settings 0xD0 - 0xDC: 13 words */
+#define IQS7222C_SHADOW_SYSTEM_BYTES 26
+#define IQS7222C_SHADOW_BYTES \
+  (IQS7222C_SHADOW_SETUP_BYTES + IQS7222C_SHADOW_SYSTEM_BYTES)
+
+/* Extended setup address range with the same number of words per block */
+typedef struct {
+  uint8_t first;
+  uint8_t last;
+  uint8_t words;
+} iqs7222c_shadow_block_t;
+
+/* Staged shadow bytes, one bit per byte, see iqs7222c_setConfig */
+#define IQS7222C_SHADOW_DIRTY_WORDS ((IQS7222C_SHADOW_BYTES + 31) / 32)
+
+/* Longest configuration burst written by iqs7222c_flushConfig, even */
+#ifndef IQS7222C_MAX_BURST_BYTES
+#define IQS7222C_MAX_BURST_BYTES 120
+#endif
+
+/* Unchanged bytes rewritten to join two bursts, at most the address and
+ * start overhead of a transaction */
+#ifndef IQS7222C_BURST_GAP_BYTES
+#define IQS7222C_BURST_GAP_BYTES 2
+#endif
+
+#if (IQS7222C_MAX_BURST_BYTES % 2) || (IQS7222C_MAX_BURST_BYTES > 254)
+#error "IQS7222C_MAX_BURST_BYTES must be even and fit a uint8_t transfer"
+#endif
+
+/* One configuration write, see iqs7222c_planConfig */
+typedef struct {
+  uint16_t address; /* register address, 8 bit unless extended */
+  uint16_t offset;  /* shadow offset of the first byte */
+  uint8_t length;
+  bool extended;
+} iqs7222c_burst_t;
+
+/* Driver context, one per IQS7222C. Use static or zero initialised storage,
+ * pass it to iqs7222c_begin and then to every other call. Devices may share a
+ * TWI instance. All members are owned by the driver. */
+struct iqs7222c {
+  i2c_touch_t bus;
+  uint8_t address;
+  uint8_t ready_pin;
+  volatile bool device_rdy;
+  bool new_data_available;
+  iqs7222c_s state;
+  IQS7222C_MEMORY_MAP memory_map;
+
+  /* Shadow of the writable registers */
+  uint8_t shadow[IQS7222C_SHADOW_BYTES];
+  uint32_t shadow_dirty[IQS7222C_SHADOW_DIRTY_WORDS];
+  bool shadow_valid;
+
+  /* Init sequence */
+  iqs7222c_init_stats_t init_stats;
+  bool config_checked;
+  uint16_t config_offset; /* next read back burst of IQS7222C_INIT_VERIFY_CONFIG */
+  uint32_t init_start_us;
+  bool init_timer_armed;
+  volatile bool init_timer_expired;
+  i2c_touch_timer_t timer;
+
+  /* Asynchronous status reads */
+  volatile bool async_updates;
+  iqs7222c_update_handler_t async_handler;
+  uint8_t async_bytes[IQS7222C_STATUS_MAX_BYTES];
+  uint8_t async_length;
+
+  /* Per window read plan */
+  uint8_t read_mode;        /* iqs7222c_read_mode_e */
+  uint8_t read_blocks;      /* IQS7222C_READ_* */
+  uint8_t follow_up_blocks; /* IQS7222C_READ_EVENTS_FIRST, for the forced window */
+  iqs7222c_read_stats_t read_stats;
+
+#if IQS7222C_LATENCY_STATS
+  iqs7222c_latency_hist_t latency[IQS7222C_LATENCY_STAGES];
+#endif
+
+  /* RDY window servicing. rdy_edges is written by the interrupt only,
+   * serviced_edges is its value at the last serviced window. */
+  iqs7222c_window_stats_t window_stats;
+  volatile uint32_t rdy_edges;
+  uint32_t serviced_edges;
+  volatile bool overrun;
+  iqs7222c_overrun_handler_t overrun_handler;
+  void *overrun_context;
+
+  /* Bus traffic per operation class */
+  iqs7222c_bus_stats_t bus_stats;
+  uint32_t async_start_us;
+
+  /* Decoded event queue. Single producer (the context that decodes the
+   * status burst), single consumer (iqs7222c_readEvents), free running
+   * indices each written by one side only. */
+  iqs7222c_event_t events[IQS7222C_EVENT_QUEUE_SIZE];
+  volatile uint32_t event_head;
+  volatile uint32_t event_tail;
+  iqs7222c_event_stats_t event_stats;
+  volatile uint32_t rdy_time_us;
+  uint32_t window_time_us; /* rdy_time_us of the window being decoded */
+  uint16_t last_touch_states;
+  uint16_t last_prox_states;
+  uint16_t last_slider0;
+  uint16_t last_slider1;
+  uint8_t last_info_flags;
+
+  /* Published frames. frame_seq is odd while the decoder writes the back
+   * buffer, frames[(frame_seq >> 1) & 1] is the front one. */
+  iqs7222c_frame_t frames[2];
+  volatile uint32_t frame_seq;
+
+  /* Event subscribers, types is the union of their masks */
+  iqs7222c_subscriber_t subscribers[IQS7222C_MAX_SUBSCRIBERS];
+  uint8_t subscriber_count;
+  uint8_t subscriber_types;
+};
 
 // Public Methods
-bool iqs7222c_begin(uint8_t deviceAddressIn, uint8_t readyPinIn,
-                    const nrf_drv_twi_t *m_twi);
-bool iqs7222c_init(void);
-void iqs7222c_run(void);
-void iqs7222c_queueValueUpdates(void);
-bool iqs7222c_waitForReady(void);
-uint16_t iqs7222c_getProductNum(bool stopOrRestart);
-uint8_t iqs7222c_getmajorVersion(bool stopOrRestart);
-uint8_t iqs7222c_getminorVersion(bool stopOrRestart);
-void iqs7222c_acknowledgeReset(bool stopOrRestart);
-void iqs7222c_TP_ReATI(bool stopOrRestart);
-void iqs7222c_reSeed(bool stopOrRestart);
-void iqs7222c_SW_Reset(bool stopOrRestart);
-int iqs7222c_writeMM(bool stopOrRestart);
-
-void iqs7222c_setStreamMode(bool stopOrRestart);
-void iqs7222c_setEventMode(bool stopOrRestart);
-void iqs7222c_setStreamInTouch(bool stopOrRestart);
-
-void iqs7222c_updateInfoFlags(bool stopOrRestart);
-IQS7222C_power_modes iqs7222c_get_PowerMode(void);
-bool iqs7222c_checkReset(void);
-
-bool iqs7222c_channel_touchState(IQS7222C_Channel_e channel);
-bool iqs7222c_channel_proxState(IQS7222C_Channel_e channel);
-uint16_t iqs7222c_silderCoordinate(IQS7222C_slider_e slider);
-
-void iqs7222c_force_I2C_communication(void);
-uint8_t iqs7222c_getTouchStateByte(void);
-bool iqs7222c_isNewDataAvailable(void);
-
-uint8_t iqs7222c_getTouchByte(bool stopOrRestart);
-
-int iqs7222c_getCounts(bool stopOrRestart);
-int iqs7222c_getLta(bool stopOrRestart);
+bool iqs7222c_begin(iqs7222c_t *dev, uint8_t deviceAddressIn, uint8_t readyPinIn,
+                    const i2c_touch_bus_t *m_twi);
+bool iqs7222c_beginBackend(iqs7222c_t *dev, uint8_t deviceAddressIn, uint8_t readyPinIn,
+                           const i2c_touch_backend_t *backend, void *context);
+bool iqs7222c_init(iqs7222c_t *dev);
+iqs7222c_init_stats_t iqs7222c_getInitStats(iqs7222c_t *dev);
+void iqs7222c_run(iqs7222c_t *dev);
+void iqs7222c_queueValueUpdates(iqs7222c_t *dev);
+void iqs7222c_startAsyncUpdates(iqs7222c_t *dev, iqs7222c_update_handler_t handler);
+void iqs7222c_stopAsyncUpdates(iqs7222c_t *dev);
+void iqs7222c_setReadPlan(iqs7222c_t *dev, iqs7222c_read_mode_e mode, uint8_t blocks);
+iqs7222c_read_stats_t iqs7222c_getReadStats(iqs7222c_t *dev);
+iqs7222c_latency_t iqs7222c_getLatency(iqs7222c_t *dev, iqs7222c_latency_stage_e stage);
+void iqs7222c_resetLatency(iqs7222c_t *dev);
+iqs7222c_bus_stats_t iqs7222c_getBusStats(iqs7222c_t *dev);
+void iqs7222c_resetBusStats(iqs7222c_t *dev);
+iqs7222c_window_stats_t iqs7222c_getWindowStats(iqs7222c_t *dev);
+void iqs7222c_resetWindowStats(iqs7222c_t *dev);
+uint32_t iqs7222c_getCommsTimeoutUs(const iqs7222c_t *dev);
+void iqs7222c_setOverrunHandler(iqs7222c_t *dev, iqs7222c_overrun_handler_t handler,
+                                void *p_context);
+uint32_t iqs7222c_readEvents(iqs7222c_t *dev, iqs7222c_event_t *events, uint32_t maxEvents);
+uint32_t iqs7222c_eventsPending(iqs7222c_t *dev);
+iqs7222c_event_stats_t iqs7222c_getEventStats(iqs7222c_t *dev);
+bool iqs7222c_subscribe(iqs7222c_t *dev, uint8_t types, uint16_t channels,
+                        iqs7222c_event_handler_t handler, void *p_context);
+void iqs7222c_unsubscribe(iqs7222c_t *dev, iqs7222c_event_handler_t handler, void *p_context);
+bool iqs7222c_waitForReady(iqs7222c_t *dev);
+uint16_t iqs7222c_getProductNum(iqs7222c_t *dev, bool stopOrRestart);
+uint8_t iqs7222c_getmajorVersion(iqs7222c_t *dev, bool stopOrRestart);
+uint8_t iqs7222c_getminorVersion(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_acknowledgeReset(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_TP_ReATI(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_reSeed(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_setControlBits(iqs7222c_t *dev, uint8_t controlBits, bool stopOrRestart);
+int iqs7222c_SW_Reset(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_writeMM(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_setConfig(iqs7222c_t *dev, uint16_t memoryAddress, bool extended,
+                       const uint8_t bytesArray[], uint8_t numBytes);
+uint16_t iqs7222c_planConfig(iqs7222c_t *dev, iqs7222c_burst_t *bursts, uint16_t maxBursts);
+int iqs7222c_flushConfig(iqs7222c_t *dev, bool stopOrRestart);
+
+void iqs7222c_setStreamMode(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_setEventMode(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_setStreamInTouch(iqs7222c_t *dev, bool stopOrRestart);
+
+void iqs7222c_updateInfoFlags(iqs7222c_t *dev, bool stopOrRestart);
+IQS7222C_power_modes iqs7222c_get_PowerMode(iqs7222c_t *dev);
+bool iqs7222c_checkReset(iqs7222c_t *dev);
+
+bool iqs7222c_channel_touchState(iqs7222c_t *dev, IQS7222C_Channel_e channel);
+bool iqs7222c_channel_proxState(iqs7222c_t *dev, IQS7222C_Channel_e channel);
+uint16_t iqs7222c_silderCoordinate(iqs7222c_t *dev, IQS7222C_slider_e slider);
+uint16_t iqs7222c_wheelResolution(iqs7222c_t *dev, IQS7222C_slider_e slider);
+uint16_t iqs7222c_touchMask(iqs7222c_t *dev);
+uint16_t iqs7222c_proxMask(iqs7222c_t *dev);
+iqs7222c_channel_masks_t iqs7222c_getChannelMasks(iqs7222c_t *dev);
+uint32_t iqs7222c_readFrame(iqs7222c_t *dev, iqs7222c_frame_t *frame);
+
+/* Lowest set channel of *mask, which is then cleared from it. *mask must not
+ * be 0:
+ *   for (uint16_t m = iqs7222c_touchMask(dev); m != 0;)
+ *   {
+ *     uint8_t channel = iqs7222c_nextChannel(&m);
+ *   }
+ */
+static inline uint8_t iqs7222c_nextChannel(uint16_t *mask)
+{
+  uint8_t channel = (uint8_t)__builtin_ctz(*mask);
+  *mask &= (uint16_t)(*mask - 1u);
+  return channel;
+}
+
+void iqs7222c_force_I2C_communication(iqs7222c_t *dev);
+uint8_t iqs7222c_getTouchStateByte(iqs7222c_t *dev);
+bool iqs7222c_isNewDataAvailable(iqs7222c_t *dev);
+
+uint8_t iqs7222c_getTouchByte(iqs7222c_t *dev, bool stopOrRestart);
+
+int iqs7222c_getCounts(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_getLta(iqs7222c_t *dev, bool stopOrRestart);
+int iqs7222c_readTelemetry(iqs7222c_t *dev, iqs7222c_telemetry_t *telemetry, bool stopOrRestart);
+void iqs7222c_getTelemetry(iqs7222c_t *dev, iqs7222c_telemetry_t *telemetry);
 
 #endif // IQS7222C_h
@@ -98,6 +98,11 @@
 #define IQS7222C_MM_SLIDER_SETUP_0       	  0xB000
 #define IQS7222C_MM_SLIDER_SETUP_1          0xB100
 
+/* Wheel enable bit of the setup 0 lsb (slider_0_wheel_en in
+ * IQS7222C_SLIDER_SETUP) and the resolution word of each setup block */
+#define IQS7222C_SLIDER_WHEEL_ENABLE        0x08
+#define IQS7222C_SLIDER_RESOLUTION_WORD     3
+
 /* GPIO SETTINGS: 0xC0 */
 #define IQS7222C_MM_GPIO_0_SETTINGS	        0xC000
 #define IQS7222C_MM_GPIO_1_SETTINGS	        0xC100
@@ -0,0 +1,417 @@
+/** @file iqs7222c_config.h
+ *
+ * @brief Register layout of the IQS7222C_init.h configuration.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef IQS7222C_CONFIG_H
+#define IQS7222C_CONFIG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+#include "IQS7222C_init.h"
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+
+/* Every byte written by iqs7222c_writeMM, in address order, with its offset in
+ * the register shadow. X(offset, value) is a byte the device keeps as written,
+ * A(offset, value) one that changes at run time: the ATI multipliers and
+ * compensation, and the control settings changed after init. */
+
+/* Cycle setup 0 - 4 and global cycle setup, 0x8000 - 0x8502 */
+#define IQS7222C_CONFIG_CYCLE_SETUP(X, A) \
+  X(0, CYCLE_0_CONV_FREQ_FRAC) \
+  X(1, CYCLE_0_CONV_FREQ_PERIOD) \
+  X(2, CYCLE_0_SETTINGS) \
+  X(3, CYCLE_0_CTX_SELECT) \
+  X(4, CYCLE_0_IREF_0) \
+  X(5, CYCLE_0_IREF_1) \
+  X(6, CYCLE_1_CONV_FREQ_FRAC) \
+  X(7, CYCLE_1_CONV_FREQ_PERIOD) \
+  X(8, CYCLE_1_SETTINGS) \
+  X(9, CYCLE_1_CTX_SELECT) \
+  X(10, CYCLE_1_IREF_0) \
+  X(11, CYCLE_1_IREF_1) \
+  X(12, CYCLE_2_CONV_FREQ_FRAC) \
+  X(13, CYCLE_2_CONV_FREQ_PERIOD) \
+  X(14, CYCLE_2_SETTINGS) \
+  X(15, CYCLE_2_CTX_SELECT) \
+  X(16, CYCLE_2_IREF_0) \
+  X(17, CYCLE_2_IREF_1) \
+  X(18, CYCLE_3_CONV_FREQ_FRAC) \
+  X(19, CYCLE_3_CONV_FREQ_PERIOD) \
+  X(20, CYCLE_3_SETTINGS) \
+  X(21, CYCLE_3_CTX_SELECT) \
+  X(22, CYCLE_3_IREF_0) \
+  X(23, CYCLE_3_IREF_1) \
+  X(24, CYCLE_4_CONV_FREQ_FRAC) \
+  X(25, CYCLE_4_CONV_FREQ_PERIOD) \
+  X(26, CYCLE_4_SETTINGS) \
+  X(27, CYCLE_4_CTX_SELECT) \
+  X(28, CYCLE_4_IREF_0) \
+  X(29, CYCLE_4_IREF_1) \
+  X(30, GLOBAL_CYCLE_SETUP_0) \
+  X(31, GLOBAL_CYCLE_SETUP_1) \
+  X(32, COARSE_DIVIDER_PRELOAD) \
+  X(33, FINE_DIVIDER_PRELOAD) \
+  X(34, COMPENSATION_PRELOAD_0) \
+  X(35, COMPENSATION_PRELOAD_1)
+
+/* Button setup 0 - 9, 0x9000 - 0x9902 */
+#define IQS7222C_CONFIG_BUTTON_SETUP(X, A) \
+  X(36, BUTTON_0_PROX_THRESHOLD) \
+  X(37, BUTTON_0_ENTER_EXIT) \
+  X(38, BUTTON_0_TOUCH_THRESHOLD) \
+  X(39, BUTTON_0_TOUCH_HYSTERESIS) \
+  X(40, BUTTON_0_PROX_EVENT_TIMEOUT) \
+  X(41, BUTTON_0_TOUCH_EVENT_TIMEOUT) \
+  X(42, BUTTON_1_PROX_THRESHOLD) \
+  X(43, BUTTON_1_ENTER_EXIT) \
+  X(44, BUTTON_1_TOUCH_THRESHOLD) \
+  X(45, BUTTON_1_TOUCH_HYSTERESIS) \
+  X(46, BUTTON_1_PROX_EVENT_TIMEOUT) \
+  X(47, BUTTON_1_TOUCH_EVENT_TIMEOUT) \
+  X(48, BUTTON_2_PROX_THRESHOLD) \
+  X(49, BUTTON_2_ENTER_EXIT) \
+  X(50, BUTTON_2_TOUCH_THRESHOLD) \
+  X(51, BUTTON_2_TOUCH_HYSTERESIS) \
+  X(52, BUTTON_2_PROX_EVENT_TIMEOUT) \
+  X(53, BUTTON_2_TOUCH_EVENT_TIMEOUT) \
+  X(54, BUTTON_3_PROX_THRESHOLD) \
+  X(55, BUTTON_3_ENTER_EXIT) \
+  X(56, BUTTON_3_TOUCH_THRESHOLD) \
+  X(57, BUTTON_3_TOUCH_HYSTERESIS) \
+  X(58, BUTTON_3_PROX_EVENT_TIMEOUT) \
+  X(59, BUTTON_3_TOUCH_EVENT_TIMEOUT) \
+  X(60, BUTTON_4_PROX_THRESHOLD) \
+  X(61, BUTTON_4_ENTER_EXIT) \
+  X(62, BUTTON_4_TOUCH_THRESHOLD) \
+  X(63, BUTTON_4_TOUCH_HYSTERESIS) \
+  X(64, BUTTON_4_PROX_EVENT_TIMEOUT) \
+  X(65, BUTTON_4_TOUCH_EVENT_TIMEOUT) \
+  X(66, BUTTON_5_PROX_THRESHOLD) \
+  X(67, BUTTON_5_ENTER_EXIT) \
+  X(68, BUTTON_5_TOUCH_THRESHOLD) \
+  X(69, BUTTON_5_TOUCH_HYSTERESIS) \
+  X(70, BUTTON_5_PROX_EVENT_TIMEOUT) \
+  X(71, BUTTON_5_TOUCH_EVENT_TIMEOUT) \
+  X(72, BUTTON_6_PROX_THRESHOLD) \
+  X(73, BUTTON_6_ENTER_EXIT) \
+  X(74, BUTTON_6_TOUCH_THRESHOLD) \
+  X(75, BUTTON_6_TOUCH_HYSTERESIS) \
+  X(76, BUTTON_6_PROX_EVENT_TIMEOUT) \
+  X(77, BUTTON_6_TOUCH_EVENT_TIMEOUT) \
+  X(78, BUTTON_7_PROX_THRESHOLD) \
+  X(79, BUTTON_7_ENTER_EXIT) \
+  X(80, BUTTON_7_TOUCH_THRESHOLD) \
+  X(81, BUTTON_7_TOUCH_HYSTERESIS) \
+  X(82, BUTTON_7_PROX_EVENT_TIMEOUT) \
+  X(83, BUTTON_7_TOUCH_EVENT_TIMEOUT) \
+  X(84, BUTTON_8_PROX_THRESHOLD) \
+  X(85, BUTTON_8_ENTER_EXIT) \
+  X(86, BUTTON_8_TOUCH_THRESHOLD) \
+  X(87, BUTTON_8_TOUCH_HYSTERESIS) \
+  X(88, BUTTON_8_PROX_EVENT_TIMEOUT) \
+  X(89, BUTTON_8_TOUCH_EVENT_TIMEOUT) \
+  X(90, BUTTON_9_PROX_THRESHOLD) \
+  X(91, BUTTON_9_ENTER_EXIT) \
+  X(92, BUTTON_9_TOUCH_THRESHOLD) \
+  X(93, BUTTON_9_TOUCH_HYSTERESIS) \
+  X(94, BUTTON_9_PROX_EVENT_TIMEOUT) \
+  X(95, BUTTON_9_TOUCH_EVENT_TIMEOUT)
+
+/* Channel setup 0 - 9, 0xA000 - 0xA905 */
+#define IQS7222C_CONFIG_CHANNEL_SETUP(X, A) \
+  X(96, CH0_SETUP_0) \
+  X(97, CH0_SETUP_1) \
+  X(98, CH0_ATI_SETTINGS_0) \
+  X(99, CH0_ATI_SETTINGS_1) \
+  A(100, CH0_MULTIPLIERS_0) \
+  A(101, CH0_MULTIPLIERS_1) \
+  A(102, CH0_ATI_COMPENSATION_0) \
+  A(103, CH0_ATI_COMPENSATION_1) \
+  X(104, CH0_REF_PTR_0) \
+  X(105, CH0_REF_PTR_1) \
+  X(106, CH0_REFMASK_0) \
+  X(107, CH0_REFMASK_1) \
+  X(108, CH1_SETUP_0) \
+  X(109, CH1_SETUP_1) \
+  X(110, CH1_ATI_SETTINGS_0) \
+  X(111, CH1_ATI_SETTINGS_1) \
+  A(112, CH1_MULTIPLIERS_0) \
+  A(113, CH1_MULTIPLIERS_1) \
+  A(114, CH1_ATI_COMPENSATION_0) \
+  A(115, CH1_ATI_COMPENSATION_1) \
+  X(116, CH1_REF_PTR_0) \
+  X(117, CH1_REF_PTR_1) \
+  X(118, CH1_REFMASK_0) \
+  X(119, CH1_REFMASK_1) \
+  X(120, CH2_SETUP_0) \
+  X(121, CH2_SETUP_1) \
+  X(122, CH2_ATI_SETTINGS_0) \
+  X(123, CH2_ATI_SETTINGS_1) \
+  A(124, CH2_MULTIPLIERS_0) \
+  A(125, CH2_MULTIPLIERS_1) \
+  A(126, CH2_ATI_COMPENSATION_0) \
+  A(127, CH2_ATI_COMPENSATION_1) \
+  X(128, CH2_REF_PTR_0) \
+  X(129, CH2_REF_PTR_1) \
+  X(130, CH2_REFMASK_0) \
+  X(131, CH2_REFMASK_1) \
+  X(132, CH3_SETUP_0) \
+  X(133, CH3_SETUP_1) \
+  X(134, CH3_ATI_SETTINGS_0) \
+  X(135, CH3_ATI_SETTINGS_1) \
+  A(136, CH3_MULTIPLIERS_0) \
+  A(137, CH3_MULTIPLIERS_1) \
+  A(138, CH3_ATI_COMPENSATION_0) \
+  A(139, CH3_ATI_COMPENSATION_1) \
+  X(140, CH3_REF_PTR_0) \
+  X(141, CH3_REF_PTR_1) \
+  X(142, CH3_REFMASK_0) \
+  X(143, CH3_REFMASK_1) \
+  X(144, CH4_SETUP_0) \
+  X(145, CH4_SETUP_1) \
+  X(146, CH4_ATI_SETTINGS_0) \
+  X(147, CH4_ATI_SETTINGS_1) \
+  A(148, CH4_MULTIPLIERS_0) \
+  A(149, CH4_MULTIPLIERS_1) \
+  A(150, CH4_ATI_COMPENSATION_0) \
+  A(151, CH4_ATI_COMPENSATION_1) \
+  X(152, CH4_REF_PTR_0) \
+  X(153, CH4_REF_PTR_1) \
+  X(154, CH4_REFMASK_0) \
+  X(155, CH4_REFMASK_1) \
+  X(156, CH5_SETUP_0) \
+  X(157, CH5_SETUP_1) \
+  X(158, CH5_ATI_SETTINGS_0) \
+  X(159, CH5_ATI_SETTINGS_1) \
+  A(160, CH5_MULTIPLIERS_0) \
+  A(161, CH5_MULTIPLIERS_1) \
+  A(162, CH5_ATI_COMPENSATION_0) \
+  A(163, CH5_ATI_COMPENSATION_1) \
+  X(164, CH5_REF_PTR_0) \
+  X(165, CH5_REF_PTR_1) \
+  X(166, CH5_REFMASK_0) \
+  X(167, CH5_REFMASK_1) \
+  X(168, CH6_SETUP_0) \
+  X(169, CH6_SETUP_1) \
+  X(170, CH6_ATI_SETTINGS_0) \
+  X(171, CH6_ATI_SETTINGS_1) \
+  A(172, CH6_MULTIPLIERS_0) \
+  A(173, CH6_MULTIPLIERS_1) \
+  A(174, CH6_ATI_COMPENSATION_0) \
+  A(175, CH6_ATI_COMPENSATION_1) \
+  X(176, CH6_REF_PTR_0) \
+  X(177, CH6_REF_PTR_1) \
+  X(178, CH6_REFMASK_0) \
+  X(179, CH6_REFMASK_1) \
+  X(180, CH7_SETUP_0) \
+  X(181, CH7_SETUP_1) \
+  X(182, CH7_ATI_SETTINGS_0) \
+  X(183, CH7_ATI_SETTINGS_1) \
+  A(184, CH7_MULTIPLIERS_0) \
+  A(185, CH7_MULTIPLIERS_1) \
+  A(186, CH7_ATI_COMPENSATION_0) \
+  A(187, CH7_ATI_COMPENSATION_1) \
+  X(188, CH7_REF_PTR_0) \
+  X(189, CH7_REF_PTR_1) \
+  X(190, CH7_REFMASK_0) \
+  X(191, CH7_REFMASK_1) \
+  X(192, CH8_SETUP_0) \
+  X(193, CH8_SETUP_1) \
+  X(194, CH8_ATI_SETTINGS_0) \
+  X(195, CH8_ATI_SETTINGS_1) \
+  A(196, CH8_MULTIPLIERS_0) \
+  A(197, CH8_MULTIPLIERS_1) \
+  A(198, CH8_ATI_COMPENSATION_0) \
+  A(199, CH8_ATI_COMPENSATION_1) \
+  X(200, CH8_REF_PTR_0) \
+  X(201, CH8_REF_PTR_1) \
+  X(202, CH8_REFMASK_0) \
+  X(203, CH8_REFMASK_1) \
+  X(204, CH9_SETUP_0) \
+  X(205, CH9_SETUP_1) \
+  X(206, CH9_ATI_SETTINGS_0) \
+  X(207, CH9_ATI_SETTINGS_1) \
+  A(208, CH9_MULTIPLIERS_0) \
+  A(209, CH9_MULTIPLIERS_1) \
+  A(210, CH9_ATI_COMPENSATION_0) \
+  A(211, CH9_ATI_COMPENSATION_1) \
+  X(212, CH9_REF_PTR_0) \
+  X(213, CH9_REF_PTR_1) \
+  X(214, CH9_REFMASK_0) \
+  X(215, CH9_REFMASK_1)
+
+/* Filter betas, 0xAA00 - 0xAA01 */
+#define IQS7222C_CONFIG_FILTER_BETAS(X, A) \
+  X(216, COUNTS_BETA_FILTER) \
+  X(217, LTA_BETA_FILTER) \
+  X(218, LTA_FAST_BETA_FILTER) \
+  X(219, RESERVED_FILTER_0)
+
+/* Slider/wheel setup 0 - 1, 0xB000 - 0xB109 */
+#define IQS7222C_CONFIG_SLIDER_SETUP(X, A) \
+  X(220, SLIDER0SETUP_GENERAL) \
+  X(221, SLIDER0_LOWER_CAL) \
+  X(222, SLIDER0_UPPER_CAL) \
+  X(223, SLIDER0_BOTTOM_SPEED) \
+  X(224, SLIDER0_TOPSPEED_0) \
+  X(225, SLIDER0_TOPSPEED_1) \
+  X(226, SLIDER0_RESOLUTION_0) \
+  X(227, SLIDER0_RESOLUTION_1) \
+  X(228, SLIDER0_ENABLE_MASK_0_7) \
+  X(229, SLIDER0_ENABLE_MASK_8_9) \
+  X(230, SLIDER0_ENABLESTATUSLINK_0) \
+  X(231, SLIDER0_ENABLESTATUSLINK_1) \
+  X(232, SLIDER0_DELTA0_0) \
+  X(233, SLIDER0_DELTA0_1) \
+  X(234, SLIDER0_DELTA1_0) \
+  X(235, SLIDER0_DELTA1_1) \
+  X(236, SLIDER0_DELTA2_0) \
+  X(237, SLIDER0_DELTA2_1) \
+  X(238, SLIDER0_DELTA3_0) \
+  X(239, SLIDER0_DELTA3_1) \
+  X(240, SLIDER1SETUP_GENERAL) \
+  X(241, SLIDER1_LOWER_CAL) \
+  X(242, SLIDER1_UPPER_CAL) \
+  X(243, SLIDER1_BOTTOM_SPEED) \
+  X(244, SLIDER1_TOPSPEED_0) \
+  X(245, SLIDER1_TOPSPEED_1) \
+  X(246, SLIDER1_RESOLUTION_0) \
+  X(247, SLIDER1_RESOLUTION_1) \
+  X(248, SLIDER1_ENABLE_MASK_0_7) \
+  X(249, SLIDER1_ENABLE_MASK_8_9) \
+  X(250, SLIDER1_ENABLESTATUSLINK_0) \
+  X(251, SLIDER1_ENABLESTATUSLINK_1) \
+  X(252, SLIDER1_DELTA0_0) \
+  X(253, SLIDER1_DELTA0_1) \
+  X(254, SLIDER1_DELTA1_0) \
+  X(255, SLIDER1_DELTA1_1) \
+  X(256, SLIDER1_DELTA2_0) \
+  X(257, SLIDER1_DELTA2_1) \
+  X(258, SLIDER1_DELTA3_0) \
+  X(259, SLIDER1_DELTA3_1)
+
+#if IQS7222C_v1_13
+/* GPIO 0 settings, 0xC000 - 0xC002 */
+#define IQS7222C_CONFIG_GPIO_SETUP(X, A) \
+  X(260, GPIO0_SETUP_0) \
+  X(261, GPIO0_SETUP_1) \
+  X(262, ENABLE_MASK_0_7) \
+  X(263, ENABLE_MASK_8_9) \
+  X(264, ENABLESTATUSLINK_0) \
+  X(265, ENABLESTATUSLINK_1)
+
+#elif IQS7222C_v2_6 || IQS7222C_v2_23
+/* GPIO settings 0 - 2, 0xC000 - 0xC202 */
+#define IQS7222C_CONFIG_GPIO_SETUP(X, A) \
+  X(260, GPIO0_SETUP_0) \
+  X(261, GPIO0_SETUP_1) \
+  X(262, GPIO0_ENABLE_MASK_0_7) \
+  X(263, GPIO0_ENABLE_MASK_8_9) \
+  X(264, GPIO0_ENABLESTATUSLINK_0) \
+  X(265, GPIO0_ENABLESTATUSLINK_1) \
+  X(266, GPIO1_SETUP_0) \
+  X(267, GPIO1_SETUP_1) \
+  X(268, GPIO1_ENABLE_MASK_0_7) \
+  X(269, GPIO1_ENABLE_MASK_8_9) \
+  X(270, GPIO1_ENABLESTATUSLINK_0) \
+  X(271, GPIO1_ENABLESTATUSLINK_1) \
+  X(272, GPIO2_SETUP_0) \
+  X(273, GPIO2_SETUP_1) \
+  X(274, GPIO2_ENABLE_MASK_0_7) \
+  X(275, GPIO2_ENABLE_MASK_8_9) \
+  X(276, GPIO2_ENABLESTATUSLINK_0) \
+  X(277, GPIO2_ENABLESTATUSLINK_1)
+
+#endif
+
+/* PMU & system settings, 0xD0 - 0xDA low byte */
+#define IQS7222C_CONFIG_SYSTEM_SETUP(X, A) \
+  A(278, SYSTEM_CONTROL_0) \
+  A(279, SYSTEM_CONTROL_1) \
+  X(280, ATI_ERROR_TIMEOUT_0) \
+  X(281, ATI_ERROR_TIMEOUT_1) \
+  X(282, ATI_REPORT_RATE_0) \
+  X(283, ATI_REPORT_RATE_1) \
+  X(284, NORMAL_MODE_TIMEOUT_0) \
+  X(285, NORMAL_MODE_TIMEOUT_1) \
+  X(286, NORMAL_MODE_REPORT_RATE_0) \
+  X(287, NORMAL_MODE_REPORT_RATE_1) \
+  X(288, LP_MODE_TIMEOUT_0) \
+  X(289, LP_MODE_TIMEOUT_1) \
+  X(290, LP_MODE_REPORT_RATE_0) \
+  X(291, LP_MODE_REPORT_RATE_1) \
+  X(292, ULP_MODE_TIMEOUT_0) \
+  X(293, ULP_MODE_TIMEOUT_1) \
+  X(294, ULP_MODE_REPORT_RATE_0) \
+  X(295, ULP_MODE_REPORT_RATE_1) \
+  X(296, TOUCH_PROX_EVENT_MASK) \
+  X(297, POWER_ATI_EVENT_MASK) \
+  X(298, I2CCOMMS_0)
+
+#if IQS7222C_v2_6 || IQS7222C_v2_23
+/* GPIO override, 0xDB low byte */
+#define IQS7222C_CONFIG_GPIO_OVERRIDE(X, A) \
+  X(300, GPIO_OVERRIDE)
+#else
+#define IQS7222C_CONFIG_GPIO_OVERRIDE(X, A)
+#endif
+
+#if IQS7222C_v2_23
+/* Comms timeout, 0xDC */
+#define IQS7222C_CONFIG_COMMS_TIMEOUT(X, A) \
+  X(302, COMMS_TIMEOUT_0) \
+  X(303, COMMS_TIMEOUT_1)
+#else
+#define IQS7222C_CONFIG_COMMS_TIMEOUT(X, A)
+#endif
+
+#define IQS7222C_CONFIG_ALL(X, A) \
+  IQS7222C_CONFIG_CYCLE_SETUP(X, A) \
+  IQS7222C_CONFIG_BUTTON_SETUP(X, A) \
+  IQS7222C_CONFIG_CHANNEL_SETUP(X, A) \
+  IQS7222C_CONFIG_FILTER_BETAS(X, A) \
+  IQS7222C_CONFIG_SLIDER_SETUP(X, A) \
+  IQS7222C_CONFIG_GPIO_SETUP(X, A) \
+  IQS7222C_CONFIG_SYSTEM_SETUP(X, A) \
+  IQS7222C_CONFIG_GPIO_OVERRIDE(X, A) \
+  IQS7222C_CONFIG_COMMS_TIMEOUT(X, A)
+
+/* Fingerprint term of one byte. The weight is (offset + 1) times an odd
+ * constant, so a change of any single byte always changes the sum. */
+#define IQS7222C_CONFIG_FP_WEIGHT(offset, value) \
+  (((uint32_t)(value) + 1u) * (((uint32_t)(offset) + 1u) * 2654435761u))
+#define IQS7222C_CONFIG_FP_TERM(offset, value) +IQS7222C_CONFIG_FP_WEIGHT(offset, value)
+#define IQS7222C_CONFIG_FP_SKIP(offset, value)
+
+/* Fingerprint of the bytes the device keeps as written, evaluated at compile
+ * time and compared with the same sum over the registers read back from a
+ * device that did not reset. */
+#define IQS7222C_CONFIG_FINGERPRINT \
+  ((uint32_t)(0u IQS7222C_CONFIG_ALL(IQS7222C_CONFIG_FP_TERM, IQS7222C_CONFIG_FP_SKIP)))
+
+//----------------------------- DATA TYPES ------------------------------------
+
+/* One write of the configuration image, streamed from flash by
+ * iqs7222c_writeMM */
+typedef struct {
+  uint16_t address; /* register address, 8 bit unless extended */
+  bool extended;
+  uint8_t length;
+  const uint8_t *bytes;
+} iqs7222c_config_burst_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IQS7222C_CONFIG_H
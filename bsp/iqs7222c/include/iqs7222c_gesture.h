@@ -0,0 +1,99 @@
+/** @file iqs7222c_gesture.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef IQS7222C_GESTURE_H
+#define IQS7222C_GESTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+/* A finger that rests this long before lifting has no fling velocity */
+#ifndef IQS7222C_GESTURE_REST_US
+#define IQS7222C_GESTURE_REST_US 50000u
+#endif
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef enum {
+  IQS7222C_GESTURE_TAP = (uint8_t)0x00,
+  IQS7222C_GESTURE_DOUBLE_TAP,
+  IQS7222C_GESTURE_HOLD,         /* still touched after hold_us */
+  IQS7222C_GESTURE_HOLD_RELEASE, /* lift after a hold */
+  IQS7222C_GESTURE_SWIPE,        /* lift after moving swipe_min or more */
+  IQS7222C_GESTURE_FLING,        /* a swipe lifted at fling_velocity or faster */
+} iqs7222c_gesture_type_e;
+
+typedef struct {
+  uint32_t timestamp_us; /* window that completed the gesture */
+  int32_t velocity;      /* swipe and fling, slider counts per second at lift */
+  int32_t distance;      /* swipe and fling, lift minus touch down coordinate */
+  uint16_t position;     /* touch down coordinate */
+  uint8_t type;          /* iqs7222c_gesture_type_e */
+  uint8_t slider;        /* IQS7222C_slider_e */
+} iqs7222c_gesture_event_t;
+
+typedef struct iqs7222c_gesture iqs7222c_gesture_t;
+
+/* Called from iqs7222c_gesture_update or iqs7222c_gesture_poll */
+typedef void (*iqs7222c_gesture_handler_t)(iqs7222c_gesture_t *gesture,
+                                           const iqs7222c_gesture_event_t *event,
+                                           void *p_context);
+
+/* Thresholds in microseconds and slider coordinate counts, see
+ * iqs7222c_gesture_default_config */
+typedef struct {
+  uint32_t tap_max_us;        /* longest touch that is a tap */
+  uint32_t double_tap_gap_us; /* longest lift between the taps of a double tap, 0 = no double tap */
+  uint32_t hold_us;           /* touch time before HOLD */
+  uint16_t move_max;          /* travel allowed for a tap or hold */
+  uint16_t swipe_min;         /* travel of a swipe */
+  uint32_t fling_velocity;    /* counts per second */
+} iqs7222c_gesture_config_t;
+
+/* Recognizer for one slider, a few words of state per slider */
+struct iqs7222c_gesture {
+  iqs7222c_gesture_config_t config;
+  uint8_t slider;
+  iqs7222c_gesture_handler_t handler;
+  void *p_context;
+
+  /* Private */
+  uint8_t state;
+  bool held;
+  bool second_tap; /* touch down within the double tap gap */
+  uint16_t down_position;
+  uint16_t last_position;
+  uint16_t tap_position;
+  uint32_t down_us;
+  uint32_t last_us;
+  uint32_t tap_us;   /* lift of the pending tap */
+  int32_t velocity;  /* smoothed, counts per second */
+};
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+void iqs7222c_gesture_default_config(iqs7222c_gesture_config_t *config, uint16_t resolution);
+void iqs7222c_gesture_init(iqs7222c_gesture_t *gesture, const iqs7222c_gesture_config_t *config,
+                           IQS7222C_slider_e slider, iqs7222c_gesture_handler_t handler,
+                           void *p_context);
+bool iqs7222c_gesture_attach(iqs7222c_gesture_t *gesture, iqs7222c_t *dev);
+void iqs7222c_gesture_detach(iqs7222c_gesture_t *gesture, iqs7222c_t *dev);
+void iqs7222c_gesture_update(iqs7222c_gesture_t *gesture, uint16_t position, uint32_t now_us);
+void iqs7222c_gesture_poll(iqs7222c_gesture_t *gesture, uint32_t now_us);
+uint32_t iqs7222c_gesture_next_us(const iqs7222c_gesture_t *gesture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IQS7222C_GESTURE_H
@@ -0,0 +1,74 @@
+/** @file iqs7222c_rec.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef IQS7222C_REC_H
+#define IQS7222C_REC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+/* Stream header: "IQR" and the format version */
+#define IQS7222C_REC_HEADER_BYTES 4
+#define IQS7222C_REC_VERSION 1
+
+/* Longest encoded frame */
+#define IQS7222C_REC_MAX_FRAME_BYTES 64
+
+//----------------------------- DATA TYPES ------------------------------------
+
+/* One recorded window */
+typedef struct {
+  uint32_t timestamp_us; /* RDY edge */
+  uint8_t info_flags;
+  uint16_t prox;
+  uint16_t touch;
+  uint16_t slider[2];
+  uint16_t counts[IQS7222C_CHANNELS];
+  uint16_t lta[IQS7222C_CHANNELS];
+} iqs7222c_rec_frame_t;
+
+/* Recorder writing into a caller owned buffer. Frames that no longer fit
+ * are dropped and counted. */
+typedef struct {
+  uint8_t *buffer;
+  uint32_t size;
+  uint32_t length; /* bytes used, header included */
+  uint32_t frames; /* frames recorded */
+  uint32_t dropped;
+  uint32_t last_seq; /* iqs7222c_readFrame number of the last capture */
+  uint32_t last_dt;
+  iqs7222c_rec_frame_t last;
+} iqs7222c_rec_t;
+
+typedef struct {
+  const uint8_t *buffer;
+  uint32_t length;
+  uint32_t pos;
+  uint32_t last_dt;
+  iqs7222c_rec_frame_t last;
+} iqs7222c_rec_reader_t;
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+bool iqs7222c_rec_init(iqs7222c_rec_t *rec, uint8_t *buffer, uint32_t size);
+bool iqs7222c_rec_add(iqs7222c_rec_t *rec, const iqs7222c_rec_frame_t *frame);
+bool iqs7222c_rec_capture(iqs7222c_rec_t *rec, iqs7222c_t *dev);
+bool iqs7222c_rec_reader_init(iqs7222c_rec_reader_t *reader, const uint8_t *buffer,
+                              uint32_t length);
+bool iqs7222c_rec_read(iqs7222c_rec_reader_t *reader, iqs7222c_rec_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IQS7222C_REC_H
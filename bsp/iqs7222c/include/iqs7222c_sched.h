@@ -0,0 +1,58 @@
+/** @file iqs7222c_sched.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef IQS7222C_SCHED_H
+#define IQS7222C_SCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+#ifndef IQS7222C_SCHED_MAX_DEVICES
+#define IQS7222C_SCHED_MAX_DEVICES 4
+#endif
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct {
+  uint32_t serviced;        /* windows read before their deadline */
+  uint32_t missed;          /* windows already timed out when reached, not read */
+  uint32_t commands;        /* queued control writes issued */
+  uint32_t max_lateness_us; /* longest RDY edge to start of service */
+} iqs7222c_sched_stats_t;
+
+typedef struct {
+  iqs7222c_t *dev;
+  uint8_t control_bits; /* written in the next window */
+  iqs7222c_sched_stats_t stats;
+} iqs7222c_sched_slot_t;
+
+/* Devices sharing one TWI bus. */
+typedef struct {
+  iqs7222c_sched_slot_t slots[IQS7222C_SCHED_MAX_DEVICES];
+  uint8_t count;
+} iqs7222c_sched_t;
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+void iqs7222c_sched_init(iqs7222c_sched_t *sched);
+bool iqs7222c_sched_add(iqs7222c_sched_t *sched, iqs7222c_t *dev);
+bool iqs7222c_sched_request(iqs7222c_sched_t *sched, iqs7222c_t *dev, uint8_t controlBits);
+uint8_t iqs7222c_sched_run(iqs7222c_sched_t *sched);
+const iqs7222c_sched_stats_t *iqs7222c_sched_stats(const iqs7222c_sched_t *sched,
+                                                   const iqs7222c_t *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IQS7222C_SCHED_H
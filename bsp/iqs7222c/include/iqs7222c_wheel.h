@@ -0,0 +1,79 @@
+/** @file iqs7222c_wheel.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef IQS7222C_WHEEL_H
+#define IQS7222C_WHEEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+/* A step older than this does not predict the next one */
+#ifndef IQS7222C_WHEEL_REST_US
+#define IQS7222C_WHEEL_REST_US 50000u
+#endif
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct {
+  uint32_t timestamp_us; /* window of the rotation */
+  int32_t detents;       /* detents crossed in this window, positive towards higher coordinates */
+  int32_t total;         /* detents since iqs7222c_wheel_init */
+  int32_t velocity;      /* counts per second over the last step */
+  uint8_t slider;        /* IQS7222C_slider_e */
+} iqs7222c_wheel_event_t;
+
+typedef struct iqs7222c_wheel iqs7222c_wheel_t;
+
+/* Called from iqs7222c_wheel_update for every window that crosses a detent */
+typedef void (*iqs7222c_wheel_handler_t)(iqs7222c_wheel_t *wheel, const iqs7222c_wheel_event_t *event,
+                                         void *p_context);
+
+/* see iqs7222c_wheel_default_config */
+typedef struct {
+  uint16_t range;             /* coordinate of one full turn, the slider resolution */
+  uint16_t counts_per_detent; /* coordinate travel of one detent */
+} iqs7222c_wheel_config_t;
+
+/* Unwrapped rotation of one slider set up as a wheel */
+struct iqs7222c_wheel {
+  iqs7222c_wheel_config_t config;
+  uint8_t slider;
+  iqs7222c_wheel_handler_t handler;
+  void *p_context;
+  int32_t position; /* unwrapped coordinate since iqs7222c_wheel_init */
+  int32_t total;    /* detents since iqs7222c_wheel_init */
+  int32_t velocity; /* counts per second, 0 while not touched */
+
+  /* Private */
+  bool touched;
+  uint16_t last_position;
+  uint32_t last_us;
+  int32_t last_step; /* of the previous window, predicts the next */
+  int32_t remainder; /* travel towards the next detent, |remainder| < counts_per_detent */
+};
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+void iqs7222c_wheel_default_config(iqs7222c_wheel_config_t *config, uint16_t range);
+void iqs7222c_wheel_init(iqs7222c_wheel_t *wheel, const iqs7222c_wheel_config_t *config,
+                         IQS7222C_slider_e slider, iqs7222c_wheel_handler_t handler,
+                         void *p_context);
+bool iqs7222c_wheel_attach(iqs7222c_wheel_t *wheel, iqs7222c_t *dev);
+void iqs7222c_wheel_detach(iqs7222c_wheel_t *wheel, iqs7222c_t *dev);
+int32_t iqs7222c_wheel_update(iqs7222c_wheel_t *wheel, uint16_t position, uint32_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IQS7222C_WHEEL_H
@@ -32,39 +32,162 @@
 #include "IQS7222C_init.h"
 #endif
 
+#include "iqs7222c_config.h"
 #include "i2c_touch.h"
-#include "nrf_drv_gpiote.h"
-#include "nrf_delay.h"
+#include <string.h>
 
+#if I2C_TOUCH_HOST
+#define NRF_LOG_INFO(...)
+#else
 #include <nrf_log.h>
 #include <nrf_log_ctrl.h>
 #include <nrf_log_default_backends.h>
+#endif
+
+#if (IQS7222C_EVENT_QUEUE_SIZE & (IQS7222C_EVENT_QUEUE_SIZE - 1)) != 0
+#error "IQS7222C_EVENT_QUEUE_SIZE must be a power of two"
+#endif
+#define EVENT_QUEUE_MASK (IQS7222C_EVENT_QUEUE_SIZE - 1)
+
+// Orders the event queue slot write against the index update. Compiles to a
+// DMB on Cortex-M.
+#define EVENT_QUEUE_BARRIER() __sync_synchronize()
+
+// Order the frame buffer accesses against the sequence counter: loads for
+// the reader, stores for the decoder. DMB on Cortex-M, free on x86. The
+// reader's can be replaced to publish frames in the middle of a copy, see
+// src/host/iqs7222c_frame_check.c.
+#ifndef FRAME_READ_BARRIER
+#define FRAME_READ_BARRIER() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+#define FRAME_WRITE_BARRIER() __atomic_thread_fence(__ATOMIC_RELEASE)
+
+// One word of the front frame. Aligned 16 bit loads are single copy atomic,
+// so the value always comes from one complete frame.
+#define FRAME_WORD(dev, field) \
+    (((volatile const iqs7222c_frame_t *)&(dev)->frames[((dev)->frame_seq >> 1) & 1u])->field)
+
+// Every read ends with a stop and so ends the window. A window that needs the
+// channel counts (0x20 - 0x29) or LTA (0x30 - 0x39) carries the status burst
+// on through them, offsets in bytes from IQS7222C_MM_INFOFLAGS.
+#define WINDOW_COUNTS_OFFSET ((IQS7222C_MM_CHANNEL_0_COUNTS - IQS7222C_MM_INFOFLAGS) * 2)
+#define WINDOW_LTA_OFFSET ((IQS7222C_MM_CHANNEL_0_LTA - IQS7222C_MM_INFOFLAGS) * 2)
+#define WINDOW_MAX_BYTES (WINDOW_LTA_OFFSET + 2 * IQS7222C_CHANNELS)
 
 /**************************************************************************************************************/
 /*                                              STATIC DATA & CONSTANTS */
 /**************************************************************************************************************/
-static bool iqs7222c_deviceRDY = false;
-static uint8_t _deviceAddress;
-static uint8_t _readyPin;
+//  Shadow of the writable registers. Extended setup blocks flattened in
+//  address order, followed by 0xD0 - 0xDC. Kept up to date by every write,
+//  valid once iqs7222c_writeMM succeeded and until a reset is detected.
+static const iqs7222c_shadow_block_t shadowBlocks[] = {
+    {0x80, 0x85, 3},  // cycle setup 0 - 4, global cycle setup
+    {0x90, 0x99, 3},  // button setup 0 - 9
+    {0xA0, 0xA9, 6},  // channel setup 0 - 9
+    {0xAA, 0xAA, 2},  // filter betas
+    {0xB0, 0xB1, 10}, // slider/wheel setup 0 - 1
+    {0xC0, 0xC2, 3},  // GPIO settings 0 - 2
+};
+
+//  Configuration image of IQS7222C_init.h, one flash resident array per
+//  address range. The length checks catch a layout that no longer matches
+//  the memory map.
+#define CONFIG_BYTE(offset, value) (uint8_t)(value),
+#define CONFIG_IMAGE(name, list, bytes)                                      \
+    static const uint8_t name[] = {list(CONFIG_BYTE, CONFIG_BYTE)};          \
+    typedef char name##_length_check[(sizeof(name) == (bytes)) ? 1 : -1]
+
+CONFIG_IMAGE(cycleSetupImage, IQS7222C_CONFIG_CYCLE_SETUP, 36);
+CONFIG_IMAGE(buttonSetupImage, IQS7222C_CONFIG_BUTTON_SETUP, 60);
+CONFIG_IMAGE(channelSetupImage, IQS7222C_CONFIG_CHANNEL_SETUP, 120);
+CONFIG_IMAGE(filterBetasImage, IQS7222C_CONFIG_FILTER_BETAS, 4);
+CONFIG_IMAGE(sliderSetupImage, IQS7222C_CONFIG_SLIDER_SETUP, 40);
+#if IQS7222C_v1_13
+CONFIG_IMAGE(gpioSetupImage, IQS7222C_CONFIG_GPIO_SETUP, 6);
+#else
+CONFIG_IMAGE(gpioSetupImage, IQS7222C_CONFIG_GPIO_SETUP, 18);
+#endif
+CONFIG_IMAGE(systemSetupImage, IQS7222C_CONFIG_SYSTEM_SETUP, 21);
+#if IQS7222C_v2_6 || IQS7222C_v2_23
+CONFIG_IMAGE(gpioOverrideImage, IQS7222C_CONFIG_GPIO_OVERRIDE, 1);
+#endif
+#if IQS7222C_v2_23
+CONFIG_IMAGE(commsTimeoutImage, IQS7222C_CONFIG_COMMS_TIMEOUT, 2);
+#endif
 
-//  Device States
-static iqs7222c_s iqs7222C_state;
-//  Variables
-static IQS7222C_MEMORY_MAP IQSMemoryMap;
-static bool new_data_available;
+static const iqs7222c_config_burst_t configImage[] = {
+    {IQS7222C_MM_CYCLE_SETUP_0, true, sizeof(cycleSetupImage), cycleSetupImage},
+    {IQS7222C_MM_BUTTON_SETUP_0, true, sizeof(buttonSetupImage), buttonSetupImage},
+    {IQS7222C_MM_CHANNEL_SETUP_0, true, sizeof(channelSetupImage), channelSetupImage},
+    {IQS7222C_MM_FILTER_BETAS, true, sizeof(filterBetasImage), filterBetasImage},
+    {IQS7222C_MM_SLIDER_SETUP_0, true, sizeof(sliderSetupImage), sliderSetupImage},
+    {IQS7222C_MM_GPIO_0_SETTINGS, true, sizeof(gpioSetupImage), gpioSetupImage},
+    {IQS7222C_MM_CONTROL_SETTINGS, false, sizeof(systemSetupImage), systemSetupImage},
+#if IQS7222C_v2_6 || IQS7222C_v2_23
+    {IQS7222C_MM_GPIO_OVERRIDE, false, sizeof(gpioOverrideImage), gpioOverrideImage},
+#endif
+#if IQS7222C_v2_23
+    {IQS7222C_MM_COMMS_TIMEOUT, false, sizeof(commsTimeoutImage), commsTimeoutImage},
+#endif
+};
 
-static nrf_drv_gpiote_in_config_t _pin_config_in = GPIOTE_CONFIG_IN_SENSE_TOGGLE(true);
+//  Shadow offsets covered by the configuration fingerprint.
+#define CONFIG_CHECK_OFFSET(offset, value) offset,
+static const uint16_t configCheckOffsets[] = {
+    IQS7222C_CONFIG_ALL(CONFIG_CHECK_OFFSET, IQS7222C_CONFIG_FP_SKIP)
+};
 
 /**************************************************************************************************************/
 /*                                             PRIVATE METHODS */
 /**************************************************************************************************************/
-void ready_interupt(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
-int readRandomBytes(uint8_t memoryAddress, uint8_t numBytes,
+void ready_interupt(uint32_t pin, void *p_context);
+int readRandomBytes(iqs7222c_t *dev, uint8_t memoryAddress, uint8_t numBytes,
                     uint8_t bytesArray[], bool stopOrRestart);
-int writeRandomBytes(uint8_t memoryAddress, uint8_t numBytes,
-                     uint8_t bytesArray[], bool stopOrRestart);
-int writeRandomBytes16(uint16_t memoryAddress, uint8_t numBytes,
-                       uint8_t bytesArray[], bool stopOrRestart);
+int readRandomBytes16(iqs7222c_t *dev, uint16_t memoryAddress, uint8_t numBytes,
+                      uint8_t bytesArray[], bool stopOrRestart);
+int writeRandomBytes(iqs7222c_t *dev, uint8_t memoryAddress, uint8_t numBytes,
+                     const uint8_t bytesArray[], bool stopOrRestart);
+int writeRandomBytes16(iqs7222c_t *dev, uint16_t memoryAddress, uint8_t numBytes,
+                       const uint8_t bytesArray[], bool stopOrRestart);
+static int shadowOffset(uint16_t memoryAddress, bool extended);
+static void shadowStore(iqs7222c_t *dev, uint16_t memoryAddress, bool extended, uint8_t numBytes,
+                        const uint8_t bytesArray[]);
+static bool dirtyTest(const iqs7222c_t *dev, uint16_t offset);
+static void dirtySet(iqs7222c_t *dev, uint16_t offset);
+static void dirtyClear(iqs7222c_t *dev, uint16_t offset);
+static uint16_t shadowAddress(uint16_t offset, bool *extended, uint16_t *rangeEnd);
+static bool planBurst(const iqs7222c_t *dev, uint16_t from, iqs7222c_burst_t *burst);
+static int readConfig(iqs7222c_t *dev);
+static uint32_t configFingerprint(const iqs7222c_t *dev);
+static int readControlSettings(iqs7222c_t *dev, uint8_t bytesArray[]);
+static bool initStep(iqs7222c_t *dev);
+static bool initWaitForWindow(iqs7222c_t *dev);
+static bool initWaitForTimer(iqs7222c_t *dev, uint32_t timeoutUs);
+static void initTimerHandler(void *p_context);
+static uint8_t planBlocks(const iqs7222c_t *dev, uint16_t events, uint16_t prox);
+static uint8_t statusLength(uint8_t blocks);
+static uint8_t windowLength(uint8_t blocks);
+static int readWindow(iqs7222c_t *dev, uint8_t memoryAddress, uint8_t numBytes,
+                      uint8_t bytesArray[], bool stopOrRestart);
+static void decodeStatus(iqs7222c_t *dev, const uint8_t transferBytes[], uint8_t numBytes);
+static void asyncUpdateDone(int result, void *p_context);
+static void publishFrame(iqs7222c_t *dev);
+static void latencyRecord(iqs7222c_t *dev, uint8_t stage);
+static void windowServiced(iqs7222c_t *dev);
+static void overrunNotify(iqs7222c_t *dev, bool overrun);
+static uint8_t busOp(uint16_t memoryAddress, bool extended, uint8_t numBytes);
+static void busAccount(iqs7222c_t *dev, uint8_t op, uint32_t bytes, int result, uint32_t startUs);
+#if IQS7222C_LATENCY_STATS
+static uint8_t latencyBucket(uint32_t us);
+static uint32_t latencyBucketEnd(uint8_t bucket);
+static uint32_t latencyPercentile(const iqs7222c_latency_hist_t *hist, uint32_t percent);
+#endif
+static void queueEvents(iqs7222c_t *dev);
+static void queueChannelEvents(iqs7222c_t *dev, uint16_t states, uint16_t *lastStates,
+                               uint8_t onType, uint8_t offType);
+static void emitEvent(iqs7222c_t *dev, uint8_t type, uint8_t index, uint16_t value);
+static void pushEvent(iqs7222c_t *dev, const iqs7222c_event_t *event);
+static void dispatchEvent(iqs7222c_t *dev, const iqs7222c_event_t *event);
 
 /**************************************************************************************************************/
 /*                                              PUBLIC METHODS */
@@ -74,55 +197,94 @@ int writeRandomBytes16(uint16_t memoryAddress, uint8_t numBytes,
  * @name   begin
  * @brief  A method to initialize the IQS7222C device with the device address
  * and ready pin specified by the user.
- * @param  deviceAddress -> The address of the IQS7222C device.
+ * @param  dev           -> Driver context of this device, used by every call.
+ *         deviceAddress -> The address of the IQS7222C device.
  *         readyPin      -> The Arduino pin which is connected to the ready pin
  * of the IQS7222C device.
- * @retval Returns true if communication has been successfully established,
- * returns false if not.
- * @notes  Receiving a true return value does not mean that initialization was
- * successful. Receiving a true return value only means that the IQS device
- * responded to the request for communication. Receiving a false return value
- * means that initialization did not take place at all. If communication is
- * successfully established then it is unlikely that initialization will fail.
+ * @retval Returns true if the RDY interrupt is set up, returns false if not.
+ * @notes  Never blocks and makes no transfer. It sets up the context and the
+ * RDY interrupt and starts the init sequence, iqs7222c_init then waits for
+ * the first window and forces communication if none opens within
+ * IQS7222C_RDY_TIMEOUT_MS.
  */
-bool iqs7222c_begin(uint8_t deviceAddressIn, uint8_t readyPinIn, const nrf_drv_twi_t *m_twi)
+bool iqs7222c_begin(iqs7222c_t *dev, uint8_t deviceAddressIn, uint8_t readyPinIn,
+                    const i2c_touch_bus_t *m_twi)
 {
     // Initialize I2C communication here, since this library can't function
     // without it.
-    ret_code_t retCode = NRF_SUCCESS;
-    i2c_touch_init(m_twi);
-
-    bool response = false; // The return value. Is set to the return value of the requestComms function.
-    _deviceAddress = deviceAddressIn;
-    _readyPin = readyPinIn;
-
-    // initalize GPIO module
-    if (false == nrf_drv_gpiote_is_init())
-    {
-        retCode = nrf_drv_gpiote_init();
-    }
-
-    if (retCode != NRF_SUCCESS)
-    {
-        return false;
-    }
-
-    retCode = nrf_drv_gpiote_in_init(_readyPin, &_pin_config_in, NULL);
-
-    if (retCode != NRF_SUCCESS)
+    int retCode = I2C_TOUCH_SUCCESS;
+    i2c_touch_init(&dev->bus, m_twi);
+
+    iqs7222c_resetBusStats(dev);
+    dev->address = deviceAddressIn;
+    dev->ready_pin = readyPinIn;
+    dev->device_rdy = false;
+    dev->new_data_available = false;
+    dev->shadow_valid = false;
+    memset(dev->shadow_dirty, 0, sizeof(dev->shadow_dirty));
+    dev->async_updates = false;
+    dev->event_head = 0;
+    dev->event_tail = 0;
+    memset(&dev->event_stats, 0, sizeof(dev->event_stats));
+    dev->last_touch_states = 0;
+    dev->last_prox_states = 0;
+    dev->last_slider0 = IQS7222C_SLIDER_NO_TOUCH;
+    dev->last_slider1 = IQS7222C_SLIDER_NO_TOUCH;
+    dev->last_info_flags = 0;
+    dev->frame_seq = 0;
+    memset(dev->frames, 0, sizeof(dev->frames));
+    dev->frames[0].slider[0] = IQS7222C_SLIDER_NO_TOUCH;
+    dev->frames[0].slider[1] = IQS7222C_SLIDER_NO_TOUCH;
+    dev->subscriber_count = 0;
+    dev->subscriber_types = 0;
+    memset(dev->memory_map.iqs7222c_slider_wheel_out.buffer, 0xFF,
+           sizeof(dev->memory_map.iqs7222c_slider_wheel_out.buffer));
+    dev->read_mode = IQS7222C_READ_LEARNED;
+    dev->read_blocks = IQS7222C_READ_SLIDERS;
+    dev->follow_up_blocks = 0;
+    memset(&dev->read_stats, 0, sizeof(dev->read_stats));
+    iqs7222c_resetLatency(dev);
+    iqs7222c_resetWindowStats(dev);
+    dev->overrun_handler = NULL;
+
+    // Configure the RDY pin with its falling edge interrupt straight away, the
+    // edges wake the CPU during the init sequence.
+    retCode = i2c_touch_pin_init(&dev->bus, dev->ready_pin, ready_interupt, dev);
+
+    if (retCode != I2C_TOUCH_SUCCESS)
     {
         return false;
     }
 
-    // Request communication and run ATI routine.
-    response = iqs7222c_waitForReady();
+    // SHOW_RESET is left for IQS7222C_INIT_READ_RESET, it tells a power on
+    // from an MCU only restart. That state waits for the first window.
+    dev->state.init_state = IQS7222C_INIT_READ_RESET;
+    dev->config_checked = false;
+    memset(&dev->init_stats, 0, sizeof(dev->init_stats));
+    dev->init_start_us = i2c_touch_time_us(&dev->bus);
+    dev->init_timer_armed = false;
+    dev->init_timer_expired = false;
 
-    if (response)
-    {
-        iqs7222c_acknowledgeReset(STOP);
-    }
+    return true;
+}
 
-    return response;
+/**
+ * @name   beginBackend
+ * @brief  iqs7222c_begin on a bus backend other than the built in one, such
+ * as the i2c_touch_trace recorder or a host replay.
+ * @param  dev           -> Driver context of this device, used by every call.
+ *         deviceAddress -> The address of the IQS7222C device.
+ *         readyPin      -> The pin which is connected to the ready pin of the
+ * IQS7222C device.
+ *         backend       -> Transfer, GPIO and timer functions of the bus.
+ *         context       -> Passed to every backend function.
+ * @retval Same as iqs7222c_begin.
+ */
+bool iqs7222c_beginBackend(iqs7222c_t *dev, uint8_t deviceAddressIn, uint8_t readyPinIn,
+                           const i2c_touch_backend_t *backend, void *context)
+{
+    i2c_touch_set_backend(&dev->bus, backend, context);
+    return iqs7222c_begin(dev, deviceAddressIn, readyPinIn, NULL);
 }
 
 /**
@@ -131,57 +293,141 @@ bool iqs7222c_begin(uint8_t deviceAddressIn, uint8_t readyPinIn, const nrf_drv_t
  * IQS7222C with the desired settings from the IQS7222C_init.h file.
  * @retval Returns true if the full start-up routine has been completed, returns
  * false if not.
- * @notes  No false return will be given, the program will thus be stuck when
- * one of the cases is not able to finish. See serial communication to find the
- * ERROR case
+ * @notes  Never blocks. Each call performs the transfers the current state
+ * can do right now and returns; states that need a communication window or a
+ * delay return false until the RDY falling edge or the one-shot timer expiry
+ * arrives. Call it again after any interrupt, the CPU can sleep in between.
+ * If no window opens within IQS7222C_RDY_TIMEOUT_MS communication is forced.
+ * Wall time and time spent inside this method are available from
+ * iqs7222c_getInitStats.
+ */
+bool iqs7222c_init(iqs7222c_t *dev)
+{
+    uint32_t entryUs = i2c_touch_time_us(&dev->bus);
+    bool done = initStep(dev);
+    uint32_t exitUs = i2c_touch_time_us(&dev->bus);
+
+    dev->init_stats.busy_us += exitUs - entryUs;
+    dev->init_stats.calls++;
+    if (done && !dev->init_stats.done)
+    {
+        dev->init_stats.done = true;
+        dev->init_stats.wall_us = exitUs - dev->init_start_us;
+    }
+    return done;
+}
+
+/**
+ * @name   getInitStats
+ * @brief  Timing of the last init sequence, started by iqs7222c_begin.
+ * @retval wall_us is valid once done is set, busy_us and the counters are
+ * updated on every iqs7222c_init call.
+ */
+iqs7222c_init_stats_t iqs7222c_getInitStats(iqs7222c_t *dev)
+{
+    return dev->init_stats;
+}
+
+/**
+ * @name   initStep
+ * @brief  One step of the init state machine, see iqs7222c_init.
  */
-bool iqs7222c_init(void)
+static bool initStep(iqs7222c_t *dev)
 {
     uint16_t prod_num;
     uint8_t ver_maj, ver_min;
 
-    switch (iqs7222C_state.init_state)
+    switch (dev->state.init_state)
     {
     case IQS7222C_INIT_READ_RESET:
         //NRF_LOG_INFO("IQS7222C_INIT_READ_RESET");
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
 
-        /* Read Info Flags */
-        iqs7222c_updateInfoFlags(RESTART);
-        if (iqs7222c_checkReset())
+        /* Read Info Flags, the read ends the window */
+        iqs7222c_updateInfoFlags(dev, STOP);
+        if (iqs7222c_checkReset(dev))
         {
             //NRF_LOG_INFO("Software Reset event occured.");
-            // If the Show Reset bit is set, acknowledge the reset event
-            iqs7222c_acknowledgeReset(RESTART);
-            //NRF_LOG_INFO("Acknowledge reset.");
-            iqs7222C_state.init_state = IQS7222C_INIT_VERIFY_PRODUCT;
+            // The reset is acknowledged in IQS7222C_INIT_ACK_RESET, once the
+            // settings are written.
+            dev->state.init_state = IQS7222C_INIT_VERIFY_PRODUCT;
+        }
+        else if (IQS7222C_WARM_START && !dev->config_checked)
+        {
+            // The device kept running, it may still hold our configuration.
+            dev->config_checked = true;
+            dev->config_offset = 0;
+            dev->state.init_state = IQS7222C_INIT_VERIFY_CONFIG;
+        }
+        else
+        {
+            dev->state.init_state = IQS7222C_INIT_CHIP_RESET;
+        }
+        // The read ended the window. Ask for the next one rather than wait
+        // for the report rate or the RDY timeout of a device idle in event mode.
+        iqs7222c_force_I2C_communication(dev);
+        break;
+
+    /* Compare the configuration of a device that did not reset with
+   * IQS7222C_init.h, one burst per window */
+    case IQS7222C_INIT_VERIFY_CONFIG:
+        //NRF_LOG_INFO("IQS7222C_INIT_VERIFY_CONFIG");
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
+
+        int retVal = readConfig(dev);
+        // Every state from here on needs another window.
+        iqs7222c_force_I2C_communication(dev);
+        if (retVal != I2C_TOUCH_SUCCESS)
+        {
+            dev->state.init_state = IQS7222C_INIT_CHIP_RESET;
+        }
+        else if (dev->config_offset < IQS7222C_SHADOW_BYTES)
+        {
+            break;
+        }
+        else if (configFingerprint(dev) == IQS7222C_CONFIG_FINGERPRINT)
+        {
+            // Only the MCU restarted. The settings and ATI results are intact,
+            // skip the reset, the writes and the re-ATI.
+            dev->shadow_valid = true;
+            dev->init_stats.warm_start = true;
+            dev->state.init_state = IQS7222C_ACTIVATE_EVENT_MODE;
         }
         else
         {
-            iqs7222C_state.init_state = IQS7222C_INIT_CHIP_RESET;
+            // The shadow now holds what the device runs, so the reset needs
+            // no read of the control settings in its window.
+            dev->shadow_valid = true;
+            dev->state.init_state = IQS7222C_INIT_CHIP_RESET;
         }
         break;
 
     case IQS7222C_INIT_CHIP_RESET:
         //NRF_LOG_INFO("IQS7222C_INIT_CHIP_RESET");
 
-        // Perform SW Reset
-        iqs7222c_SW_Reset(RESTART);
-        //NRF_LOG_INFO("Software Reset Bit set.");
-        nrf_delay_ms(100);
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
 
-        while (!iqs7222c_waitForReady())
-            ;
+        // Perform SW Reset, the stop closes the window so the reset starts now
+        iqs7222c_SW_Reset(dev, STOP);
+        //NRF_LOG_INFO("Software Reset Bit set.");
+        dev->state.init_state = IQS7222C_INIT_CHECK_RESET;
+        break;
 
-        // Read the Info flags
-        iqs7222c_updateInfoFlags(RESTART);
-        // Check if Show Reset bit is set
-        if (iqs7222c_checkReset())
+    /* Give the device time to restart, then read the Show Reset bit again */
+    case IQS7222C_INIT_CHECK_RESET:
+        //NRF_LOG_INFO("IQS7222C_INIT_CHECK_RESET");
+        if (initWaitForTimer(dev, IQS7222C_RESET_DELAY_MS * 1000))
         {
-            //NRF_LOG_INFO("Software Reset event occured.");
-            // If the Show Reset bit is set, acknowledge the reset event
-            iqs7222c_acknowledgeReset(RESTART);
-            //NRF_LOG_INFO("Acknowledge reset.");
-            iqs7222C_state.init_state = IQS7222C_INIT_VERIFY_PRODUCT;
+            dev->state.init_state = IQS7222C_INIT_READ_RESET;
         }
         break;
 
@@ -189,11 +435,11 @@ bool iqs7222c_init(void)
    * Arduino */
     case IQS7222C_INIT_VERIFY_PRODUCT:
         //NRF_LOG_INFO("IQS7222C_INIT_VERIFY_PRODUCT");
-        iqs7222C_state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
+        dev->state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
 #if false 
-        prod_num = iqs7222c_getProductNum(RESTART);
-        ver_maj = iqs7222c_getmajorVersion(RESTART);
-        ver_min = iqs7222c_getminorVersion(RESTART);
+        prod_num = iqs7222c_getProductNum(dev, RESTART);
+        ver_maj = iqs7222c_getmajorVersion(dev, RESTART);
+        ver_min = iqs7222c_getminorVersion(dev, RESTART);
         //NRF_LOG_INFO("Product number is: %d", prod_num);
         //NRF_LOG_INFO(" v %d.%d", ver_maj, ver_min);
         if (prod_num == IQS7222C_PRODUCT_NUM)
@@ -207,7 +453,7 @@ bool iqs7222c_init(void)
                 //NRF_LOG_INFO(".");
                 //NRF_LOG_INFO(ver_min);
                 //NRF_LOG_INFO(" is compatible");
-                iqs7222C_state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
+                dev->state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
             }
             else
             {
@@ -216,7 +462,7 @@ bool iqs7222c_init(void)
                 //NRF_LOG_INFO(".");
                 //NRF_LOG_INFO(ver_min);
                 //NRF_LOG_INFO(" not compatible, current selection is v2.23!");
-                iqs7222C_state.init_state = IQS7222C_INIT_NONE;
+                dev->state.init_state = IQS7222C_INIT_NONE;
             }
 #elif IQS7222C_v2_6
             if (ver_maj == 2 && ver_min == 6)
@@ -226,7 +472,7 @@ bool iqs7222c_init(void)
                 //NRF_LOG_INFO(".");
                 //NRF_LOG_INFO(ver_min);
                 //NRF_LOG_INFO(" is compatible");
-                iqs7222C_state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
+                dev->state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
             }
             else
             {
@@ -235,7 +481,7 @@ bool iqs7222c_init(void)
                 //NRF_LOG_INFO(".");
                 //NRF_LOG_INFO(ver_min);
                 //NRF_LOG_INFO(" not compatible, current selection is v2.6!");
-                iqs7222C_state.init_state = IQS7222C_INIT_NONE;
+                dev->state.init_state = IQS7222C_INIT_NONE;
             }
 #elif IQS7222C_v1_13
             if (ver_maj == 1 && ver_min == 13)
@@ -245,7 +491,7 @@ bool iqs7222c_init(void)
                 //NRF_LOG_INFO(".");
                 //NRF_LOG_INFO(ver_min);
                 //NRF_LOG_INFO(" is compatible");
-                iqs7222C_state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
+                dev->state.init_state = IQS7222C_INIT_UPDATE_SETTINGS;
             }
             else
             {
@@ -254,14 +500,14 @@ bool iqs7222c_init(void)
                 //NRF_LOG_INFO(".");
                 //NRF_LOG_INFO(ver_min);
                 //NRF_LOG_INFO(" not compatible, current selection is v1.13!");
-                iqs7222C_state.init_state = IQS7222C_INIT_NONE;
+                dev->state.init_state = IQS7222C_INIT_NONE;
             }
 #endif
         }
         else
         {
             //NRF_LOG_INFO("\t\tDevice is not a IQS7222C!");
-            iqs7222C_state.init_state = IQS7222C_INIT_NONE;
+            dev->state.init_state = IQS7222C_INIT_NONE;
         }
 #endif
         break;
@@ -269,55 +515,68 @@ bool iqs7222c_init(void)
     /* Write all settings to IQS7222A from .h file */
     case IQS7222C_INIT_UPDATE_SETTINGS:
         //NRF_LOG_INFO("IQS7222C_INIT_UPDATE_SETTINGS");
-        iqs7222c_writeMM(RESTART);
-        iqs7222C_state.init_state = IQS7222C_INIT_ACK_RESET;
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
+        iqs7222c_writeMM(dev, RESTART);
+        dev->state.init_state = IQS7222C_INIT_ACK_RESET;
         break;
 
     /* Acknowledge that the device went through a reset */
     case IQS7222C_INIT_ACK_RESET:
         //NRF_LOG_INFO("IQS7222C_INIT_ACK_RESET");
-        iqs7222c_acknowledgeReset(RESTART);
-        iqs7222C_state.init_state = IQS7222C_INIT_ATI;
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
+        iqs7222c_acknowledgeReset(dev, RESTART);
+        dev->state.init_state = IQS7222C_INIT_ATI;
 
     /* Run the ATI algorithm to recalibrate the device with newly added settings
    */
     case IQS7222C_INIT_ATI:
         //NRF_LOG_INFO("IQS7222C_INIT_ATI");
-        iqs7222c_TP_ReATI(STOP);
-        iqs7222C_state.init_state = IQS7222C_ACTIVATE_EVENT_MODE;
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
+        iqs7222c_TP_ReATI(dev, STOP);
+        dev->state.init_state = IQS7222C_ACTIVATE_EVENT_MODE;
         break;
 
     /* Turn on I2C event mode */
     case IQS7222C_ACTIVATE_EVENT_MODE:
         //NRF_LOG_INFO("IQS7222C_ACTIVATE_EVENT_MODE");
-        while (!iqs7222c_waitForReady())
-            ;
-        iqs7222c_setEventMode(STOP);
-        iqs7222C_state.init_state = IQS7222C_INIT_DONE;
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
+        iqs7222c_setEventMode(dev, STOP);
+        dev->state.init_state = IQS7222C_INIT_DONE;
         break;
 
     /* Turn on I2C stream in touch mode */
     case IQS7222C_ACTIVATE_STREAM_IN_TOUCH:
         //NRF_LOG_INFO("IQS7222C_ACTIVATE_STREAM_IN_TOUCH");
-        while (!iqs7222c_waitForReady())
-            ;
-        iqs7222c_setStreamInTouch(STOP);
-        iqs7222C_state.init_state = IQS7222C_INIT_DONE;
+        if (!initWaitForWindow(dev))
+        {
+            break;
+        }
+        iqs7222c_setStreamInTouch(dev, STOP);
+        dev->state.init_state = IQS7222C_INIT_DONE;
         break;
 
-    /* If all operations has been completed correctly, RDY pin can be set up as
-   * intterupt to indicate when new data is available */
+    /* If all operations has been completed correctly, RDY pin interrupts
+   * indicate when new data is available */
     case IQS7222C_INIT_DONE:
         //NRF_LOG_INFO("IQS7222C_INIT_DONE");
 
-        /* Setup interrupt pin for ready windows */
-        nrf_drv_gpiote_in_uninit(_readyPin);
-        nrf_drv_gpiote_in_config_t rdy_pin_interrupt_cfg = GPIOTE_CONFIG_IN_SENSE_HITOLO(true);
-        nrf_drv_gpiote_in_init(_readyPin, &rdy_pin_interrupt_cfg, ready_interupt);
-
         //NRF_LOG_INFO("IQS7222C Ready!");
-        iqs7222c_deviceRDY = false;
-        new_data_available = false;
+        dev->device_rdy = false;
+        dev->new_data_available = false;
+        // The init sequence reads its windows itself, count from here.
+        iqs7222c_resetWindowStats(dev);
         return true;
         break;
 
@@ -337,13 +596,14 @@ bool iqs7222c_init(void)
  * @notes  iqs7222c_queueValueUpdates can be edited by the user if other data should be
  * read everytime a RDY window is received.
  */
-void iqs7222c_run(void)
+void iqs7222c_run(iqs7222c_t *dev)
 {
-    if (iqs7222c_deviceRDY)
+    if (dev->device_rdy)
     {
-        iqs7222c_queueValueUpdates();
-        new_data_available = true;
-        iqs7222c_deviceRDY = false;
+        // Cleared first, a window requested while reading sets it again.
+        dev->device_rdy = false;
+        iqs7222c_queueValueUpdates(dev);
+        dev->new_data_available = true;
     }
 }
 
@@ -356,9 +616,36 @@ void iqs7222c_run(void)
  * @notes  Keep this function as simple as possible to prevent stuck states and
  * slow operations.
  */
-void ready_interupt(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+void ready_interupt(uint32_t pin, void *p_context)
 {
-    iqs7222c_deviceRDY = true;
+    iqs7222c_t *dev = p_context;
+
+    dev->rdy_time_us = i2c_touch_time_us(&dev->bus);
+    dev->rdy_edges++;
+    if (dev->device_rdy)
+    {
+        dev->event_stats.rdy_overruns++;
+        dev->window_stats.overruns++;
+        overrunNotify(dev, true);
+    }
+
+    if (dev->async_updates)
+    {
+        // One stop terminated transfer that cannot ask for another window,
+        // the planned slider outputs are always included.
+        dev->async_length = statusLength(dev->read_blocks);
+        dev->window_time_us = dev->rdy_time_us;
+        windowServiced(dev);
+        latencyRecord(dev, IQS7222C_LATENCY_TWI_START);
+        dev->async_start_us = i2c_touch_time_us(&dev->bus);
+        if (i2c_touch_read_register_async(&dev->bus, dev->address, IQS7222C_MM_INFOFLAGS,
+                                          dev->async_length, dev->async_bytes,
+                                          asyncUpdateDone, dev) == I2C_TOUCH_SUCCESS)
+        {
+            return;
+        }
+    }
+    dev->device_rdy = true;
 }
 
 /**
@@ -367,43 +654,390 @@ void ready_interupt(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
  * performed each time the IQS7222A opens a RDY window.
  * @param  None.
  * @retval None.
- * @notes  Any Address in memory map can be read from here.
+ * @notes  Any Address in memory map can be read from here. What is read
+ * follows the read plan, see iqs7222c_setReadPlan. Each window is one
+ * burst from the info flags, the stop at its end closes the window.
+ */
+void iqs7222c_queueValueUpdates(iqs7222c_t *dev)
+{
+    uint8_t transferBytes[WINDOW_MAX_BYTES]; // The array which will hold the bytes to be
+                                             // transferred.
+    uint8_t blocks;
+    uint8_t length;
+    uint32_t misses = dev->read_stats.misses;
+
+    // The next window's edge may arrive before this one is decoded.
+    dev->window_time_us = dev->rdy_time_us;
+    windowServiced(dev);
+    dev->read_stats.windows++;
+    latencyRecord(dev, IQS7222C_LATENCY_TWI_START);
+    if ((dev->read_mode == IQS7222C_READ_EVENTS_FIRST) && (dev->follow_up_blocks == 0))
+    {
+        // The status bytes only. The read ends the window, what the events
+        // ask for is read in a window requested straight after it.
+        blocks = 0;
+        length = IQS7222C_STATUS_BYTES;
+        readWindow(dev, IQS7222C_MM_INFOFLAGS, length, transferBytes, STOP);
+        dev->follow_up_blocks = planBlocks(dev, transferBytes[2] | (transferBytes[3] << 8),
+                                           transferBytes[4] | (transferBytes[5] << 8));
+    }
+    else
+    {
+        if (dev->follow_up_blocks != 0)
+        {
+            blocks = dev->follow_up_blocks;
+            dev->follow_up_blocks = 0;
+        }
+        else
+        {
+            uint16_t events = dev->memory_map.iqs7222c_events.iqs7222c_events_lsb |
+                              (dev->memory_map.iqs7222c_events.iqs7222c_events_msb << 8);
+            blocks = planBlocks(dev, events, dev->last_prox_states);
+        }
+        length = windowLength(blocks);
+        readWindow(dev, IQS7222C_MM_INFOFLAGS, length, transferBytes, STOP);
+    }
+    latencyRecord(dev, IQS7222C_LATENCY_TWI_DONE);
+
+    if (blocks & IQS7222C_READ_COUNTS)
+    {
+        memcpy(dev->memory_map.iqs7222c_channel_counts.buffer, &transferBytes[WINDOW_COUNTS_OFFSET],
+               sizeof(dev->memory_map.iqs7222c_channel_counts.buffer));
+    }
+    if (blocks & IQS7222C_READ_LTA)
+    {
+        memcpy(dev->memory_map.iqs7222c_channel_lta.buffer, &transferBytes[WINDOW_LTA_OFFSET],
+               sizeof(dev->memory_map.iqs7222c_channel_lta.buffer));
+    }
+    decodeStatus(dev, transferBytes, length);
+
+    // In event mode the next window may only come with the release, ask for
+    // one now to pick up the slider outputs or the follow-up blocks.
+    if ((dev->read_stats.misses != misses) || (dev->follow_up_blocks != 0))
+    {
+        iqs7222c_force_I2C_communication(dev);
+    }
+}
+
+/**
+ * @name   getLatency
+ * @brief  Latency from the RDY falling edge to one stage of the update path.
+ * @param  stage -> iqs7222c_latency_stage_e.
+ * @retval Sample count, median, 99th percentile and maximum in us, all 0
+ * when built with IQS7222C_LATENCY_STATS=0.
+ * @notes  Samples are taken with the backend clock, on the host that is the
+ * simulated time. The histograms are written from the decoding context
+ * without locking, a query that interrupts an update may be one sample off.
  */
-void iqs7222c_queueValueUpdates(void)
+iqs7222c_latency_t iqs7222c_getLatency(iqs7222c_t *dev, iqs7222c_latency_stage_e stage)
 {
-    uint8_t transferBytes[10]; // The array which will hold the bytes to be
-                               // transferred.
+    iqs7222c_latency_t latency = {0};
 
-    // Read the info flags.
-    readRandomBytes(IQS7222C_MM_INFOFLAGS, 10, transferBytes, STOP);
-    // Assign the info flags to the info flags union.
-    IQSMemoryMap.iqs7222c_info_flags.iqs7222c_infoflags_lsb = transferBytes[0];
-    IQSMemoryMap.iqs7222c_info_flags.iqs7222c_infoflags_msb = transferBytes[1];
+#if IQS7222C_LATENCY_STATS
+    if (stage < IQS7222C_LATENCY_STAGES)
+    {
+        const iqs7222c_latency_hist_t *hist = &dev->latency[stage];
 
-    IQSMemoryMap.iqs7222c_events.iqs7222c_events_lsb = transferBytes[2];
-    IQSMemoryMap.iqs7222c_events.iqs7222c_events_msb = transferBytes[3];
+        latency.count = hist->count;
+        latency.p50_us = latencyPercentile(hist, 50);
+        latency.p99_us = latencyPercentile(hist, 99);
+        latency.max_us = hist->max_us;
+    }
+#endif
+    return latency;
+}
 
-    IQSMemoryMap.iqs7222c_prox_event_states.iqs7222c_prox_event_states_lsb =
-        transferBytes[4];
-    IQSMemoryMap.iqs7222c_prox_event_states.iqs7222c_prox_event_states_msb =
-        transferBytes[5];
+/**
+ * @name   resetLatency
+ * @brief  Clear the latency histograms of every stage.
+ */
+void iqs7222c_resetLatency(iqs7222c_t *dev)
+{
+#if IQS7222C_LATENCY_STATS
+    memset(dev->latency, 0, sizeof(dev->latency));
+#endif
+}
 
-    IQSMemoryMap.iqs7222c_touch_event_states.iqs7222c_touch_event_states_lsb =
-        transferBytes[6];
-    IQSMemoryMap.iqs7222c_touch_event_states.iqs7222c_touch_event_states_msb =
-        transferBytes[7];
+/**
+ * @name   getBusStats
+ * @brief  Transactions, bytes, NACKs and wire time per traffic class since
+ * iqs7222c_begin or iqs7222c_resetBusStats.
+ * @notes  Every transfer of the driver is counted, classified by its register
+ * address: writes to the control settings word alone are control commands,
+ * longer system register bursts and all extended addresses are
+ * configuration. Wire time is measured with the backend clock around the
+ * transfer, on target it includes the driver overhead and has the clock's
+ * resolution. Transfers issued directly through i2c_touch are not seen.
+ */
+iqs7222c_bus_stats_t iqs7222c_getBusStats(iqs7222c_t *dev)
+{
+    return dev->bus_stats;
+}
+
+/**
+ * @name   resetBusStats
+ * @brief  Clear the bus traffic counters.
+ */
+void iqs7222c_resetBusStats(iqs7222c_t *dev)
+{
+    memset(&dev->bus_stats, 0, sizeof(dev->bus_stats));
+}
+
+/**
+ * @name   getWindowStats
+ * @brief  RDY window servicing counters since init completed or
+ * iqs7222c_resetWindowStats, see iqs7222c_window_stats_t.
+ * @notes  Missed windows are found when the next window is serviced: every
+ * RDY edge after the last serviced one but the current closed without a
+ * transaction (an overrun, or a window iqs7222c_sched dropped), and a read
+ * that starts later than COMMS_TIMEOUT after its edge found the window
+ * already closed. Lateness is only checked while the register shadow is
+ * valid and COMMS_TIMEOUT is not 0.
+ */
+iqs7222c_window_stats_t iqs7222c_getWindowStats(iqs7222c_t *dev)
+{
+    iqs7222c_window_stats_t stats = dev->window_stats;
+
+    stats.rdy_edges = dev->rdy_edges;
+    return stats;
+}
+
+/**
+ * @name   resetWindowStats
+ * @brief  Clear the RDY window counters and the overrun state.
+ */
+void iqs7222c_resetWindowStats(iqs7222c_t *dev)
+{
+    memset(&dev->window_stats, 0, sizeof(dev->window_stats));
+    dev->rdy_edges = 0;
+    dev->serviced_edges = 0;
+    dev->overrun = false;
+}
+
+/**
+ * @name   getCommsTimeoutUs
+ * @brief  How long a window stays open after its RDY edge, from the register
+ * shadow of COMMS_TIMEOUT (ms).
+ * @retval UINT32_MAX while the shadow is not valid or COMMS_TIMEOUT is 0.
+ */
+uint32_t iqs7222c_getCommsTimeoutUs(const iqs7222c_t *dev)
+{
+    int offset = shadowOffset(IQS7222C_MM_COMMS_TIMEOUT, false);
+    uint32_t timeoutMs = dev->shadow[offset] | ((uint32_t)dev->shadow[offset + 1] << 8);
+
+    if (!dev->shadow_valid || (timeoutMs == 0))
+    {
+        return UINT32_MAX;
+    }
+    return timeoutMs * 1000u;
+}
+
+/**
+ * @name   setOverrunHandler
+ * @brief  Get told when RDY windows start being missed, to shed load.
+ * @param  handler   -> Called with true on the first overrun or missed
+ *                      window, and with false on the next window serviced
+ *                      in time. NULL to remove.
+ *         p_context -> Passed back to the handler.
+ * @retval None.
+ * @notes  An overrun is reported from the RDY interrupt as it happens, late
+ * and dropped windows when the next window is serviced. Call after
+ * iqs7222c_begin, which removes the handler.
+ */
+void iqs7222c_setOverrunHandler(iqs7222c_t *dev, iqs7222c_overrun_handler_t handler,
+                                void *p_context)
+{
+    dev->overrun_handler = NULL;
+    dev->overrun_context = p_context;
+    dev->overrun_handler = handler;
+}
+
+/**
+ * @name   setReadPlan
+ * @brief  Choose what is read in each RDY window besides the info flags,
+ * events, prox and touch states.
+ * @param  mode   -> IQS7222C_READ_LEARNED: one burst from the info flags,
+ *                   sized from the previous window.
+ *                   IQS7222C_READ_EVENTS_FIRST: read the status bytes,
+ *                   then the blocks their events ask for in a second,
+ *                   forced window. Costs that window whenever anything
+ *                   beyond the status is needed.
+ *                   IQS7222C_READ_FIXED: every block every window.
+ *         blocks -> IQS7222C_READ_SLIDER0, _SLIDER1, _COUNTS and _LTA.
+ * @retval None.
+ * @notes  Slider outputs are only read while a channel is touched, a touch
+ * event is reported or a slider has not returned to
+ * IQS7222C_SLIDER_NO_TOUCH. Counts and LTA are only read while a channel is
+ * in prox or a prox, touch or ATI event is reported, they land in the memory
+ * map unions. They extend the status burst up to the LTA, every read ends
+ * the window. A learned burst that misses the slider outputs of a new touch
+ * requests another window straight away. Asynchronous status reads are a
+ * single transfer: they always include the planned slider outputs and never
+ * read counts or LTA. The default is IQS7222C_READ_LEARNED with both
+ * sliders.
+ */
+void iqs7222c_setReadPlan(iqs7222c_t *dev, iqs7222c_read_mode_e mode, uint8_t blocks)
+{
+    dev->read_mode = mode;
+    dev->read_blocks = blocks;
+    dev->follow_up_blocks = 0;
+}
+
+/**
+ * @name   getReadStats
+ * @brief  Per window read counters, see iqs7222c_read_stats_t.
+ */
+iqs7222c_read_stats_t iqs7222c_getReadStats(iqs7222c_t *dev)
+{
+    return dev->read_stats;
+}
+
+/**
+ * @name   startAsyncUpdates
+ * @brief  Read the status burst from the RDY interrupt instead of iqs7222c_run.
+ * @param  handler -> Called from interrupt context once the burst has been
+ * decoded, NULL if polling iqs7222c_isNewDataAvailable is enough.
+ * @retval None.
+ * @notes  Call after iqs7222c_init has completed. The RDY falling edge starts a
+ * non-blocking read of the status burst and the planned slider outputs
+ * (see iqs7222c_setReadPlan) and the completion decodes it, so the CPU is
+ * free while the burst is on the bus and the RDY to data latency does not
+ * depend on the main loop. Blocking commands issued while a burst is in
+ * flight wait for it to complete first. With I2C_TOUCH_TWI_ASYNC they cannot
+ * wait in interrupt context, from the handler or a subscriber they return
+ * I2C_TOUCH_ERROR_INVALID_STATE. If the burst cannot be started the window is
+ * left to iqs7222c_run as before.
+ */
+void iqs7222c_startAsyncUpdates(iqs7222c_t *dev, iqs7222c_update_handler_t handler)
+{
+    dev->async_handler = handler;
+    dev->async_updates = true;
+}
+
+/**
+ * @name   stopAsyncUpdates
+ * @brief  Return to reading the status burst from iqs7222c_run.
+ * @param  None.
+ * @retval None.
+ */
+void iqs7222c_stopAsyncUpdates(iqs7222c_t *dev)
+{
+    dev->async_updates = false;
+}
+
+/**
+ * @name   readEvents
+ * @brief  Drain up to maxEvents decoded events, oldest first.
+ * @param  events    -> Destination array.
+ *         maxEvents -> Size of the destination array.
+ * @retval Number of events copied.
+ * @notes  Events are queued for every channel touch, release, prox and prox
+ * release edge, every slider movement and every ATI error or power mode
+ * change seen between two consecutive RDY windows, stamped with the time of
+ * the window's RDY edge. Call from one context only. If the queue fills up
+ * new events are dropped and counted, see iqs7222c_getEventStats.
+ */
+uint32_t iqs7222c_readEvents(iqs7222c_t *dev, iqs7222c_event_t *events, uint32_t maxEvents)
+{
+    uint32_t tail = dev->event_tail;
+    uint32_t count = dev->event_head - tail;
+    EVENT_QUEUE_BARRIER();
+
+    if (count > maxEvents)
+    {
+        count = maxEvents;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        events[i] = dev->events[(tail + i) & EVENT_QUEUE_MASK];
+    }
+    EVENT_QUEUE_BARRIER();
+    dev->event_tail = tail + count;
+
+    return count;
+}
+
+/**
+ * @name   subscribe
+ * @brief  Call handler for every decoded edge of the given types.
+ * @param  types     -> IQS7222C_EVENT_MASK of each wanted iqs7222c_event_type_e.
+ *         channels  -> Channel events are only delivered for these channel
+ *                      bits (bit n for IQS7222C_CHn), IQS7222C_ALL_CHANNELS
+ *                      for all. Slider, ATI error and power mode events are
+ *                      not filtered by channel.
+ *         handler   -> Called with the event and p_context.
+ * @retval false when all IQS7222C_MAX_SUBSCRIBERS slots are taken.
+ * @notes  Edges are found by XOR of the previous and current state words, so
+ * nothing runs for a subscriber unless one of its channels or types changed.
+ * The handler runs in the context that decodes the status burst, see
+ * iqs7222c_event_handler_t. Subscribe after iqs7222c_begin, and before
+ * startAsyncUpdates or with the RDY interrupt masked. Events are queued for
+ * iqs7222c_readEvents as well.
+ */
+bool iqs7222c_subscribe(iqs7222c_t *dev, uint8_t types, uint16_t channels,
+                        iqs7222c_event_handler_t handler, void *p_context)
+{
+    if ((handler == NULL) || (dev->subscriber_count >= IQS7222C_MAX_SUBSCRIBERS))
+    {
+        return false;
+    }
+
+    iqs7222c_subscriber_t *subscriber = &dev->subscribers[dev->subscriber_count];
+    subscriber->handler = handler;
+    subscriber->p_context = p_context;
+    subscriber->channels = channels;
+    subscriber->types = types;
+    dev->subscriber_count++;
+    dev->subscriber_types |= types;
+    return true;
+}
+
+/**
+ * @name   unsubscribe
+ * @brief  Remove every subscription made with handler and p_context.
+ */
+void iqs7222c_unsubscribe(iqs7222c_t *dev, iqs7222c_event_handler_t handler, void *p_context)
+{
+    uint8_t kept = 0;
+    uint8_t types = 0;
+
+    for (uint8_t i = 0; i < dev->subscriber_count; i++)
+    {
+        if ((dev->subscribers[i].handler == handler) && (dev->subscribers[i].p_context == p_context))
+        {
+            continue;
+        }
+        dev->subscribers[kept] = dev->subscribers[i];
+        types |= dev->subscribers[kept].types;
+        kept++;
+    }
+    dev->subscriber_count = kept;
+    dev->subscriber_types = types;
+}
 
-    IQSMemoryMap.iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_lsb =
-        transferBytes[8];
-    IQSMemoryMap.iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_msb =
-        transferBytes[9];
+/**
+ * @name   eventsPending
+ * @brief  Number of events waiting in the queue.
+ */
+uint32_t iqs7222c_eventsPending(iqs7222c_t *dev)
+{
+    return dev->event_head - dev->event_tail;
+}
+
+/**
+ * @name   getEventStats
+ * @brief  Event queue counters, see iqs7222c_event_stats_t.
+ */
+iqs7222c_event_stats_t iqs7222c_getEventStats(iqs7222c_t *dev)
+{
+    return dev->event_stats;
 }
 
-uint8_t iqs7222c_getTouchByte(bool stopOrRestart)
+uint8_t iqs7222c_getTouchByte(iqs7222c_t *dev, bool stopOrRestart)
 {
     uint8_t transferBytes[2];
     IQS7222C_TOUCH_EVENT_STATES touchData;
-    int retVal = readRandomBytes(IQS7222C_MM_TOUCH_EVENT_STATES, 2, transferBytes, stopOrRestart);
+    int retVal = readRandomBytes(dev, IQS7222C_MM_TOUCH_EVENT_STATES, 2, transferBytes, stopOrRestart);
     touchData.iqs7222c_touch_event_states_lsb = transferBytes[0];
     touchData.iqs7222c_touch_event_states_msb = transferBytes[1];
 #if NRF_LOG_ENABLED
@@ -418,58 +1052,91 @@ uint8_t iqs7222c_getTouchByte(bool stopOrRestart)
     return touchData.iqs7222c_touch_event_states_lsb;
 }
 
-int iqs7222c_getCounts(bool stopOrRestart)
-{
-    uint8_t transferBytes[20];
-    int retVal = readRandomBytes(IQS7222C_MM_CHANNEL_0_COUNTS, 20, transferBytes, stopOrRestart);
-    uint16_t channelCounts[10];
-    channelCounts[0] = (uint16_t)(transferBytes[0]);
-    channelCounts[0] |= (uint16_t)(transferBytes[1] << 8);
-    channelCounts[1] = (uint16_t)(transferBytes[2]);
-    channelCounts[1] |= (uint16_t)(transferBytes[3] << 8);
-    channelCounts[2] = (uint16_t)(transferBytes[4]);
-    channelCounts[2] |= (uint16_t)(transferBytes[5] << 8);
-    channelCounts[3] = (uint16_t)(transferBytes[6]);
-    channelCounts[3] |= (uint16_t)(transferBytes[7] << 8);
-    channelCounts[4] = (uint16_t)(transferBytes[8]);
-    channelCounts[4] |= (uint16_t)(transferBytes[9] << 8);
-    channelCounts[5] = (uint16_t)(transferBytes[10]);
-    channelCounts[5] |= (uint16_t)(transferBytes[11] << 8);
-    channelCounts[6] = (uint16_t)(transferBytes[12]);
-    channelCounts[6] |= (uint16_t)(transferBytes[13] << 8);
-    channelCounts[7] = (uint16_t)(transferBytes[14]);
-    channelCounts[7] |= (uint16_t)(transferBytes[15] << 8);
-
-    NRF_LOG_INFO("Channel count [ %4d, %4d, %4d, %4d, %4d, %4d]", channelCounts[0], channelCounts[1], channelCounts[2], channelCounts[3], channelCounts[4], channelCounts[5]);
-    return retVal;
+/**
+ * @name   getCounts
+ * @brief  Read the counts of all ten channels into the memory map.
+ * @param  stopOrRestart -> Kept for the other read methods, a read always
+ * ends the window.
+ * @retval I2C_TOUCH_SUCCESS or the bus error.
+ * @notes  Decode them with iqs7222c_getTelemetry.
+ */
+int iqs7222c_getCounts(iqs7222c_t *dev, bool stopOrRestart)
+{
+    return readRandomBytes(dev, IQS7222C_MM_CHANNEL_0_COUNTS,
+                           sizeof(dev->memory_map.iqs7222c_channel_counts.buffer),
+                           dev->memory_map.iqs7222c_channel_counts.buffer, stopOrRestart);
+}
+
+/**
+ * @name   getLta
+ * @brief  Read the LTA of all ten channels into the memory map.
+ * @param  stopOrRestart -> Kept for the other read methods, a read always
+ * ends the window.
+ * @retval I2C_TOUCH_SUCCESS or the bus error.
+ * @notes  Decode them with iqs7222c_getTelemetry.
+ */
+int iqs7222c_getLta(iqs7222c_t *dev, bool stopOrRestart)
+{
+    return readRandomBytes(dev, IQS7222C_MM_CHANNEL_0_LTA,
+                           sizeof(dev->memory_map.iqs7222c_channel_lta.buffer),
+                           dev->memory_map.iqs7222c_channel_lta.buffer, stopOrRestart);
 }
 
-int iqs7222c_getLta(bool stopOrRestart)
-{
-    uint8_t transferBytes[20];
-    int retVal = readRandomBytes(IQS7222C_MM_CHANNEL_0_LTA, 20, transferBytes, stopOrRestart);
-    uint16_t channelCounts[10];
-    channelCounts[0] = (uint16_t)(transferBytes[0]);
-    channelCounts[0] |= (uint16_t)(transferBytes[1] << 8);
-    channelCounts[1] = (uint16_t)(transferBytes[2]);
-    channelCounts[1] |= (uint16_t)(transferBytes[3] << 8);
-    channelCounts[2] = (uint16_t)(transferBytes[4]);
-    channelCounts[2] |= (uint16_t)(transferBytes[5] << 8);
-    channelCounts[3] = (uint16_t)(transferBytes[6]);
-    channelCounts[3] |= (uint16_t)(transferBytes[7] << 8);
-    channelCounts[4] = (uint16_t)(transferBytes[8]);
-    channelCounts[4] |= (uint16_t)(transferBytes[9] << 8);
-    channelCounts[5] = (uint16_t)(transferBytes[10]);
-    channelCounts[5] |= (uint16_t)(transferBytes[11] << 8);
-    channelCounts[6] = (uint16_t)(transferBytes[12]);
-    channelCounts[6] |= (uint16_t)(transferBytes[13] << 8);
-    channelCounts[7] = (uint16_t)(transferBytes[14]);
-    channelCounts[7] |= (uint16_t)(transferBytes[15] << 8);
-
-    NRF_LOG_INFO("Channel LTA   [ %4d, %4d, %4d, %4d, %4d, %4d]", channelCounts[0], channelCounts[1], channelCounts[2], channelCounts[3], channelCounts[4], channelCounts[5]);
+/**
+ * @name   readTelemetry
+ * @brief  Read counts and LTA of all ten channels and decode them.
+ * @param  telemetry     -> Caller owned arrays, filled on success.
+ *         stopOrRestart -> Kept for the other read methods, a read always
+ * ends the window.
+ * @retval I2C_TOUCH_SUCCESS or the bus error, telemetry is not touched on
+ * error.
+ * @notes  One 52 byte burst from the counts through the LTA, the 12 bytes
+ * between them are dropped. To stream at the report rate without extra
+ * windows, plan IQS7222C_READ_COUNTS | IQS7222C_READ_LTA instead and call
+ * iqs7222c_getTelemetry after each update.
+ */
+int iqs7222c_readTelemetry(iqs7222c_t *dev, iqs7222c_telemetry_t *telemetry, bool stopOrRestart)
+{
+    uint8_t transferBytes[WINDOW_MAX_BYTES - WINDOW_COUNTS_OFFSET];
+    int retVal = readRandomBytes(dev, IQS7222C_MM_CHANNEL_0_COUNTS, sizeof(transferBytes),
+                                 transferBytes, stopOrRestart);
+
+    if (retVal == I2C_TOUCH_SUCCESS)
+    {
+        memcpy(dev->memory_map.iqs7222c_channel_counts.buffer, transferBytes,
+               sizeof(dev->memory_map.iqs7222c_channel_counts.buffer));
+        memcpy(dev->memory_map.iqs7222c_channel_lta.buffer,
+               &transferBytes[WINDOW_LTA_OFFSET - WINDOW_COUNTS_OFFSET],
+               sizeof(dev->memory_map.iqs7222c_channel_lta.buffer));
+        iqs7222c_getTelemetry(dev, telemetry);
+    }
     return retVal;
 }
 
+/**
+ * @name   getTelemetry
+ * @brief  Decode the counts and LTA last read into the memory map, by the
+ * read plan, iqs7222c_readTelemetry or iqs7222c_getCounts / iqs7222c_getLta.
+ * @param  telemetry -> Caller owned arrays.
+ * @retval None.
+ * @notes  No bus access. Call from the context that runs the updates.
+ */
+void iqs7222c_getTelemetry(iqs7222c_t *dev, iqs7222c_telemetry_t *telemetry)
+{
+    const uint8_t *counts = dev->memory_map.iqs7222c_channel_counts.buffer;
+    const uint8_t *lta = dev->memory_map.iqs7222c_channel_lta.buffer;
+
+    for (uint8_t channel = 0; channel < IQS7222C_CHANNELS; channel++)
+    {
+        uint16_t channelCounts = (uint16_t)(counts[2 * channel] | (counts[2 * channel + 1] << 8));
+        uint16_t channelLta = (uint16_t)(lta[2 * channel] | (lta[2 * channel + 1] << 8));
+
+        telemetry->counts[channel] = channelCounts;
+        telemetry->lta[channel] = channelLta;
+        telemetry->delta[channel] = (int16_t)(channelCounts - channelLta);
+    }
+}
+
 /**
  * @name  iqs7222c_waitForReady
  * @brief  A method which waits for the IQS7222C device to pull the ready pin
@@ -486,7 +1153,7 @@ int iqs7222c_getLta(bool stopOrRestart)
  * The forced/polling method is only recommended if the master must perform I2C
  * and Event Mode is active.
  */
-bool iqs7222c_waitForReady(void)
+bool iqs7222c_waitForReady(iqs7222c_t *dev)
 {
     bool readyLow = false;      // The return value. Set to true if the ready pin is
                                 // pulled low by the IQS7222C within 100ms.
@@ -494,10 +1161,10 @@ bool iqs7222c_waitForReady(void)
                                 // track of how long the request is going on.
 
     // Wait for communication from IQS7222C device. Timeout after 100ms.
-    while (nrf_drv_gpiote_in_is_set(_readyPin))
+    while (i2c_touch_pin_is_set(&dev->bus, dev->ready_pin))
     {
         notReadyCount++;
-        nrf_delay_us(100);
+        i2c_touch_delay_us(&dev->bus, 100);
 
         if ((notReadyCount % 1000) == 0)
             return readyLow;
@@ -517,13 +1184,17 @@ bool iqs7222c_waitForReady(void)
  * the begin function. After new device settings have been reloaded the
  * acknowledge reset function can be used to clear the reset flag.
  */
-bool iqs7222c_checkReset(void)
+bool iqs7222c_checkReset(iqs7222c_t *dev)
 {
 
-    IQSMemoryMap.iqs7222c_info_flags.iqs7222c_infoflags_lsb &= SHOW_RESET_BIT;
+    dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_lsb &= SHOW_RESET_BIT;
     // Return the reset status.
-    if (IQSMemoryMap.iqs7222c_info_flags.iqs7222c_infoflags_lsb != 0)
+    if (dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_lsb != 0)
+    {
+        // Device settings are back at their defaults.
+        dev->shadow_valid = false;
         return true;
+    }
     else
         return false;
 }
@@ -532,15 +1203,14 @@ bool iqs7222c_checkReset(void)
  * @name	checkProductNum
  * @brief  A method which checks the device product number and compare the
  * result to the defined value to return a boolean result.
- * @param  stopOrRestart -> Specifies whether the communications window must be
- * kept open or must be closed after this action. Use the STOP and RESTART
- * definitions.
+ * @param  stopOrRestart -> Kept for the other read methods, a read always
+ * ends the window.
  * @retval Returns true if product number is a match, false if numbers do not
  * match.
  * @notes  If the product is not correctly identified an appropriate messages
  * should be displayed.
  */
-uint16_t iqs7222c_getProductNum(bool stopOrRestart)
+uint16_t iqs7222c_getProductNum(iqs7222c_t *dev, bool stopOrRestart)
 {
     uint8_t
         transferBytes[2];    // A temporary array to hold the byte to be transferred.
@@ -550,7 +1220,7 @@ uint16_t iqs7222c_getProductNum(bool stopOrRestart)
         0; // The 16bit return value.
            // Use an array to be consistent with other methods of the library.
     // Read the Device info from the IQS7222C.
-    readRandomBytes(IQS7222C_MM_PROD_NUM, 2, transferBytes, stopOrRestart);
+    readRandomBytes(dev, IQS7222C_MM_PROD_NUM, 2, transferBytes, stopOrRestart);
 
     // Construct the 16bit return value.
     prodNumLow = transferBytes[0];
@@ -565,12 +1235,11 @@ uint16_t iqs7222c_getProductNum(bool stopOrRestart)
  * @name	getmajorVersion
  * @brief  A method which checks the device firmware version number, major
  * value.
- * @param  stopOrRestart -> Specifies whether the communications window must be
- * kept open or must be closed after this action. Use the STOP and RESTART
- * definitions.
+ * @param  stopOrRestart -> Kept for the other read methods, a read always
+ * ends the window.
  * @retval Returns major version number value.
  */
-uint8_t iqs7222c_getmajorVersion(bool stopOrRestart)
+uint8_t iqs7222c_getmajorVersion(iqs7222c_t *dev, bool stopOrRestart)
 {
     uint8_t
         transferBytes[2]; // A temporary array to hold the byte to be transferred.
@@ -578,7 +1247,7 @@ uint8_t iqs7222c_getmajorVersion(bool stopOrRestart)
         0; // Temporary storage for the firmware version major number.
 
     // Read the Device info from the IQS7222C.
-    readRandomBytes(IQS7222C_MM_MAJOR_VERSION_NUM, 2, transferBytes,
+    readRandomBytes(dev, IQS7222C_MM_MAJOR_VERSION_NUM, 2, transferBytes,
                     stopOrRestart);
 
     // get major value from correct byte
@@ -591,12 +1260,11 @@ uint8_t iqs7222c_getmajorVersion(bool stopOrRestart)
  * @name	getminorVersion
  * @brief  A method which checks the device firmware version number, minor
  * value.
- * @param  stopOrRestart -> Specifies whether the communications window must be
- * kept open or must be closed after this action. Use the STOP and RESTART
- * definitions.
+ * @param  stopOrRestart -> Kept for the other read methods, a read always
+ * ends the window.
  * @retval Returns minor version number value.
  */
-uint8_t iqs7222c_getminorVersion(bool stopOrRestart)
+uint8_t iqs7222c_getminorVersion(iqs7222c_t *dev, bool stopOrRestart)
 {
     uint8_t
         transferBytes[2]; // A temporary array to hold the byte to be transferred.
@@ -604,7 +1272,7 @@ uint8_t iqs7222c_getminorVersion(bool stopOrRestart)
         0; // Temporary storage for the firmware version minor number.
 
     // Read the Device info from the IQS7222C.
-    readRandomBytes(IQS7222C_MM_MINOR_VERSION_NUM, 2, transferBytes,
+    readRandomBytes(dev, IQS7222C_MM_MINOR_VERSION_NUM, 2, transferBytes,
                     stopOrRestart);
 
     // get major value from correct byte
@@ -619,24 +1287,16 @@ uint8_t iqs7222c_getminorVersion(bool stopOrRestart)
  * @param  stopOrRestart -> Specifies whether the communications window must be
  * kept open or must be closed after this action. Use the STOP and RESTART
  * definitions.
- * @retval None.
+ * @retval Transfer result, see iqs7222c_setControlBits.
  * @notes  If a reset has occurred the device settings should be reloaded using
  * the begin function. After new device settings have been reloaded this method
  * should be used to clear the reset bit.
  */
-void iqs7222c_acknowledgeReset(bool stopOrRestart)
+int iqs7222c_acknowledgeReset(iqs7222c_t *dev, bool stopOrRestart)
 {
-    uint8_t transferBytes[2]; // A temporary array to hold the bytes to be
-                              // transferred.
-    // Read the System Flags from the IQS7222C, these must be read first in order
-    // not to change any settings. We are interested in the 2nd byte at the
-    // address location, therefore, we must read and write both bytes.
-    readRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferBytes, RESTART);
-    // SWrite the AAck Reset bit to 1 to clear the Show Reset Flag.
-    transferBytes[0] |= ACK_RESET_BIT;
-    // Write the new byte to the System Flags address.
-    writeRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferBytes,
-                     stopOrRestart);
+    // Write the Ack Reset bit to 1 to clear the Show Reset Flag, the other
+    // control settings are preserved.
+    return iqs7222c_setControlBits(dev, ACK_RESET_BIT, stopOrRestart);
 }
 
 /**
@@ -646,33 +1306,46 @@ void iqs7222c_acknowledgeReset(bool stopOrRestart)
  * @param  stopOrRestart -> Specifies whether the communications window must be
  * kept open or must be closed after this action. Use the STOP and RESTART
  * definitions.
- * @retval None.
+ * @retval Transfer result, see iqs7222c_setControlBits.
  * @notes  To force ATI, bit 4 in PROX_SETTINGS_0 is set. PROX_SETTINGS_0 is
  * byte 0 in the PROXSETTINGS_0_1 address.
  */
-void iqs7222c_TP_ReATI(bool stopOrRestart)
+int iqs7222c_TP_ReATI(iqs7222c_t *dev, bool stopOrRestart)
+{
+    // This is the bit required to start an ATI routine.
+    return iqs7222c_setControlBits(dev, TP_REATI_BIT, stopOrRestart);
+}
+
+int iqs7222c_reSeed(iqs7222c_t *dev, bool stopOrRestart)
 {
-    uint8_t transferByte[2]; // Array to store the bytes transferred.
-                             // Use an array to be consistent with other methods
-                             // in this class.
-    readRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferByte, RESTART);
-    // Mask the settings with the REDO_ATI_BIT.
-    transferByte[0] |=
-        TP_REATI_BIT; // This is the bit required to start an ATI routine.
-    // Write the new byte to the required device.
-    writeRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferByte,
-                     stopOrRestart);
+    return iqs7222c_setControlBits(dev, TP_RESEED_BIT, stopOrRestart);
 }
 
-void iqs7222c_reSeed(bool stopOrRestart)
+/**
+ * @name   setControlBits
+ * @brief  Set any combination of the control settings action bits
+ * (ACK_RESET_BIT, TP_REATI_BIT, TP_RESEED_BIT, ...) with one write.
+ * @param  controlBits   -> Bits to set in the low byte of CONTROL_SETTINGS.
+ *         stopOrRestart -> Specifies whether the communications window must be
+ * kept open or must be closed after this action. Use the STOP and RESTART
+ * definitions.
+ * @retval Transfer result.
+ */
+int iqs7222c_setControlBits(iqs7222c_t *dev, uint8_t controlBits, bool stopOrRestart)
 {
-    uint8_t transferByte[2]; // Array to store the bytes transferred.
-                             // Use an array to be consistent with other methods
-                             // in this class.
-    readRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferByte, RESTART);
-    transferByte[0] |= TP_RESEED_BIT;
-    writeRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferByte,
-                     stopOrRestart);
+    uint8_t transferBytes[2];
+    int retCode = readControlSettings(dev, transferBytes);
+    if (retCode != I2C_TOUCH_SUCCESS)
+    {
+        return retCode;
+    }
+    transferBytes[0] |= controlBits;
+    retCode = writeRandomBytes(dev, IQS7222C_MM_CONTROL_SETTINGS, 2, transferBytes, stopOrRestart);
+    if (controlBits & SW_RESET_BIT)
+    {
+        dev->shadow_valid = false;
+    }
+    return retCode;
 }
 
 /**
@@ -682,20 +1355,14 @@ void iqs7222c_reSeed(bool stopOrRestart)
  * @param  stopOrRestart -> Specifies whether the communications window must be
  * kept open or must be closed after this action. Use the STOP and RESTART
  * definitions.
- * @retval None.
+ * @retval Transfer result, see iqs7222c_setControlBits.
  * @notes  To perform SW Reset, bit 9 in SYSTEM_CONTROL is set.
  */
-void iqs7222c_SW_Reset(bool stopOrRestart)
+int iqs7222c_SW_Reset(iqs7222c_t *dev, bool stopOrRestart)
 {
-    uint8_t transferByte[2]; // Array to store the bytes transferred.
-                             // Use an array to be consistent with other methods
-                             // in this class.
-    readRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferByte, RESTART);
-    // Mask the settings with the SW_RESET_BIT.
-    transferByte[0] |= SW_RESET_BIT; // This is the bit required to perform SW Reset.
-    // Write the new byte to the required device.
-    writeRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferByte,
-                     stopOrRestart);
+    // This is the bit required to perform SW Reset. The device comes back
+    // with default settings, the shadow is invalidated.
+    return iqs7222c_setControlBits(dev, SW_RESET_BIT, stopOrRestart);
 }
 
 /**
@@ -704,21 +1371,12 @@ void iqs7222c_SW_Reset(bool stopOrRestart)
  * @param  stopOrRestart -> Specifies whether the communications window must be
  * kept open or must be closed after this action. Use the STOP and RESTART
  * definitions.
- * @retval None.
+ * @retval Transfer result, see iqs7222c_setControlBits.
  * @notes  All other bits at the register address are preserved.
  */
-void iqs7222c_setEventMode(bool stopOrRestart)
+int iqs7222c_setEventMode(iqs7222c_t *dev, bool stopOrRestart)
 {
-    uint8_t transferBytes[2]; // The array which will hold the bytes which are
-                              // transferred.
-
-    // First read the bytes at the memory address so that they can be preserved.
-    readRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferBytes, RESTART);
-    // Clear the EVENT_MODE_BIT in PROX_SETTINGS_1
-    transferBytes[0] |= EVENT_MODE_BIT;
-    // Write the bytes back to the device
-    writeRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferBytes,
-                     stopOrRestart);
+    return iqs7222c_setControlBits(dev, EVENT_MODE_BIT, stopOrRestart);
 }
 
 /**
@@ -728,44 +1386,34 @@ void iqs7222c_setEventMode(bool stopOrRestart)
  * @param  stopOrRestart -> Specifies whether the communications window must be
  * kept open or must be closed after this action. Use the STOP and RESTART
  * definitions.
- * @retval None.
+ * @retval Transfer result, see iqs7222c_setControlBits.
  * @notes  All other bits at the register address are preserved.
  */
-void iqs7222c_setStreamInTouch(bool stopOrRestart)
+int iqs7222c_setStreamInTouch(iqs7222c_t *dev, bool stopOrRestart)
 {
-    uint8_t transferBytes[2]; // The array which will hold the bytes which are
-                              // transferred.
-
-    // First read the bytes at the memory address so that they can be preserved.
-    readRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferBytes, RESTART);
-    // Set the STREAM_IN_TOUCH_BIT in CONTROL_SETTINGS
-    transferBytes[0] |= STREAM_IN_TOUCH_BIT;
-    // Write the bytes back to the device
-    writeRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 2, transferBytes,
-                     stopOrRestart);
+    return iqs7222c_setControlBits(dev, STREAM_IN_TOUCH_BIT, stopOrRestart);
 }
 
 /**
  * @name   updateInfoFlags
  * @brief  A method which reads the IQS7222C info flags and assigns them to the
  * infoFlags union.
- * @param  stopOrRestart -> Specifies whether the communications window must be
- * kept open or must be closed after this action. Use the STOP and RESTART
- * definitions.
+ * @param  stopOrRestart -> Kept for the other read methods, a read always
+ * ends the window.
  * @retval None.
  * @notes  The infoFlags union is altered with the new value of the info flags
  * register.
  */
-void iqs7222c_updateInfoFlags(bool stopOrRestart)
+void iqs7222c_updateInfoFlags(iqs7222c_t *dev, bool stopOrRestart)
 {
     uint8_t transferBytes[8]; // The array which will hold the bytes to be
                               // transferred.
 
     // Read the info flags.
-    readRandomBytes(IQS7222C_MM_INFOFLAGS, 8, transferBytes, stopOrRestart);
+    readRandomBytes(dev, IQS7222C_MM_INFOFLAGS, 8, transferBytes, stopOrRestart);
     // Assign the info flags to the info flags union.
-    IQSMemoryMap.iqs7222c_info_flags.iqs7222c_infoflags_lsb = transferBytes[0];
-    IQSMemoryMap.iqs7222c_info_flags.iqs7222c_infoflags_msb = transferBytes[1];
+    dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_lsb = transferBytes[0];
+    dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_msb = transferBytes[1];
 }
 
 /**
@@ -777,9 +1425,9 @@ void iqs7222c_updateInfoFlags(bool stopOrRestart)
  * @notes  See Datasheet on power mode options and timeouts. Normal Power, Low
  * Power and Ultra Low Power (ULP).
  */
-IQS7222C_power_modes iqs7222c_get_PowerMode(void)
+IQS7222C_power_modes iqs7222c_get_PowerMode(iqs7222c_t *dev)
 {
-    uint8_t buffer = IQSMemoryMap.iqs7222c_info_flags.power_mode;
+    uint8_t buffer = dev->memory_map.iqs7222c_info_flags.power_mode;
 
     if (buffer == NORMAL_POWER_BIT)
     {
@@ -805,125 +1453,11 @@ IQS7222C_power_modes iqs7222c_get_PowerMode(void)
  * touch state needs to be determined.
  * @retval Returns true is a touch is avtive and false if there is no touch.
  * @notes  See the IQS7222C_Channel_e typedef for all possible channel names.
+ * To look at several channels use iqs7222c_touchMask.
  */
-bool iqs7222c_channel_touchState(IQS7222C_Channel_e channel)
+bool iqs7222c_channel_touchState(iqs7222c_t *dev, IQS7222C_Channel_e channel)
 {
-    switch (channel)
-    {
-    case IQS7222C_CH0:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch0_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH1:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch1_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH2:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch2_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH3:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch3_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH4:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch4_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH5:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch5_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH6:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch6_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH7:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch7_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH8:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch8_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH9:
-        if (IQSMemoryMap.iqs7222c_touch_event_states.ch9_touch_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    default:
-        return false;
-        break;
-    }
+    return (iqs7222c_touchMask(dev) >> channel) & 1u;
 }
 
 /**
@@ -935,125 +1469,85 @@ bool iqs7222c_channel_touchState(IQS7222C_Channel_e channel)
  * @retval Returns true is proximity is avtive and false if there is no
  * proximity.
  * @notes  See the IQS7222C_Channel_e typedef for all possible channel names.
+ * To look at several channels use iqs7222c_proxMask.
  */
-bool iqs7222c_channel_proxState(IQS7222C_Channel_e channel)
+bool iqs7222c_channel_proxState(iqs7222c_t *dev, IQS7222C_Channel_e channel)
 {
-    switch (channel)
-    {
-    case IQS7222C_CH0:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch0_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH1:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch1_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH2:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch2_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH3:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch3_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH4:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch4_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
-
-    case IQS7222C_CH5:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch5_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
+    return (iqs7222c_proxMask(dev) >> channel) & 1u;
+}
 
-    case IQS7222C_CH6:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch6_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
+/**
+ * @name   touchMask
+ * @brief  Touch state of all channels, bit n for IQS7222C_CHn.
+ * @retval 10 bit mask from the last decoded status burst.
+ * @notes  Walk the set bits with iqs7222c_nextChannel.
+ */
+uint16_t iqs7222c_touchMask(iqs7222c_t *dev)
+{
+    return FRAME_WORD(dev, touch);
+}
 
-    case IQS7222C_CH7:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch7_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
+/**
+ * @name   proxMask
+ * @brief  Prox state of all channels, bit n for IQS7222C_CHn.
+ * @retval 10 bit mask from the last decoded status burst.
+ */
+uint16_t iqs7222c_proxMask(iqs7222c_t *dev)
+{
+    return FRAME_WORD(dev, prox);
+}
 
-    case IQS7222C_CH8:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch8_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
+/**
+ * @name   getChannelMasks
+ * @brief  Touch and prox masks with the bits that changed in the last
+ * decoded window, see iqs7222c_channel_masks_t.
+ * @notes  Touched channels that just went down are
+ * masks.touch & masks.touch_changed, released ones
+ * ~masks.touch & masks.touch_changed.
+ */
+iqs7222c_channel_masks_t iqs7222c_getChannelMasks(iqs7222c_t *dev)
+{
+    iqs7222c_frame_t frame;
+
+    iqs7222c_readFrame(dev, &frame);
+    iqs7222c_channel_masks_t masks = {
+        .touch = frame.touch,
+        .prox = frame.prox,
+        .touch_changed = frame.touch_changed,
+        .prox_changed = frame.prox_changed,
+    };
+    return masks;
+}
 
-    case IQS7222C_CH9:
-        if (IQSMemoryMap.iqs7222c_prox_event_states.ch9_prox_event == 1)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-        break;
+/**
+ * @name   readFrame
+ * @brief  Copy the last decoded window as one consistent frame.
+ * @param  frame -> Destination.
+ * @retval Number of frames published since iqs7222c_begin, compare with the
+ * previous return value to tell a new frame.
+ * @notes  Never disables interrupts and never blocks the decoder. The
+ * decoder fills the back buffer and then flips the sequence counter, so a
+ * copy is only retried when the decoder finished one frame and started
+ * overwriting this buffer with the next while it was being read. Safe from
+ * any context that does not interrupt the decoder.
+ */
+uint32_t iqs7222c_readFrame(iqs7222c_t *dev, iqs7222c_frame_t *frame)
+{
+    uint32_t start;
+    uint32_t end;
 
-    default:
-        return false;
-        break;
-    }
+    do
+    {
+        start = dev->frame_seq;
+        FRAME_READ_BARRIER();
+        *frame = dev->frames[(start >> 1) & 1u];
+        FRAME_READ_BARRIER();
+        end = dev->frame_seq;
+        // The buffer read is rewritten once the sequence reaches
+        // (start & ~1) + 3.
+    } while (end - (start & ~1u) > 2u);
+
+    return start >> 1;
 }
 
 /**
@@ -1065,23 +1559,31 @@ bool iqs7222c_channel_proxState(IQS7222C_Channel_e channel)
  * to the resulution maximum.
  * @notes  See the IQS7222C_slider_e typedef for all possible slider names.
  */
-uint16_t iqs7222c_silderCoordinate(IQS7222C_slider_e slider)
+uint16_t iqs7222c_silderCoordinate(iqs7222c_t *dev, IQS7222C_slider_e slider)
 {
-    uint16_t buffer;
-    if (slider == IQS7222C_SLIDER0)
-    {
-        buffer = IQSMemoryMap.iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_lsb;
-        buffer += IQSMemoryMap.iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_msb
-                  << 8;
-        return buffer;
-    }
-    else
+    return FRAME_WORD(dev, slider[(slider == IQS7222C_SLIDER0) ? 0 : 1]);
+}
+
+/**
+ * @name   wheelResolution
+ * @brief  Coordinate of one full turn of a slider set up as a wheel, for
+ * iqs7222c_wheel_default_config.
+ * @param  slider -> The slider name on the IQS7222C (Slider 0 or Slider 1).
+ * @retval The resolution from the slider setup, 0 if the slider is not a
+ * wheel or the settings are not known yet.
+ * @notes  Read from the shadow of the written settings, no bus access.
+ */
+uint16_t iqs7222c_wheelResolution(iqs7222c_t *dev, IQS7222C_slider_e slider)
+{
+    uint16_t setup = (slider == IQS7222C_SLIDER0) ? IQS7222C_MM_SLIDER_SETUP_0 : IQS7222C_MM_SLIDER_SETUP_1;
+    int general = shadowOffset(setup, true);
+    int resolution = shadowOffset(setup + IQS7222C_SLIDER_RESOLUTION_WORD, true);
+
+    if (!dev->shadow_valid || !(dev->shadow[general] & IQS7222C_SLIDER_WHEEL_ENABLE))
     {
-        buffer = IQSMemoryMap.iqs7222c_slider_wheel_out.iqs7222c_slider_1_out_lsb;
-        buffer += IQSMemoryMap.iqs7222c_slider_wheel_out.iqs7222c_slider_1_out_msb
-                  << 8;
-        return buffer;
+        return 0;
     }
+    return dev->shadow[resolution] | ((uint16_t)dev->shadow[resolution + 1] << 8);
 }
 /**************************************************************************************************************/
 /*											ADVANCED
@@ -1094,472 +1596,191 @@ uint16_t iqs7222c_silderCoordinate(IQS7222C_slider_e slider)
  * @brief  Function to write the whole memory map to the device (writable)
  * registers
  * @param  IQS7222CA_init.h -> exported GUI init.h file
- * @retval None.
- * @notes
- */
-int iqs7222c_writeMM(bool stopOrRestart)
-{
-    int returnValue = 0;
-    uint8_t transferBytes[30]; // Temporary array which holds the bytes to be
-                               // transferred.
-
-    /* Change the Cycle Setup */
-    /* Memory Map Position 0x8000 - 0x8403 */
-    transferBytes[0] = CYCLE_0_CONV_FREQ_FRAC;
-    transferBytes[1] = CYCLE_0_CONV_FREQ_PERIOD;
-    transferBytes[2] = CYCLE_0_SETTINGS;
-    transferBytes[3] = CYCLE_0_CTX_SELECT;
-    transferBytes[4] = CYCLE_0_IREF_0;
-    transferBytes[5] = CYCLE_0_IREF_1;
-    transferBytes[6] = CYCLE_1_CONV_FREQ_FRAC;
-    transferBytes[7] = CYCLE_1_CONV_FREQ_PERIOD;
-    transferBytes[8] = CYCLE_1_SETTINGS;
-    transferBytes[9] = CYCLE_1_CTX_SELECT;
-    transferBytes[10] = CYCLE_1_IREF_0;
-    transferBytes[11] = CYCLE_1_IREF_1;
-    transferBytes[12] = CYCLE_2_CONV_FREQ_FRAC;
-    transferBytes[13] = CYCLE_2_CONV_FREQ_PERIOD;
-    transferBytes[14] = CYCLE_2_SETTINGS;
-    transferBytes[15] = CYCLE_2_CTX_SELECT;
-    transferBytes[16] = CYCLE_2_IREF_0;
-    transferBytes[17] = CYCLE_2_IREF_1;
-    transferBytes[18] = CYCLE_3_CONV_FREQ_FRAC;
-    transferBytes[19] = CYCLE_3_CONV_FREQ_PERIOD;
-    transferBytes[20] = CYCLE_3_SETTINGS;
-    transferBytes[21] = CYCLE_3_CTX_SELECT;
-    transferBytes[22] = CYCLE_3_IREF_0;
-    transferBytes[23] = CYCLE_3_IREF_1;
-    transferBytes[24] = CYCLE_4_CONV_FREQ_FRAC;
-    transferBytes[25] = CYCLE_4_CONV_FREQ_PERIOD;
-    transferBytes[26] = CYCLE_4_SETTINGS;
-    transferBytes[27] = CYCLE_4_CTX_SELECT;
-    transferBytes[28] = CYCLE_4_IREF_0;
-    transferBytes[29] = CYCLE_4_IREF_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CYCLE_SETUP_0, 30, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t1. Write Cycle Settings");
-
-    /* Change the Global Cycle Setup */
-    /* Memory Map Position 0x8500 - 0x8502 */
-    transferBytes[0] = GLOBAL_CYCLE_SETUP_0;
-    transferBytes[1] = GLOBAL_CYCLE_SETUP_1;
-    transferBytes[2] = COARSE_DIVIDER_PRELOAD;
-    transferBytes[3] = FINE_DIVIDER_PRELOAD;
-    transferBytes[4] = COMPENSATION_PRELOAD_0;
-    transferBytes[5] = COMPENSATION_PRELOAD_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_GLOBAL_CYCLE_SETUP, 6, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t2. Write Global Cycle Settings");
-
-    /* Change the Button Setup 0 - 4 */
-    /* Memory Map Position 0x9000 - 0x9502 */
-    transferBytes[0] = BUTTON_0_PROX_THRESHOLD;
-    transferBytes[1] = BUTTON_0_ENTER_EXIT;
-    transferBytes[2] = BUTTON_0_TOUCH_THRESHOLD;
-    transferBytes[3] = BUTTON_0_TOUCH_HYSTERESIS;
-    transferBytes[4] = BUTTON_0_PROX_EVENT_TIMEOUT;
-    transferBytes[5] = BUTTON_0_TOUCH_EVENT_TIMEOUT;
-    transferBytes[6] = BUTTON_1_PROX_THRESHOLD;
-    transferBytes[7] = BUTTON_1_ENTER_EXIT;
-    transferBytes[8] = BUTTON_1_TOUCH_THRESHOLD;
-    transferBytes[9] = BUTTON_1_TOUCH_HYSTERESIS;
-    transferBytes[10] = BUTTON_1_PROX_EVENT_TIMEOUT;
-    transferBytes[11] = BUTTON_1_TOUCH_EVENT_TIMEOUT;
-    transferBytes[12] = BUTTON_2_PROX_THRESHOLD;
-    transferBytes[13] = BUTTON_2_ENTER_EXIT;
-    transferBytes[14] = BUTTON_2_TOUCH_THRESHOLD;
-    transferBytes[15] = BUTTON_2_TOUCH_HYSTERESIS;
-    transferBytes[16] = BUTTON_2_PROX_EVENT_TIMEOUT;
-    transferBytes[17] = BUTTON_2_TOUCH_EVENT_TIMEOUT;
-    transferBytes[18] = BUTTON_3_PROX_THRESHOLD;
-    transferBytes[19] = BUTTON_3_ENTER_EXIT;
-    transferBytes[20] = BUTTON_3_TOUCH_THRESHOLD;
-    transferBytes[21] = BUTTON_3_TOUCH_HYSTERESIS;
-    transferBytes[22] = BUTTON_3_PROX_EVENT_TIMEOUT;
-    transferBytes[23] = BUTTON_3_TOUCH_EVENT_TIMEOUT;
-    transferBytes[24] = BUTTON_4_PROX_THRESHOLD;
-    transferBytes[25] = BUTTON_4_ENTER_EXIT;
-    transferBytes[26] = BUTTON_4_TOUCH_THRESHOLD;
-    transferBytes[27] = BUTTON_4_TOUCH_HYSTERESIS;
-    transferBytes[28] = BUTTON_4_PROX_EVENT_TIMEOUT;
-    transferBytes[29] = BUTTON_4_TOUCH_EVENT_TIMEOUT;
-    returnValue += writeRandomBytes16(IQS7222C_MM_BUTTON_SETUP_0, 30, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t3. Write Button Settings 0 - 4");
-
-    /* Change the Button Setup 5 - 9 */
-    /* Memory Map Position 0x9500 - 0x9902 */
-    transferBytes[0] = BUTTON_5_PROX_THRESHOLD;
-    transferBytes[1] = BUTTON_5_ENTER_EXIT;
-    transferBytes[2] = BUTTON_5_TOUCH_THRESHOLD;
-    transferBytes[3] = BUTTON_5_TOUCH_HYSTERESIS;
-    transferBytes[4] = BUTTON_5_PROX_EVENT_TIMEOUT;
-    transferBytes[5] = BUTTON_5_TOUCH_EVENT_TIMEOUT;
-    transferBytes[6] = BUTTON_6_PROX_THRESHOLD;
-    transferBytes[7] = BUTTON_6_ENTER_EXIT;
-    transferBytes[8] = BUTTON_6_TOUCH_THRESHOLD;
-    transferBytes[9] = BUTTON_6_TOUCH_HYSTERESIS;
-    transferBytes[10] = BUTTON_6_PROX_EVENT_TIMEOUT;
-    transferBytes[11] = BUTTON_6_TOUCH_EVENT_TIMEOUT;
-    transferBytes[12] = BUTTON_7_PROX_THRESHOLD;
-    transferBytes[13] = BUTTON_7_ENTER_EXIT;
-    transferBytes[14] = BUTTON_7_TOUCH_THRESHOLD;
-    transferBytes[15] = BUTTON_7_TOUCH_HYSTERESIS;
-    transferBytes[16] = BUTTON_7_PROX_EVENT_TIMEOUT;
-    transferBytes[17] = BUTTON_7_TOUCH_EVENT_TIMEOUT;
-    transferBytes[18] = BUTTON_8_PROX_THRESHOLD;
-    transferBytes[19] = BUTTON_8_ENTER_EXIT;
-    transferBytes[20] = BUTTON_8_TOUCH_THRESHOLD;
-    transferBytes[21] = BUTTON_8_TOUCH_HYSTERESIS;
-    transferBytes[22] = BUTTON_8_PROX_EVENT_TIMEOUT;
-    transferBytes[23] = BUTTON_8_TOUCH_EVENT_TIMEOUT;
-    transferBytes[24] = BUTTON_9_PROX_THRESHOLD;
-    transferBytes[25] = BUTTON_9_ENTER_EXIT;
-    transferBytes[26] = BUTTON_9_TOUCH_THRESHOLD;
-    transferBytes[27] = BUTTON_9_TOUCH_HYSTERESIS;
-    transferBytes[28] = BUTTON_9_PROX_EVENT_TIMEOUT;
-    transferBytes[29] = BUTTON_9_TOUCH_EVENT_TIMEOUT;
-    returnValue += writeRandomBytes16(IQS7222C_MM_BUTTON_SETUP_5, 30, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t4. Write Button Settings 5 - 9");
-
-    /* Change the CH0 Setup */
-    /* Memory Map Position 0xA000 - 0xA005 */
-    transferBytes[0] = CH0_SETUP_0;
-    transferBytes[1] = CH0_SETUP_1;
-    transferBytes[2] = CH0_ATI_SETTINGS_0;
-    transferBytes[3] = CH0_ATI_SETTINGS_1;
-    transferBytes[4] = CH0_MULTIPLIERS_0;
-    transferBytes[5] = CH0_MULTIPLIERS_1;
-    transferBytes[6] = CH0_ATI_COMPENSATION_0;
-    transferBytes[7] = CH0_ATI_COMPENSATION_1;
-    transferBytes[8] = CH0_REF_PTR_0;
-    transferBytes[9] = CH0_REF_PTR_1;
-    transferBytes[10] = CH0_REFMASK_0;
-    transferBytes[11] = CH0_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_0, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t5. Write Channel 0 Settings");
-
-    /* Change the CH1 Setup */
-    /* Memory Map Position 0xA100 - 0xA105 */
-    transferBytes[0] = CH1_SETUP_0;
-    transferBytes[1] = CH1_SETUP_1;
-    transferBytes[2] = CH1_ATI_SETTINGS_0;
-    transferBytes[3] = CH1_ATI_SETTINGS_1;
-    transferBytes[4] = CH1_MULTIPLIERS_0;
-    transferBytes[5] = CH1_MULTIPLIERS_1;
-    transferBytes[6] = CH1_ATI_COMPENSATION_0;
-    transferBytes[7] = CH1_ATI_COMPENSATION_1;
-    transferBytes[8] = CH1_REF_PTR_0;
-    transferBytes[9] = CH1_REF_PTR_1;
-    transferBytes[10] = CH1_REFMASK_0;
-    transferBytes[11] = CH1_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_1, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t6. Write Channel 1 Settings");
-
-    /* Change the CH2 Setup */
-    /* Memory Map Position 0xA200 - 0xA205 */
-    transferBytes[0] = CH2_SETUP_0;
-    transferBytes[1] = CH2_SETUP_1;
-    transferBytes[2] = CH2_ATI_SETTINGS_0;
-    transferBytes[3] = CH2_ATI_SETTINGS_1;
-    transferBytes[4] = CH2_MULTIPLIERS_0;
-    transferBytes[5] = CH2_MULTIPLIERS_1;
-    transferBytes[6] = CH2_ATI_COMPENSATION_0;
-    transferBytes[7] = CH2_ATI_COMPENSATION_1;
-    transferBytes[8] = CH2_REF_PTR_0;
-    transferBytes[9] = CH2_REF_PTR_1;
-    transferBytes[10] = CH2_REFMASK_0;
-    transferBytes[11] = CH2_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_2, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t7. Write Channel 2 Settings");
-
-    /* Change the CH3 Setup */
-    /* Memory Map Position 0xA300 - 0xA305 */
-    transferBytes[0] = CH3_SETUP_0;
-    transferBytes[1] = CH3_SETUP_1;
-    transferBytes[2] = CH3_ATI_SETTINGS_0;
-    transferBytes[3] = CH3_ATI_SETTINGS_1;
-    transferBytes[4] = CH3_MULTIPLIERS_0;
-    transferBytes[5] = CH3_MULTIPLIERS_1;
-    transferBytes[6] = CH3_ATI_COMPENSATION_0;
-    transferBytes[7] = CH3_ATI_COMPENSATION_1;
-    transferBytes[8] = CH3_REF_PTR_0;
-    transferBytes[9] = CH3_REF_PTR_1;
-    transferBytes[10] = CH3_REFMASK_0;
-    transferBytes[11] = CH3_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_3, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t8. Write Channel 3 Settings");
-
-    /* Change the CH4 Setup */
-    /* Memory Map Position 0xA400 - 0xA405 */
-    transferBytes[0] = CH4_SETUP_0;
-    transferBytes[1] = CH4_SETUP_1;
-    transferBytes[2] = CH4_ATI_SETTINGS_0;
-    transferBytes[3] = CH4_ATI_SETTINGS_1;
-    transferBytes[4] = CH4_MULTIPLIERS_0;
-    transferBytes[5] = CH4_MULTIPLIERS_1;
-    transferBytes[6] = CH4_ATI_COMPENSATION_0;
-    transferBytes[7] = CH4_ATI_COMPENSATION_1;
-    transferBytes[8] = CH4_REF_PTR_0;
-    transferBytes[9] = CH4_REF_PTR_1;
-    transferBytes[10] = CH4_REFMASK_0;
-    transferBytes[11] = CH4_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_4, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t9. Write Channel 4 Settings");
-
-    /* Change the CH5 Setup */
-    /* Memory Map Position 0xA500 - 0xA505 */
-    transferBytes[0] = CH5_SETUP_0;
-    transferBytes[1] = CH5_SETUP_1;
-    transferBytes[2] = CH5_ATI_SETTINGS_0;
-    transferBytes[3] = CH5_ATI_SETTINGS_1;
-    transferBytes[4] = CH5_MULTIPLIERS_0;
-    transferBytes[5] = CH5_MULTIPLIERS_1;
-    transferBytes[6] = CH5_ATI_COMPENSATION_0;
-    transferBytes[7] = CH5_ATI_COMPENSATION_1;
-    transferBytes[8] = CH5_REF_PTR_0;
-    transferBytes[9] = CH5_REF_PTR_1;
-    transferBytes[10] = CH5_REFMASK_0;
-    transferBytes[11] = CH5_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_5, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t10. Write Channel 5 Settings");
-
-    /* Change the CH6 Setup */
-    /* Memory Map Position 0xA600 - 0xA605 */
-    transferBytes[0] = CH6_SETUP_0;
-    transferBytes[1] = CH6_SETUP_1;
-    transferBytes[2] = CH6_ATI_SETTINGS_0;
-    transferBytes[3] = CH6_ATI_SETTINGS_1;
-    transferBytes[4] = CH6_MULTIPLIERS_0;
-    transferBytes[5] = CH6_MULTIPLIERS_1;
-    transferBytes[6] = CH6_ATI_COMPENSATION_0;
-    transferBytes[7] = CH6_ATI_COMPENSATION_1;
-    transferBytes[8] = CH6_REF_PTR_0;
-    transferBytes[9] = CH6_REF_PTR_1;
-    transferBytes[10] = CH6_REFMASK_0;
-    transferBytes[11] = CH6_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_6, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t11. Write Channel 6 Settings");
-
-    /* Change the CH7 Setup */
-    /* Memory Map Position 0xA700 - 0xA705 */
-    transferBytes[0] = CH7_SETUP_0;
-    transferBytes[1] = CH7_SETUP_1;
-    transferBytes[2] = CH7_ATI_SETTINGS_0;
-    transferBytes[3] = CH7_ATI_SETTINGS_1;
-    transferBytes[4] = CH7_MULTIPLIERS_0;
-    transferBytes[5] = CH7_MULTIPLIERS_1;
-    transferBytes[6] = CH7_ATI_COMPENSATION_0;
-    transferBytes[7] = CH7_ATI_COMPENSATION_1;
-    transferBytes[8] = CH7_REF_PTR_0;
-    transferBytes[9] = CH7_REF_PTR_1;
-    transferBytes[10] = CH7_REFMASK_0;
-    transferBytes[11] = CH7_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_7, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t12. Write Channel 7 Settings");
-
-    /* Change the CH8 Setup */
-    /* Memory Map Position 0xA800 - 0xA805 */
-    transferBytes[0] = CH8_SETUP_0;
-    transferBytes[1] = CH8_SETUP_1;
-    transferBytes[2] = CH8_ATI_SETTINGS_0;
-    transferBytes[3] = CH8_ATI_SETTINGS_1;
-    transferBytes[4] = CH8_MULTIPLIERS_0;
-    transferBytes[5] = CH8_MULTIPLIERS_1;
-    transferBytes[6] = CH8_ATI_COMPENSATION_0;
-    transferBytes[7] = CH8_ATI_COMPENSATION_1;
-    transferBytes[8] = CH8_REF_PTR_0;
-    transferBytes[9] = CH8_REF_PTR_1;
-    transferBytes[10] = CH8_REFMASK_0;
-    transferBytes[11] = CH8_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_8, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t13. Write Channel 8 Settings");
-
-    /* Change the CH9 Setup */
-    /* Memory Map Position 0xA900 - 0xA905 */
-    transferBytes[0] = CH9_SETUP_0;
-    transferBytes[1] = CH9_SETUP_1;
-    transferBytes[2] = CH9_ATI_SETTINGS_0;
-    transferBytes[3] = CH9_ATI_SETTINGS_1;
-    transferBytes[4] = CH9_MULTIPLIERS_0;
-    transferBytes[5] = CH9_MULTIPLIERS_1;
-    transferBytes[6] = CH9_ATI_COMPENSATION_0;
-    transferBytes[7] = CH9_ATI_COMPENSATION_1;
-    transferBytes[8] = CH9_REF_PTR_0;
-    transferBytes[9] = CH9_REF_PTR_1;
-    transferBytes[10] = CH9_REFMASK_0;
-    transferBytes[11] = CH9_REFMASK_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_CHANNEL_SETUP_9, 12, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t14. Write Channel 9 Settings");
-
-    /* Change the Filter Betas */
-    /* Memory Map Position 0xAA00 - 0xAA01 */
-    transferBytes[0] = COUNTS_BETA_FILTER;
-    transferBytes[1] = LTA_BETA_FILTER;
-    transferBytes[2] = LTA_FAST_BETA_FILTER;
-    transferBytes[3] = RESERVED_FILTER_0;
-    returnValue += writeRandomBytes16(IQS7222C_MM_FILTER_BETAS, 4, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t15. Write Filter Betas");
-
-    /* Change the Slider/Wheel 0 Setup 0 & Delta Link */
-    /* Memory Map Position 0xB000 - 0xB009 */
-    transferBytes[0] = SLIDER0SETUP_GENERAL;
-    transferBytes[1] = SLIDER0_LOWER_CAL;
-    transferBytes[2] = SLIDER0_UPPER_CAL;
-    transferBytes[3] = SLIDER0_BOTTOM_SPEED;
-    transferBytes[4] = SLIDER0_TOPSPEED_0;
-    transferBytes[5] = SLIDER0_TOPSPEED_1;
-    transferBytes[6] = SLIDER0_RESOLUTION_0;
-    transferBytes[7] = SLIDER0_RESOLUTION_1;
-    transferBytes[8] = SLIDER0_ENABLE_MASK_0_7;
-    transferBytes[9] = SLIDER0_ENABLE_MASK_8_9;
-    transferBytes[10] = SLIDER0_ENABLESTATUSLINK_0;
-    transferBytes[11] = SLIDER0_ENABLESTATUSLINK_1;
-    transferBytes[12] = SLIDER0_DELTA0_0;
-    transferBytes[13] = SLIDER0_DELTA0_1;
-    transferBytes[14] = SLIDER0_DELTA1_0;
-    transferBytes[15] = SLIDER0_DELTA1_1;
-    transferBytes[16] = SLIDER0_DELTA2_0;
-    transferBytes[17] = SLIDER0_DELTA2_1;
-    transferBytes[18] = SLIDER0_DELTA3_0;
-    transferBytes[19] = SLIDER0_DELTA3_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_SLIDER_SETUP_0, 20, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t16. Slider/Wheel 0 Settings");
-
-    /* Change the Slider/Wheel 1 Setup 0 */
-    /* Memory Map Position 0xB100 - 0xB105 */
-    transferBytes[0] = SLIDER1SETUP_GENERAL;
-    transferBytes[1] = SLIDER1_LOWER_CAL;
-    transferBytes[2] = SLIDER1_UPPER_CAL;
-    transferBytes[3] = SLIDER1_BOTTOM_SPEED;
-    transferBytes[4] = SLIDER1_TOPSPEED_0;
-    transferBytes[5] = SLIDER1_TOPSPEED_1;
-    transferBytes[6] = SLIDER1_RESOLUTION_0;
-    transferBytes[7] = SLIDER1_RESOLUTION_1;
-    transferBytes[8] = SLIDER1_ENABLE_MASK_0_7;
-    transferBytes[9] = SLIDER1_ENABLE_MASK_8_9;
-    transferBytes[10] = SLIDER1_ENABLESTATUSLINK_0;
-    transferBytes[11] = SLIDER1_ENABLESTATUSLINK_1;
-    transferBytes[12] = SLIDER1_DELTA0_0;
-    transferBytes[13] = SLIDER1_DELTA0_1;
-    transferBytes[14] = SLIDER1_DELTA1_0;
-    transferBytes[15] = SLIDER1_DELTA1_1;
-    transferBytes[16] = SLIDER1_DELTA2_0;
-    transferBytes[17] = SLIDER1_DELTA2_1;
-    transferBytes[18] = SLIDER1_DELTA3_0;
-    transferBytes[19] = SLIDER1_DELTA3_1;
-    returnValue += writeRandomBytes16(IQS7222C_MM_SLIDER_SETUP_1, 20, transferBytes, RESTART);
-    //NRF_LOG_INFO("\t\t17. Slider/Wheel 1 Settings");
-
-    /* Change the GPIO Settings */
-    /* Memory Map Position 0xC000 - 0xC202 */
-    transferBytes[0] = GPIO0_SETUP_0;
-    transferBytes[1] = GPIO0_SETUP_1;
-#if IQS7222C_v1_13
-    transferBytes[2] = ENABLE_MASK_0_7;
-    transferBytes[3] = ENABLE_MASK_8_9;
-    transferBytes[4] = ENABLESTATUSLINK_0;
-    transferBytes[5] = ENABLESTATUSLINK_1;
-    uint8_t m_bytes = 6;
-#elif IQS7222C_v2_6 || IQS7222C_v2_23
-    transferBytes[2] = GPIO0_ENABLE_MASK_0_7;
-    transferBytes[3] = GPIO0_ENABLE_MASK_8_9;
-    transferBytes[4] = GPIO0_ENABLESTATUSLINK_0;
-    transferBytes[5] = GPIO0_ENABLESTATUSLINK_1;
-    transferBytes[6] = GPIO1_SETUP_0;
-    transferBytes[7] = GPIO1_SETUP_1;
-    transferBytes[8] = GPIO1_ENABLE_MASK_0_7;
-    transferBytes[9] = GPIO1_ENABLE_MASK_8_9;
-    transferBytes[10] = GPIO1_ENABLESTATUSLINK_0;
-    transferBytes[11] = GPIO1_ENABLESTATUSLINK_1;
-    transferBytes[12] = GPIO2_SETUP_0;
-    transferBytes[13] = GPIO2_SETUP_1;
-    transferBytes[14] = GPIO2_ENABLE_MASK_0_7;
-    transferBytes[15] = GPIO2_ENABLE_MASK_8_9;
-    transferBytes[16] = GPIO2_ENABLESTATUSLINK_0;
-    transferBytes[17] = GPIO2_ENABLESTATUSLINK_1;
-    uint8_t m_bytes = 18;
-#endif
-    returnValue += writeRandomBytes16(IQS7222C_MM_GPIO_0_SETTINGS, m_bytes, transferBytes,
-                                      RESTART);
-    //NRF_LOG_INFO("\t\t18. GPIO 0 Settings");
-
-    /* Change the System Settings */
-    /* Memory Map Position 0xD0 - 0xD9 */
-    transferBytes[0] = SYSTEM_CONTROL_0;
-    transferBytes[1] = SYSTEM_CONTROL_1;
-    transferBytes[2] = ATI_ERROR_TIMEOUT_0;
-    transferBytes[3] = ATI_ERROR_TIMEOUT_1;
-    transferBytes[4] = ATI_REPORT_RATE_0;
-    transferBytes[5] = ATI_REPORT_RATE_1;
-    transferBytes[6] = NORMAL_MODE_TIMEOUT_0;
-    transferBytes[7] = NORMAL_MODE_TIMEOUT_1;
-    transferBytes[8] = NORMAL_MODE_REPORT_RATE_0;
-    transferBytes[9] = NORMAL_MODE_REPORT_RATE_1;
-    transferBytes[10] = LP_MODE_TIMEOUT_0;
-    transferBytes[11] = LP_MODE_TIMEOUT_1;
-    transferBytes[12] = LP_MODE_REPORT_RATE_0;
-    transferBytes[13] = LP_MODE_REPORT_RATE_1;
-    transferBytes[14] = ULP_MODE_TIMEOUT_0;
-    transferBytes[15] = ULP_MODE_TIMEOUT_1;
-    transferBytes[16] = ULP_MODE_REPORT_RATE_0;
-    transferBytes[17] = ULP_MODE_REPORT_RATE_1;
-    transferBytes[18] = TOUCH_PROX_EVENT_MASK;
-    transferBytes[19] = POWER_ATI_EVENT_MASK;
-    transferBytes[20] = I2CCOMMS_0;
-    returnValue += writeRandomBytes(IQS7222C_MM_CONTROL_SETTINGS, 21, transferBytes,
-                                    RESTART);
-    //NRF_LOG_INFO("\t\t19. System Settings");
-
-/* Change the GPIO Override */
-/* Memory Map Position 0xDB - 0xDB */
-#if IQS7222C_v2_6 || IQS7222C_v2_23
-    transferBytes[0] = GPIO_OVERRIDE;
-    returnValue += writeRandomBytes(IQS7222C_MM_GPIO_OVERRIDE, 1, transferBytes, stopOrRestart);
-    //NRF_LOG_INFO("\t\t20. GPIO Override");
-#endif
+ * @retval I2C_TOUCH_SUCCESS, or the result of the first burst that failed.
+ * @notes  Walks configImage, one burst per address range straight from
+ * flash, and stops at the first failed burst.
+ */
+int iqs7222c_writeMM(iqs7222c_t *dev, bool stopOrRestart)
+{
+    int returnValue = I2C_TOUCH_SUCCESS;
+    uint8_t count = sizeof(configImage) / sizeof(configImage[0]);
 
-/* Change the Comms timeout setting */
-/* Memory Map Position 0xDC - 0xDC */
-#if IQS7222C_v2_23
-    transferBytes[0] = COMMS_TIMEOUT_0;
-    transferBytes[1] = COMMS_TIMEOUT_1;
-    returnValue += writeRandomBytes(IQS7222C_MM_COMMS_TIMEOUT, 2, transferBytes, stopOrRestart);
-    //NRF_LOG_INFO("\t\t21. Communication Timeout");
-#endif
+    for (uint8_t i = 0; (i < count) && (returnValue == I2C_TOUCH_SUCCESS); i++)
+    {
+        const iqs7222c_config_burst_t *burst = &configImage[i];
+        bool stop = (i + 1 == count) ? stopOrRestart : RESTART;
+
+        if (burst->extended)
+        {
+            returnValue = writeRandomBytes16(dev, burst->address, burst->length, burst->bytes, stop);
+        }
+        else
+        {
+            returnValue = writeRandomBytes(dev, (uint8_t)burst->address, burst->length, burst->bytes, stop);
+        }
+    }
+    // Every writable register now has a known value.
+    dev->shadow_valid = (returnValue == I2C_TOUCH_SUCCESS);
     return returnValue;
 }
 
-// /**************************************************************************************************************/
-// /*                                              PRIVATE METHODS */
-// /**************************************************************************************************************/
+/**
+ * @name   setConfig
+ * @brief  Stage configuration registers in the shadow without writing them.
+ * Only the bytes that differ from the shadow are marked as changed, write
+ * them with iqs7222c_flushConfig.
+ * @param  memoryAddress -> First register, 0x8000 - 0xC202 when extended,
+ * 0xD0 - 0xDC otherwise.
+ *         extended      -> True for 16 bit register addresses.
+ *         bytesArray    -> Register contents, low byte first.
+ *         numBytes      -> Number of bytes to stage.
+ * @retval I2C_TOUCH_SUCCESS, or I2C_TOUCH_ERROR_INVALID_PARAM if the range is not
+ * writable.
+ * @notes  Until the shadow is valid every staged byte is treated as changed.
+ */
+int iqs7222c_setConfig(iqs7222c_t *dev, uint16_t memoryAddress, bool extended,
+                       const uint8_t bytesArray[], uint8_t numBytes)
+{
+    int offset = shadowOffset(memoryAddress, extended);
+    int end = extended ? IQS7222C_SHADOW_SETUP_BYTES : IQS7222C_SHADOW_BYTES;
+
+    if ((offset < 0) || (numBytes > end - offset))
+    {
+        return I2C_TOUCH_ERROR_INVALID_PARAM;
+    }
+
+    for (uint8_t i = 0; i < numBytes; i++)
+    {
+        uint16_t pos = (uint16_t)(offset + i);
+        if (!dev->shadow_valid || (dev->shadow[pos] != bytesArray[i]))
+        {
+            dev->shadow[pos] = bytesArray[i];
+            // Bursts start on a register, so a changed high byte takes its
+            // low byte along.
+            dirtySet(dev, pos & ~1u);
+            dirtySet(dev, pos);
+        }
+    }
+    return I2C_TOUCH_SUCCESS;
+}
 
 /**
- * @name    readRandomBytes
- * @brief   A methods which reads a specified number of bytes from a specified
- * address and saves it into a user supplied array. This method is used by all
- * other methods in this class which read data drom the IQS7222C device.
- * @param   memoryAddress -> The memory address at which to start reading bytes
- * from.  See the "iqs7222c_addresses.h" file. numBytes      -> The number of
- * bytes that must be read. bytesArray    -> The array which will store the
- * bytes to be read, this array will be overwritten. stopOrRestart -> A boolean
- * which specifies whether the communication window should remain open or be
- * closed after transfer. False keeps it open, true closes it. Use the STOP and
- * RESTART definitions.
- * @retval  No value is returend, however, the user supplied array is
- * overwritten.
- * @notes   Uses standard arduino "Wire" library which is for I2C communication.
- *          Take note that C++ cannot return an array, therefore, the array
- * which is passed as an argument is overwritten with the required values. Pass
- * an array to the method by using only its name, e.g. "bytesArray", without the
- * brackets, this basically passes a pointer to the array.
+ * @name   planConfig
+ * @brief  Compute the bursts iqs7222c_flushConfig would issue for the
+ * currently staged changes.
+ * @param  bursts    -> Receives up to maxBursts bursts, may be NULL.
+ *         maxBursts -> Size of bursts.
+ * @retval Number of bursts needed, which may exceed maxBursts.
  */
-int readRandomBytes(uint8_t memoryAddress, uint8_t numBytes,
-                    uint8_t bytesArray[], bool stopOrRestart)
+uint16_t iqs7222c_planConfig(iqs7222c_t *dev, iqs7222c_burst_t *bursts, uint16_t maxBursts)
 {
-    return (i2c_touch_read_register(_deviceAddress, memoryAddress, numBytes, &bytesArray[0], stopOrRestart));
+    iqs7222c_burst_t burst;
+    uint16_t count = 0;
+    uint16_t from = 0;
+
+    while (planBurst(dev, from, &burst))
+    {
+        if ((bursts != NULL) && (count < maxBursts))
+        {
+            bursts[count] = burst;
+        }
+        count++;
+        from = (uint16_t)(burst.offset + burst.length);
+    }
+    return count;
 }
 
 /**
- * @name   writeRandomBytes
- * @brief  A mthod which writes a specified number of bytes to a specified
+ * @name   flushConfig
+ * @brief  Write the configuration bytes staged with iqs7222c_setConfig in the
+ * fewest contiguous bursts.
+ * @param  stopOrRestart -> Specifies whether the communications window must be
+ * kept open or must be closed after the last burst. Use the STOP and RESTART
+ * definitions.
+ * @retval I2C_TOUCH_SUCCESS, or the result of the first failed burst. Bursts
+ * that were not written stay staged.
+ * @notes  Runs of changed bytes are joined across up to
+ * IQS7222C_BURST_GAP_BYTES unchanged bytes once the shadow is valid, since
+ * rewriting them is cheaper than another transaction. Bursts never cross the
+ * end of an extended address range and are split at IQS7222C_MAX_BURST_BYTES.
+ */
+int iqs7222c_flushConfig(iqs7222c_t *dev, bool stopOrRestart)
+{
+    iqs7222c_burst_t burst;
+    iqs7222c_burst_t next;
+    bool more = planBurst(dev, 0, &next);
+
+    while (more)
+    {
+        int retVal;
+
+        burst = next;
+        more = planBurst(dev, (uint16_t)(burst.offset + burst.length), &next);
+        if (burst.extended)
+        {
+            retVal = writeRandomBytes16(dev, burst.address, burst.length, &dev->shadow[burst.offset],
+                                        more ? RESTART : stopOrRestart);
+        }
+        else
+        {
+            retVal = writeRandomBytes(dev, (uint8_t)burst.address, burst.length,
+                                      &dev->shadow[burst.offset], more ? RESTART : stopOrRestart);
+        }
+        if (retVal != I2C_TOUCH_SUCCESS)
+        {
+            return retVal;
+        }
+    }
+    return I2C_TOUCH_SUCCESS;
+}
+
+// /**************************************************************************************************************/
+// /*                                              PRIVATE METHODS */
+// /**************************************************************************************************************/
+
+/**
+ * @name    readRandomBytes
+ * @brief   A methods which reads a specified number of bytes from a specified
+ * address and saves it into a user supplied array. This method is used by all
+ * other methods in this class which read data drom the IQS7222C device.
+ * @param   memoryAddress -> The memory address at which to start reading bytes
+ * from.  See the "iqs7222c_addresses.h" file. numBytes      -> The number of
+ * bytes that must be read. bytesArray    -> The array which will store the
+ * bytes to be read, this array will be overwritten. stopOrRestart -> Kept for
+ * the callers, every read ends with a stop and so ends the window.
+ * @retval  No value is returend, however, the user supplied array is
+ * overwritten.
+ * @notes   Uses standard arduino "Wire" library which is for I2C communication.
+ *          Take note that C++ cannot return an array, therefore, the array
+ * which is passed as an argument is overwritten with the required values. Pass
+ * an array to the method by using only its name, e.g. "bytesArray", without the
+ * brackets, this basically passes a pointer to the array.
+ */
+int readRandomBytes(iqs7222c_t *dev, uint8_t memoryAddress, uint8_t numBytes,
+                    uint8_t bytesArray[], bool stopOrRestart)
+{
+    uint32_t startUs = i2c_touch_time_us(&dev->bus);
+    int retVal = i2c_touch_read_register(&dev->bus, dev->address, memoryAddress, numBytes, &bytesArray[0], stopOrRestart);
+    busAccount(dev, busOp(memoryAddress, false, numBytes), 1u + numBytes, retVal, startUs);
+    return retVal;
+}
+
+/**
+ * @name   readRandomBytes16
+ * @brief  readRandomBytes for the 16 bit extended register addresses.
+ */
+int readRandomBytes16(iqs7222c_t *dev, uint16_t memoryAddress, uint8_t numBytes,
+                      uint8_t bytesArray[], bool stopOrRestart)
+{
+    uint32_t startUs = i2c_touch_time_us(&dev->bus);
+    int retVal = i2c_touch_read_register_16(&dev->bus, dev->address, memoryAddress, numBytes, &bytesArray[0], stopOrRestart);
+    busAccount(dev, busOp(memoryAddress, true, numBytes), 2u + numBytes, retVal, startUs);
+    return retVal;
+}
+
+/**
+ * @name   writeRandomBytes
+ * @brief  A mthod which writes a specified number of bytes to a specified
  * address, the bytes to write are supplied by means of an array pointer. This
  * method is used by the all other methods of this class which write data to the
  * IQS7222C device.
@@ -1578,10 +1799,17 @@ int readRandomBytes(uint8_t memoryAddress, uint8_t numBytes,
  * the array. The values to be written must be loaded into the array prior to
  * passing it to the function.
  */
-int writeRandomBytes(uint8_t memoryAddress, uint8_t numBytes,
-                     uint8_t bytesArray[], bool stopOrRestart)
+int writeRandomBytes(iqs7222c_t *dev, uint8_t memoryAddress, uint8_t numBytes,
+                     const uint8_t bytesArray[], bool stopOrRestart)
 {
-    return (i2c_touch_write_register(_deviceAddress, memoryAddress, numBytes, bytesArray, stopOrRestart));
+    uint32_t startUs = i2c_touch_time_us(&dev->bus);
+    int retVal = i2c_touch_write_register(&dev->bus, dev->address, memoryAddress, numBytes, bytesArray, stopOrRestart);
+    busAccount(dev, busOp(memoryAddress, false, numBytes), 1u + numBytes, retVal, startUs);
+    if (retVal == 0)
+    {
+        shadowStore(dev, memoryAddress, false, numBytes, bytesArray);
+    }
+    return retVal;
 }
 
 /**
@@ -1605,10 +1833,809 @@ int writeRandomBytes(uint8_t memoryAddress, uint8_t numBytes,
  * the array. The values to be written must be loaded into the array prior to
  * passing it to the function.
  */
-int writeRandomBytes16(uint16_t memoryAddress, uint8_t numBytes,
-                       uint8_t bytesArray[], bool stopOrRestart)
+int writeRandomBytes16(iqs7222c_t *dev, uint16_t memoryAddress, uint8_t numBytes,
+                       const uint8_t bytesArray[], bool stopOrRestart)
+{
+    uint32_t startUs = i2c_touch_time_us(&dev->bus);
+    int retVal = i2c_touch_write_register_16(&dev->bus, dev->address, memoryAddress, numBytes, bytesArray, stopOrRestart);
+    busAccount(dev, busOp(memoryAddress, true, numBytes), 2u + numBytes, retVal, startUs);
+    if (retVal == 0)
+    {
+        shadowStore(dev, memoryAddress, true, numBytes, bytesArray);
+    }
+    return retVal;
+}
+
+/**
+ * @name   busOp
+ * @brief  Traffic class of a transfer, see iqs7222c_bus_op_e.
+ */
+static uint8_t busOp(uint16_t memoryAddress, bool extended, uint8_t numBytes)
+{
+    if (extended)
+    {
+        return IQS7222C_BUS_CONFIG;
+    }
+    if ((memoryAddress == IQS7222C_MM_CONTROL_SETTINGS) && (numBytes <= 2))
+    {
+        return IQS7222C_BUS_CONTROL;
+    }
+    if (memoryAddress >= IQS7222C_MM_CONTROL_SETTINGS)
+    {
+        return IQS7222C_BUS_CONFIG;
+    }
+    if ((memoryAddress >= IQS7222C_MM_INFOFLAGS) && (memoryAddress <= IQS7222C_MM_SLIDER_1_OUTPUT))
+    {
+        return IQS7222C_BUS_STATUS;
+    }
+    if ((memoryAddress >= IQS7222C_MM_CHANNEL_0_COUNTS) &&
+        (memoryAddress < IQS7222C_MM_CHANNEL_0_LTA + IQS7222C_CH9 + 1))
+    {
+        return IQS7222C_BUS_DATA;
+    }
+    return IQS7222C_BUS_OTHER;
+}
+
+/**
+ * @name   busAccount
+ * @brief  Add one finished transfer to the counters of its class.
+ * @param  bytes   -> Register address and payload bytes.
+ *         startUs -> Backend clock when the transfer was started.
+ */
+static void busAccount(iqs7222c_t *dev, uint8_t op, uint32_t bytes, int result, uint32_t startUs)
+{
+    iqs7222c_bus_op_stats_t *stats = &dev->bus_stats.op[op];
+
+    stats->transactions++;
+    stats->bytes += bytes;
+    stats->wire_us += i2c_touch_time_us(&dev->bus) - startUs;
+    if ((result == I2C_TOUCH_ERROR_ANACK) || (result == I2C_TOUCH_ERROR_DNACK))
+    {
+        stats->nacks++;
+    }
+}
+
+/**
+ * @name   shadowOffset
+ * @brief  Offset of a register in the shadow copy.
+ * @param  memoryAddress -> 8-bit or extended 16-bit register address.
+ *         extended      -> true for the 16-bit setup block addresses.
+ * @retval Byte offset into the shadow, -1 if the register is not
+ * writable.
+ */
+static int shadowOffset(uint16_t memoryAddress, bool extended)
+{
+    if (!extended)
+    {
+        if ((memoryAddress < IQS7222C_MM_CONTROL_SETTINGS) || (memoryAddress > IQS7222C_MM_COMMS_TIMEOUT))
+        {
+            return -1;
+        }
+        return IQS7222C_SHADOW_SETUP_BYTES + 2 * (memoryAddress - IQS7222C_MM_CONTROL_SETTINGS);
+    }
+
+    uint8_t block = (uint8_t)(memoryAddress >> 8);
+    uint8_t word = (uint8_t)memoryAddress;
+    int offset = 0;
+    for (uint8_t i = 0; i < sizeof(shadowBlocks) / sizeof(shadowBlocks[0]); i++)
+    {
+        if ((block >= shadowBlocks[i].first) && (block <= shadowBlocks[i].last))
+        {
+            if (word >= shadowBlocks[i].words)
+            {
+                return -1;
+            }
+            return offset + 2 * ((block - shadowBlocks[i].first) * shadowBlocks[i].words + word);
+        }
+        offset += 2 * (shadowBlocks[i].last - shadowBlocks[i].first + 1) * shadowBlocks[i].words;
+    }
+    return -1;
+}
+
+/**
+ * @name   shadowStore
+ * @brief  Mirror a successful register write into the shadow copy. Writes
+ * auto-increment through the flattened layout the same way the device does.
+ * The self clearing action bits of the control settings are not kept.
+ */
+static void shadowStore(iqs7222c_t *dev, uint16_t memoryAddress, bool extended, uint8_t numBytes,
+                        const uint8_t bytesArray[])
+{
+    int offset = shadowOffset(memoryAddress, extended);
+    if (offset < 0)
+    {
+        return;
+    }
+
+    int end = extended ? IQS7222C_SHADOW_SETUP_BYTES : IQS7222C_SHADOW_BYTES;
+    if (numBytes > end - offset)
+    {
+        numBytes = (uint8_t)(end - offset);
+    }
+    // Bursts from iqs7222c_flushConfig are written straight from the shadow.
+    if (bytesArray != &dev->shadow[offset])
+    {
+        memcpy(&dev->shadow[offset], bytesArray, numBytes);
+    }
+    for (uint8_t i = 0; i < numBytes; i++)
+    {
+        dirtyClear(dev, (uint16_t)(offset + i));
+    }
+
+    if (!extended && (memoryAddress == IQS7222C_MM_CONTROL_SETTINGS))
+    {
+        dev->shadow[offset] &= (uint8_t)~(ACK_RESET_BIT | SW_RESET_BIT | TP_REATI_BIT | TP_RESEED_BIT);
+    }
+}
+
+static bool dirtyTest(const iqs7222c_t *dev, uint16_t offset)
+{
+    return (dev->shadow_dirty[offset / 32] & (1UL << (offset % 32))) != 0;
+}
+
+static void dirtySet(iqs7222c_t *dev, uint16_t offset)
+{
+    dev->shadow_dirty[offset / 32] |= 1UL << (offset % 32);
+}
+
+static void dirtyClear(iqs7222c_t *dev, uint16_t offset)
+{
+    dev->shadow_dirty[offset / 32] &= ~(1UL << (offset % 32));
+}
+
+/**
+ * @name   shadowAddress
+ * @brief  Register address of a shadow byte, the inverse of shadowOffset.
+ * @param  offset   -> Shadow offset, rounded down to its register.
+ *         extended -> Receives true for a 16 bit register address.
+ *         rangeEnd -> Receives the end of the shadow range a burst starting at
+ * offset may auto-increment through. Extended addresses only continue within
+ * one range of shadowBlocks.
+ * @retval Register address.
+ */
+static uint16_t shadowAddress(uint16_t offset, bool *extended, uint16_t *rangeEnd)
+{
+    uint16_t rangeStart = 0;
+
+    for (uint8_t i = 0; i < sizeof(shadowBlocks) / sizeof(shadowBlocks[0]); i++)
+    {
+        const iqs7222c_shadow_block_t *block = &shadowBlocks[i];
+        uint16_t size = 2 * (block->last - block->first + 1) * block->words;
+        if (offset < rangeStart + size)
+        {
+            uint16_t word = (uint16_t)((offset - rangeStart) / 2);
+            *extended = true;
+            *rangeEnd = rangeStart + size;
+            return (uint16_t)(((block->first + word / block->words) << 8) | (word % block->words));
+        }
+        rangeStart += size;
+    }
+    *extended = false;
+    *rangeEnd = IQS7222C_SHADOW_BYTES;
+    return (uint16_t)(IQS7222C_MM_CONTROL_SETTINGS + (offset - IQS7222C_SHADOW_SETUP_BYTES) / 2);
+}
+
+/**
+ * @name   planBurst
+ * @brief  Find the next burst of staged shadow bytes.
+ * @param  from  -> Shadow offset to start searching at.
+ *         burst -> Receives the register address and shadow range.
+ * @retval false if nothing from this offset on is staged.
+ */
+static bool planBurst(const iqs7222c_t *dev, uint16_t from, iqs7222c_burst_t *burst)
+{
+    uint16_t start = from;
+    while ((start < IQS7222C_SHADOW_BYTES) && !dirtyTest(dev, start))
+    {
+        start++;
+    }
+    if (start >= IQS7222C_SHADOW_BYTES)
+    {
+        return false;
+    }
+
+    uint16_t rangeEnd;
+    burst->address = shadowAddress(start, &burst->extended, &rangeEnd);
+
+    // Extend over staged bytes, bridging short unchanged gaps when their
+    // contents are known.
+    uint16_t end = start;
+    for (uint16_t pos = start; (pos < rangeEnd) && (pos - start < IQS7222C_MAX_BURST_BYTES); pos++)
+    {
+        if (dirtyTest(dev, pos))
+        {
+            end = pos + 1;
+        }
+        else if (!dev->shadow_valid || (pos - end >= IQS7222C_BURST_GAP_BYTES))
+        {
+            break;
+        }
+    }
+    burst->offset = start;
+    burst->length = (uint8_t)(end - start);
+    return true;
+}
+
+/**
+ * @name   readControlSettings
+ * @brief  Get the control settings word for a read-modify-write. Taken from
+ * the shadow copy when it is valid, so the control methods only need a single
+ * write transaction, otherwise read from the device.
+ * @param  bytesArray -> 2 byte array which receives the control settings.
+ */
+static int readControlSettings(iqs7222c_t *dev, uint8_t bytesArray[])
+{
+    if (dev->shadow_valid)
+    {
+        int offset = shadowOffset(IQS7222C_MM_CONTROL_SETTINGS, false);
+        bytesArray[0] = dev->shadow[offset];
+        bytesArray[1] = dev->shadow[offset + 1];
+        return I2C_TOUCH_SUCCESS;
+    }
+    return readRandomBytes(dev, IQS7222C_MM_CONTROL_SETTINGS, 2, bytesArray, RESTART);
+}
+
+/**
+ * @name   readConfig
+ * @brief  Read the next burst of the writable registers back into the
+ * shadow, from config_offset up to the end of its address range.
+ * @retval Result of the read, or I2C_TOUCH_SUCCESS.
+ * @notes  The read ends the window, call once per window until config_offset
+ * reaches IQS7222C_SHADOW_BYTES. The shadow is not marked valid.
+ */
+static int readConfig(iqs7222c_t *dev)
+{
+    uint16_t offset = dev->config_offset;
+    bool extended;
+    uint16_t rangeEnd;
+    uint16_t address = shadowAddress(offset, &extended, &rangeEnd);
+    uint16_t length = rangeEnd - offset;
+    if (length > IQS7222C_MAX_BURST_BYTES)
+    {
+        length = IQS7222C_MAX_BURST_BYTES;
+    }
+    int retVal = extended ? readRandomBytes16(dev, address, (uint8_t)length, &dev->shadow[offset], STOP)
+                          : readRandomBytes(dev, (uint8_t)address, (uint8_t)length, &dev->shadow[offset], STOP);
+    if (retVal != I2C_TOUCH_SUCCESS)
+    {
+        return retVal;
+    }
+    dev->config_offset = offset + length;
+    if (dev->config_offset < IQS7222C_SHADOW_BYTES)
+    {
+        return I2C_TOUCH_SUCCESS;
+    }
+
+    dev->shadow[shadowOffset(IQS7222C_MM_CONTROL_SETTINGS, false)] &=
+        (uint8_t)~(ACK_RESET_BIT | SW_RESET_BIT | TP_REATI_BIT | TP_RESEED_BIT);
+    memset(dev->shadow_dirty, 0, sizeof(dev->shadow_dirty));
+    return I2C_TOUCH_SUCCESS;
+}
+
+/**
+ * @name   configFingerprint
+ * @brief  IQS7222C_CONFIG_FINGERPRINT computed over the shadow, so a device
+ * still configured from IQS7222C_init.h gives the compile-time value.
+ */
+static uint32_t configFingerprint(const iqs7222c_t *dev)
+{
+    uint32_t fingerprint = 0;
+
+    for (uint16_t i = 0; i < sizeof(configCheckOffsets) / sizeof(configCheckOffsets[0]); i++)
+    {
+        uint16_t offset = configCheckOffsets[i];
+        fingerprint += IQS7222C_CONFIG_FP_WEIGHT(offset, dev->shadow[offset]);
+    }
+    return fingerprint;
+}
+
+/**
+ * @name   initWaitForWindow
+ * @brief  Non blocking check for an open communication window during init.
+ * @retval true if RDY is low. Otherwise arms the RDY timeout, forces
+ * communication each time it expires and returns false.
+ */
+static bool initWaitForWindow(iqs7222c_t *dev)
+{
+    if (!i2c_touch_pin_is_set(&dev->bus, dev->ready_pin))
+    {
+        if (dev->init_timer_armed)
+        {
+            i2c_touch_timer_stop(&dev->bus, &dev->timer);
+            dev->init_timer_armed = false;
+        }
+        dev->init_timer_expired = false;
+        return true;
+    }
+
+    if (dev->init_timer_expired)
+    {
+        dev->init_timer_expired = false;
+        dev->init_timer_armed = false;
+        dev->init_stats.rdy_timeouts++;
+        iqs7222c_force_I2C_communication(dev);
+    }
+
+    if (!dev->init_timer_armed)
+    {
+        dev->init_timer_armed = true;
+        i2c_touch_timer_start(&dev->bus, &dev->timer, IQS7222C_RDY_TIMEOUT_MS * 1000,
+                              initTimerHandler, dev);
+    }
+    return false;
+}
+
+/**
+ * @name   initWaitForTimer
+ * @brief  Non blocking delay during init.
+ * @retval false until timeoutUs after the first call, then true once.
+ */
+static bool initWaitForTimer(iqs7222c_t *dev, uint32_t timeoutUs)
+{
+    if (dev->init_timer_expired)
+    {
+        dev->init_timer_expired = false;
+        dev->init_timer_armed = false;
+        return true;
+    }
+
+    if (!dev->init_timer_armed)
+    {
+        dev->init_timer_armed = true;
+        i2c_touch_timer_start(&dev->bus, &dev->timer, timeoutUs, initTimerHandler, dev);
+    }
+    return false;
+}
+
+/**
+ * @name   initTimerHandler
+ * @brief  One-shot timer expiry during init, runs in interrupt context.
+ */
+static void initTimerHandler(void *p_context)
+{
+    iqs7222c_t *dev = p_context;
+
+    dev->init_timer_expired = true;
+}
+
+/**
+ * @name   planBlocks
+ * @brief  Blocks of the read plan needed in this window.
+ * @param  events -> Events word, of this window or the previous one.
+ *         prox   -> Prox states, of this window or the previous one.
+ */
+static uint8_t planBlocks(const iqs7222c_t *dev, uint16_t events, uint16_t prox)
+{
+    uint8_t blocks = dev->read_blocks;
+
+    if (dev->read_mode == IQS7222C_READ_FIXED)
+    {
+        return blocks;
+    }
+
+    // A slider moves only under a finger and returns to no touch with a
+    // release, which is a touch event. Slider events cover a slider that
+    // moves without a channel in touch.
+    if (!(events & (IQS7222C_EVENTS_TOUCH | IQS7222C_EVENTS_SLIDERS)) &&
+        (dev->last_touch_states == 0) &&
+        (dev->last_slider0 == IQS7222C_SLIDER_NO_TOUCH) &&
+        (dev->last_slider1 == IQS7222C_SLIDER_NO_TOUCH))
+    {
+        blocks &= ~IQS7222C_READ_SLIDERS;
+    }
+    if (!(events & (IQS7222C_EVENTS_PROX | IQS7222C_EVENTS_TOUCH | IQS7222C_EVENTS_ATI)) &&
+        (prox == 0) && (dev->last_prox_states == 0))
+    {
+        blocks &= ~(IQS7222C_READ_COUNTS | IQS7222C_READ_LTA);
+    }
+    return blocks;
+}
+
+/**
+ * @name   statusLength
+ * @brief  Status burst length covering the slider outputs in blocks.
+ */
+static uint8_t statusLength(uint8_t blocks)
 {
-    return (i2c_touch_write_register_16(_deviceAddress, memoryAddress, numBytes, bytesArray, stopOrRestart));
+    if (blocks & IQS7222C_READ_SLIDER1)
+    {
+        return IQS7222C_STATUS_MAX_BYTES;
+    }
+    if (blocks & IQS7222C_READ_SLIDER0)
+    {
+        return IQS7222C_STATUS_BYTES + 2;
+    }
+    return IQS7222C_STATUS_BYTES;
+}
+
+/**
+ * @name   windowLength
+ * @brief  Burst length from IQS7222C_MM_INFOFLAGS covering every block in
+ * blocks. Counts and LTA bring the slider outputs along.
+ */
+static uint8_t windowLength(uint8_t blocks)
+{
+    if (blocks & IQS7222C_READ_LTA)
+    {
+        return WINDOW_MAX_BYTES;
+    }
+    if (blocks & IQS7222C_READ_COUNTS)
+    {
+        return WINDOW_COUNTS_OFFSET + 2 * IQS7222C_CHANNELS;
+    }
+    return statusLength(blocks);
+}
+
+/**
+ * @name   readWindow
+ * @brief  readRandomBytes counted in the read statistics.
+ */
+static int readWindow(iqs7222c_t *dev, uint8_t memoryAddress, uint8_t numBytes,
+                      uint8_t bytesArray[], bool stopOrRestart)
+{
+    dev->read_stats.transfers++;
+    dev->read_stats.bytes += numBytes;
+    return readRandomBytes(dev, memoryAddress, numBytes, bytesArray, stopOrRestart);
+}
+
+/**
+ * @name   decodeStatus
+ * @brief  Assign the status burst read from IQS7222C_MM_INFOFLAGS to the
+ * memory map unions.
+ * @param  numBytes -> IQS7222C_STATUS_BYTES, plus 2 per slider output read,
+ * or a burst that runs on to the counts and LTA. Slider outputs that were not
+ * read keep their last value.
+ */
+static void decodeStatus(iqs7222c_t *dev, const uint8_t transferBytes[], uint8_t numBytes)
+{
+    // Assign the info flags to the info flags union.
+    dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_lsb = transferBytes[0];
+    dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_msb = transferBytes[1];
+
+    dev->memory_map.iqs7222c_events.iqs7222c_events_lsb = transferBytes[2];
+    dev->memory_map.iqs7222c_events.iqs7222c_events_msb = transferBytes[3];
+
+    dev->memory_map.iqs7222c_prox_event_states.iqs7222c_prox_event_states_lsb =
+        transferBytes[4];
+    dev->memory_map.iqs7222c_prox_event_states.iqs7222c_prox_event_states_msb =
+        transferBytes[5];
+
+    dev->memory_map.iqs7222c_touch_event_states.iqs7222c_touch_event_states_lsb =
+        transferBytes[6];
+    dev->memory_map.iqs7222c_touch_event_states.iqs7222c_touch_event_states_msb =
+        transferBytes[7];
+
+    if (numBytes > IQS7222C_STATUS_BYTES)
+    {
+        uint8_t sliderBytes = (numBytes < IQS7222C_STATUS_MAX_BYTES) ? numBytes : IQS7222C_STATUS_MAX_BYTES;
+        memcpy(dev->memory_map.iqs7222c_slider_wheel_out.buffer,
+               &transferBytes[IQS7222C_STATUS_BYTES], sliderBytes - IQS7222C_STATUS_BYTES);
+    }
+    else if ((dev->read_mode == IQS7222C_READ_LEARNED) && (dev->read_blocks & IQS7222C_READ_SLIDERS) &&
+             (((transferBytes[6] | transferBytes[7]) && !dev->last_touch_states) ||
+              (transferBytes[3] & (IQS7222C_EVENTS_SLIDERS >> 8))))
+    {
+        // A learned burst that stopped short of a new touch or a slider
+        // event, the slider outputs follow in the next window.
+        dev->read_stats.misses++;
+    }
+
+    // An unexpected reset returns all settings to their defaults.
+    if (dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_lsb & SHOW_RESET_BIT)
+    {
+        dev->shadow_valid = false;
+    }
+
+    publishFrame(dev);
+    queueEvents(dev);
+}
+
+/**
+ * @name   publishFrame
+ * @brief  Writer side of the frame double buffer, runs before the events of
+ * the window are dispatched so handlers read the new frame.
+ */
+static void publishFrame(iqs7222c_t *dev)
+{
+    uint32_t seq = dev->frame_seq;
+    const iqs7222c_frame_t *front = &dev->frames[(seq >> 1) & 1u];
+    iqs7222c_frame_t *back = &dev->frames[((seq >> 1) + 1u) & 1u];
+    const IQS7222C_MEMORY_MAP *map = &dev->memory_map;
+
+    dev->frame_seq = seq + 1u;
+    FRAME_WRITE_BARRIER();
+
+    back->timestamp_us = dev->window_time_us;
+    back->info_flags = map->iqs7222c_info_flags.iqs7222c_infoflags_lsb |
+                       (map->iqs7222c_info_flags.iqs7222c_infoflags_msb << 8);
+    back->events = map->iqs7222c_events.iqs7222c_events_lsb |
+                   (map->iqs7222c_events.iqs7222c_events_msb << 8);
+    back->prox = (map->iqs7222c_prox_event_states.iqs7222c_prox_event_states_lsb |
+                  (map->iqs7222c_prox_event_states.iqs7222c_prox_event_states_msb << 8)) &
+                 IQS7222C_ALL_CHANNELS;
+    back->touch = (map->iqs7222c_touch_event_states.iqs7222c_touch_event_states_lsb |
+                   (map->iqs7222c_touch_event_states.iqs7222c_touch_event_states_msb << 8)) &
+                  IQS7222C_ALL_CHANNELS;
+    back->prox_changed = back->prox ^ front->prox;
+    back->touch_changed = back->touch ^ front->touch;
+    back->slider[0] = map->iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_lsb |
+                      (map->iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_msb << 8);
+    back->slider[1] = map->iqs7222c_slider_wheel_out.iqs7222c_slider_1_out_lsb |
+                      (map->iqs7222c_slider_wheel_out.iqs7222c_slider_1_out_msb << 8);
+
+    FRAME_WRITE_BARRIER();
+    dev->frame_seq = seq + 2u;
+    latencyRecord(dev, IQS7222C_LATENCY_DECODE);
+}
+
+/**
+ * @name   windowServiced
+ * @brief  Account the window whose read starts now: edges skipped since the
+ * last serviced window and a read past the comms timeout are missed windows.
+ */
+static void windowServiced(iqs7222c_t *dev)
+{
+    uint32_t edges = dev->rdy_edges;
+    uint32_t skipped = (edges - dev->serviced_edges > 1u) ? edges - dev->serviced_edges - 1u : 0;
+    bool late = (i2c_touch_time_us(&dev->bus) - dev->window_time_us) > iqs7222c_getCommsTimeoutUs(dev);
+
+    dev->serviced_edges = edges;
+    dev->window_stats.missed += skipped;
+    if (late)
+    {
+        dev->window_stats.missed++;
+        dev->window_stats.late++;
+    }
+    else
+    {
+        dev->window_stats.serviced++;
+    }
+    overrunNotify(dev, late || (skipped != 0));
+}
+
+/**
+ * @name   overrunNotify
+ * @brief  Call the overrun handler when the overrun state changes.
+ */
+static void overrunNotify(iqs7222c_t *dev, bool overrun)
+{
+    if (overrun != dev->overrun)
+    {
+        dev->overrun = overrun;
+        if (dev->overrun_handler != NULL)
+        {
+            dev->overrun_handler(dev, overrun, dev->overrun_context);
+        }
+    }
+}
+
+/**
+ * @name   latencyRecord
+ * @brief  Add the time since the RDY edge of the current window to the
+ * histogram of stage.
+ */
+static void latencyRecord(iqs7222c_t *dev, uint8_t stage)
+{
+#if IQS7222C_LATENCY_STATS
+    uint32_t us = i2c_touch_time_us(&dev->bus) - dev->window_time_us;
+    iqs7222c_latency_hist_t *hist = &dev->latency[stage];
+
+    hist->buckets[latencyBucket(us)]++;
+    hist->count++;
+    if (us > hist->max_us)
+    {
+        hist->max_us = us;
+    }
+#endif
+}
+
+#if IQS7222C_LATENCY_STATS
+/**
+ * @name   latencyBucket
+ * @brief  0 and 1 us get their own buckets, then [2^e, 1.5 * 2^e) and
+ * [1.5 * 2^e, 2^(e + 1)) are buckets 2e and 2e + 1.
+ */
+static uint8_t latencyBucket(uint32_t us)
+{
+    if (us < 2)
+    {
+        return (uint8_t)us;
+    }
+
+    uint8_t exponent = (uint8_t)(31 - __builtin_clz(us));
+    uint8_t bucket = (uint8_t)(2 * exponent + ((us >> (exponent - 1)) & 1u));
+    return (bucket < IQS7222C_LATENCY_BUCKETS) ? bucket : (IQS7222C_LATENCY_BUCKETS - 1);
+}
+
+/**
+ * @name   latencyBucketEnd
+ * @brief  Largest value that falls into bucket.
+ */
+static uint32_t latencyBucketEnd(uint8_t bucket)
+{
+    if (bucket < 2)
+    {
+        return bucket;
+    }
+
+    uint8_t exponent = bucket / 2;
+    uint32_t half = 1u << (exponent - 1);
+    return (1u << exponent) + (bucket & 1u) * half + half - 1u;
+}
+
+/**
+ * @name   latencyPercentile
+ * @brief  Upper edge of the bucket holding the percent-th sample.
+ */
+static uint32_t latencyPercentile(const iqs7222c_latency_hist_t *hist, uint32_t percent)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * percent + 99u) / 100u);
+    uint32_t seen = 0;
+
+    for (uint8_t bucket = 0; bucket < IQS7222C_LATENCY_BUCKETS; bucket++)
+    {
+        seen += hist->buckets[bucket];
+        if ((seen >= rank) && (seen != 0))
+        {
+            uint32_t end = latencyBucketEnd(bucket);
+            return (end < hist->max_us) ? end : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+#endif
+
+/**
+ * @name   queueEvents
+ * @brief  Compare the freshly decoded states with the previous window and
+ * queue one event per changed channel and per slider movement.
+ */
+static void queueEvents(iqs7222c_t *dev)
+{
+    uint16_t touch = dev->memory_map.iqs7222c_touch_event_states.iqs7222c_touch_event_states_lsb |
+                     (dev->memory_map.iqs7222c_touch_event_states.iqs7222c_touch_event_states_msb << 8);
+    uint16_t prox = dev->memory_map.iqs7222c_prox_event_states.iqs7222c_prox_event_states_lsb |
+                    (dev->memory_map.iqs7222c_prox_event_states.iqs7222c_prox_event_states_msb << 8);
+    uint16_t slider0 = dev->memory_map.iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_lsb |
+                       (dev->memory_map.iqs7222c_slider_wheel_out.iqs7222c_slider_0_out_msb << 8);
+    uint16_t slider1 = dev->memory_map.iqs7222c_slider_wheel_out.iqs7222c_slider_1_out_lsb |
+                       (dev->memory_map.iqs7222c_slider_wheel_out.iqs7222c_slider_1_out_msb << 8);
+
+    queueChannelEvents(dev, prox, &dev->last_prox_states, IQS7222C_EVENT_PROX, IQS7222C_EVENT_PROX_RELEASE);
+    queueChannelEvents(dev, touch, &dev->last_touch_states, IQS7222C_EVENT_TOUCH, IQS7222C_EVENT_RELEASE);
+
+    if (slider0 != dev->last_slider0)
+    {
+        dev->last_slider0 = slider0;
+        emitEvent(dev, IQS7222C_EVENT_SLIDER, IQS7222C_SLIDER0, slider0);
+    }
+    if (slider1 != dev->last_slider1)
+    {
+        dev->last_slider1 = slider1;
+        emitEvent(dev, IQS7222C_EVENT_SLIDER, IQS7222C_SLIDER1, slider1);
+    }
+
+    uint8_t info = dev->memory_map.iqs7222c_info_flags.iqs7222c_infoflags_lsb;
+    uint8_t infoChanged = info ^ dev->last_info_flags;
+    dev->last_info_flags = info;
+    if (infoChanged & IQS7222C_INFO_ATI_ERROR)
+    {
+        emitEvent(dev, IQS7222C_EVENT_ATI_ERROR, 0, dev->memory_map.iqs7222c_info_flags.ati_error);
+    }
+    if (infoChanged & IQS7222C_INFO_POWER_MODE)
+    {
+        emitEvent(dev, IQS7222C_EVENT_POWER_MODE, 0, iqs7222c_get_PowerMode(dev));
+    }
+}
+
+static void queueChannelEvents(iqs7222c_t *dev, uint16_t states, uint16_t *lastStates,
+                               uint8_t onType, uint8_t offType)
+{
+    uint16_t changed = (states ^ *lastStates) & IQS7222C_ALL_CHANNELS;
+    *lastStates = states & IQS7222C_ALL_CHANNELS;
+
+    for (uint8_t channel = IQS7222C_CH0; changed != 0; channel++, changed >>= 1)
+    {
+        if (changed & 1u)
+        {
+            emitEvent(dev, (states & (1u << channel)) ? onType : offType, channel, 0);
+        }
+    }
+}
+
+/**
+ * @name   emitEvent
+ * @brief  Queue one decoded edge and hand it to the subscribers of its type.
+ */
+static void emitEvent(iqs7222c_t *dev, uint8_t type, uint8_t index, uint16_t value)
+{
+    iqs7222c_event_t event = {
+        .timestamp_us = dev->window_time_us,
+        .value = value,
+        .type = type,
+        .index = index,
+    };
+
+    pushEvent(dev, &event);
+    if (dev->subscriber_types & IQS7222C_EVENT_MASK(type))
+    {
+        dispatchEvent(dev, &event);
+    }
+}
+
+/**
+ * @name   dispatchEvent
+ * @brief  Call every subscriber whose masks match the event.
+ */
+static void dispatchEvent(iqs7222c_t *dev, const iqs7222c_event_t *event)
+{
+    bool channelEvent = event->type <= IQS7222C_EVENT_PROX_RELEASE;
+
+    for (uint8_t i = 0; i < dev->subscriber_count; i++)
+    {
+        const iqs7222c_subscriber_t *subscriber = &dev->subscribers[i];
+
+        if (!(subscriber->types & IQS7222C_EVENT_MASK(event->type)) ||
+            (channelEvent && !(subscriber->channels & (1u << event->index))))
+        {
+            continue;
+        }
+        latencyRecord(dev, IQS7222C_LATENCY_DISPATCH);
+        subscriber->handler(dev, event, subscriber->p_context);
+    }
+}
+
+/**
+ * @name   pushEvent
+ * @brief  Producer side of the event queue. Drops and counts the event when
+ * the queue is full, the oldest unread events are kept.
+ */
+static void pushEvent(iqs7222c_t *dev, const iqs7222c_event_t *event)
+{
+    uint32_t head = dev->event_head;
+    uint32_t depth = head - dev->event_tail;
+
+    if (depth >= IQS7222C_EVENT_QUEUE_SIZE)
+    {
+        dev->event_stats.dropped++;
+        return;
+    }
+
+    dev->events[head & EVENT_QUEUE_MASK] = *event;
+    EVENT_QUEUE_BARRIER();
+    dev->event_head = head + 1;
+
+    dev->event_stats.queued++;
+    if (depth + 1 > dev->event_stats.high_water)
+    {
+        dev->event_stats.high_water = depth + 1;
+    }
+}
+
+/**
+ * @name   asyncUpdateDone
+ * @brief  Completion of the status burst started from the RDY interrupt, runs
+ * in interrupt context.
+ */
+static void asyncUpdateDone(int result, void *p_context)
+{
+    iqs7222c_t *dev = p_context;
+
+    busAccount(dev, IQS7222C_BUS_STATUS, 1u + dev->async_length, result, dev->async_start_us);
+    if (result == I2C_TOUCH_SUCCESS)
+    {
+        latencyRecord(dev, IQS7222C_LATENCY_TWI_DONE);
+        dev->read_stats.windows++;
+        dev->read_stats.transfers++;
+        dev->read_stats.bytes += dev->async_length;
+        decodeStatus(dev, dev->async_bytes, dev->async_length);
+        dev->new_data_available = true;
+    }
+
+    if (dev->async_handler != NULL)
+    {
+        dev->async_handler(dev, result);
+    }
 }
 
 /**
@@ -1620,10 +2647,12 @@ int writeRandomBytes16(uint16_t memoryAddress, uint8_t numBytes,
   * @notes  Uses standard arduino "Wire" library which is for I2C communication.
 
   */
-void iqs7222c_force_I2C_communication(void)
+void iqs7222c_force_I2C_communication(iqs7222c_t *dev)
 {
     uint8_t force_comm_byte[1] = {0xFF};
-    i2c_touch_write_register(_deviceAddress, 0x00, 1, &force_comm_byte[0], STOP);
+    uint32_t startUs = i2c_touch_time_us(&dev->bus);
+    int retVal = i2c_touch_write_register(&dev->bus, dev->address, 0x00, 1, &force_comm_byte[0], STOP);
+    busAccount(dev, IQS7222C_BUS_FORCE, 2u, retVal, startUs);
 }
 
 /**
@@ -1631,12 +2660,12 @@ void iqs7222c_force_I2C_communication(void)
  * 
  * @return uint8_t representation of touch detected on channels [0-8]
  */
-uint8_t iqs7222c_getTouchStateByte(void)
+uint8_t iqs7222c_getTouchStateByte(iqs7222c_t *dev)
 {
-    return IQSMemoryMap.iqs7222c_touch_event_states.iqs7222c_touch_event_states_lsb;
+    return (uint8_t)iqs7222c_touchMask(dev);
 }
 
-bool iqs7222c_isNewDataAvailable(void)
+bool iqs7222c_isNewDataAvailable(iqs7222c_t *dev)
 {
-    return new_data_available;
+    return dev->new_data_available;
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+/** @file iqs7222c_gesture.c
+*
+* @brief Tap, double tap, press and hold, swipe and fling on one slider
+* output. Each slider has a four state machine fed with the coordinate of
+* every window (IQS7222C_SLIDER_NO_TOUCH on lift), usually straight from the
+* slider events of the driver. Hold and the end of the double tap wait need
+* no window, call iqs7222c_gesture_poll by iqs7222c_gesture_next_us for them.
+* Every other step needs a window per slider change: in event mode keep the
+* slider event bits of IQS7222C_MM_EVENT_ENABLE set, as IQS7222C_init.h does,
+* or turn on stream in touch.
+* Velocity is integer only: coordinate steps are scaled by 15625 / (dt / 64)
+* (1e6 / 64 = 15625), which fits 32 bits for a 16-bit coordinate and any dt.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c_gesture.h"
+#include <stddef.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+/* Recognizer states */
+#define GESTURE_IDLE 0
+#define GESTURE_DOWN 1     /* touched, within move_max of the touch down */
+#define GESTURE_MOVING 2   /* touched, moved further */
+#define GESTURE_TAP_WAIT 3 /* lifted after a tap, waiting for a second one */
+
+//----------------------------- DATA TYPES ------------------------------------
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static void gesture_down(iqs7222c_gesture_t *gesture, uint16_t position, uint32_t now_us);
+static void gesture_move(iqs7222c_gesture_t *gesture, uint16_t position, uint32_t now_us);
+static void gesture_lift(iqs7222c_gesture_t *gesture, uint32_t now_us);
+static void gesture_flush_tap(iqs7222c_gesture_t *gesture, uint32_t now_us);
+static void gesture_emit(iqs7222c_gesture_t *gesture, uint8_t type, uint32_t now_us,
+                         uint16_t position, int32_t distance, int32_t velocity);
+static uint32_t gesture_distance(uint16_t a, uint16_t b);
+static void gesture_event(iqs7222c_t *dev, const iqs7222c_event_t *event, void *p_context);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+/* Thresholds for a slider with the given resolution (coordinate of the far
+ * end): taps up to 250 ms and 1/32 of the length, double taps within 300 ms,
+ * hold after 600 ms, swipes over 1/8 and flings faster than twice the
+ * length per second. */
+void iqs7222c_gesture_default_config(iqs7222c_gesture_config_t *config, uint16_t resolution)
+{
+    config->tap_max_us = 250000u;
+    config->double_tap_gap_us = 300000u;
+    config->hold_us = 600000u;
+    config->move_max = resolution / 32u;
+    config->swipe_min = resolution / 8u;
+    config->fling_velocity = (uint32_t)resolution * 2u;
+}
+
+void iqs7222c_gesture_init(iqs7222c_gesture_t *gesture, const iqs7222c_gesture_config_t *config,
+                           IQS7222C_slider_e slider, iqs7222c_gesture_handler_t handler,
+                           void *p_context)
+{
+    memset(gesture, 0, sizeof(*gesture));
+    gesture->config = *config;
+    gesture->slider = slider;
+    gesture->handler = handler;
+    gesture->p_context = p_context;
+    gesture->state = GESTURE_IDLE;
+}
+
+/* Feed the gesture from the slider events of dev. The handler then runs in
+ * the context that decodes the status burst, poll from the same context or
+ * with the RDY interrupt masked. */
+bool iqs7222c_gesture_attach(iqs7222c_gesture_t *gesture, iqs7222c_t *dev)
+{
+    return iqs7222c_subscribe(dev, IQS7222C_EVENT_MASK(IQS7222C_EVENT_SLIDER), IQS7222C_ALL_CHANNELS,
+                              gesture_event, gesture);
+}
+
+void iqs7222c_gesture_detach(iqs7222c_gesture_t *gesture, iqs7222c_t *dev)
+{
+    iqs7222c_unsubscribe(dev, gesture_event, gesture);
+}
+
+/* Slider coordinate of the window at now_us, IQS7222C_SLIDER_NO_TOUCH when
+ * not touched. Repeated coordinates are fine. */
+void iqs7222c_gesture_update(iqs7222c_gesture_t *gesture, uint16_t position, uint32_t now_us)
+{
+    iqs7222c_gesture_poll(gesture, now_us);
+
+    if (position == IQS7222C_SLIDER_NO_TOUCH)
+    {
+        if ((gesture->state == GESTURE_DOWN) || (gesture->state == GESTURE_MOVING))
+        {
+            gesture_lift(gesture, now_us);
+        }
+    }
+    else if ((gesture->state == GESTURE_DOWN) || (gesture->state == GESTURE_MOVING))
+    {
+        gesture_move(gesture, position, now_us);
+    }
+    else
+    {
+        gesture_down(gesture, position, now_us);
+    }
+}
+
+/* Deliver the gestures that are due by time alone: HOLD, and TAP once no
+ * second tap can follow. */
+void iqs7222c_gesture_poll(iqs7222c_gesture_t *gesture, uint32_t now_us)
+{
+    if ((gesture->state == GESTURE_TAP_WAIT) &&
+        (now_us - gesture->tap_us >= gesture->config.double_tap_gap_us))
+    {
+        gesture->state = GESTURE_IDLE;
+        gesture_emit(gesture, IQS7222C_GESTURE_TAP, now_us, gesture->tap_position, 0, 0);
+    }
+    else if ((gesture->state == GESTURE_DOWN) && !gesture->held &&
+             (now_us - gesture->down_us >= gesture->config.hold_us))
+    {
+        gesture->held = true;
+        gesture_flush_tap(gesture, now_us);
+        gesture_emit(gesture, IQS7222C_GESTURE_HOLD, now_us, gesture->down_position, 0, 0);
+    }
+}
+
+/* Time of the next iqs7222c_gesture_poll that can deliver a gesture,
+ * UINT32_MAX if only a new window can. */
+uint32_t iqs7222c_gesture_next_us(const iqs7222c_gesture_t *gesture)
+{
+    if (gesture->state == GESTURE_TAP_WAIT)
+    {
+        return gesture->tap_us + gesture->config.double_tap_gap_us;
+    }
+    if ((gesture->state == GESTURE_DOWN) && !gesture->held)
+    {
+        return gesture->down_us + gesture->config.hold_us;
+    }
+    return UINT32_MAX;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Touch down, the second touch of a double tap if it lands near the first. */
+static void gesture_down(iqs7222c_gesture_t *gesture, uint16_t position, uint32_t now_us)
+{
+    gesture->second_tap = false;
+    if (gesture->state == GESTURE_TAP_WAIT)
+    {
+        gesture->second_tap = true;
+        if (gesture_distance(position, gesture->tap_position) > gesture->config.swipe_min)
+        {
+            gesture_flush_tap(gesture, now_us);
+        }
+    }
+
+    gesture->state = GESTURE_DOWN;
+    gesture->held = false;
+    gesture->down_position = position;
+    gesture->last_position = position;
+    gesture->down_us = now_us;
+    gesture->last_us = now_us;
+    gesture->velocity = 0;
+}
+
+static void gesture_move(iqs7222c_gesture_t *gesture, uint16_t position, uint32_t now_us)
+{
+    if (position == gesture->last_position)
+    {
+        return;
+    }
+
+    uint32_t ticks = (now_us - gesture->last_us) >> 6;
+    int32_t step = (int32_t)position - (int32_t)gesture->last_position;
+    int32_t instant = step * 15625 / (int32_t)((ticks > 0) ? ticks : 1u);
+    // Average of the last two steps, the first step stands alone.
+    gesture->velocity = (gesture->last_us == gesture->down_us) ? instant
+                                                               : (gesture->velocity + instant) / 2;
+    gesture->last_position = position;
+    gesture->last_us = now_us;
+
+    if ((gesture->state == GESTURE_DOWN) && !gesture->held &&
+        (gesture_distance(position, gesture->down_position) > gesture->config.move_max))
+    {
+        gesture->state = GESTURE_MOVING;
+        gesture_flush_tap(gesture, now_us);
+    }
+}
+
+static void gesture_lift(iqs7222c_gesture_t *gesture, uint32_t now_us)
+{
+    uint32_t duration = now_us - gesture->down_us;
+    int32_t distance = (int32_t)gesture->last_position - (int32_t)gesture->down_position;
+    int32_t velocity = (now_us - gesture->last_us > IQS7222C_GESTURE_REST_US) ? 0 : gesture->velocity;
+    uint32_t speed = (uint32_t)((velocity < 0) ? -velocity : velocity);
+
+    gesture->state = GESTURE_IDLE;
+    if (gesture->held)
+    {
+        gesture_emit(gesture, IQS7222C_GESTURE_HOLD_RELEASE, now_us, gesture->down_position, 0, 0);
+        return;
+    }
+
+    if (gesture_distance(gesture->last_position, gesture->down_position) >= gesture->config.swipe_min)
+    {
+        gesture_flush_tap(gesture, now_us);
+        gesture_emit(gesture,
+                     (speed >= gesture->config.fling_velocity) ? IQS7222C_GESTURE_FLING
+                                                               : IQS7222C_GESTURE_SWIPE,
+                     now_us, gesture->down_position, distance, velocity);
+    }
+    else if ((duration <= gesture->config.tap_max_us) &&
+             (gesture_distance(gesture->last_position, gesture->down_position) <=
+              gesture->config.move_max))
+    {
+        if (gesture->second_tap)
+        {
+            gesture->second_tap = false;
+            gesture_emit(gesture, IQS7222C_GESTURE_DOUBLE_TAP, now_us, gesture->tap_position, 0, 0);
+        }
+        else if (gesture->config.double_tap_gap_us == 0)
+        {
+            gesture_emit(gesture, IQS7222C_GESTURE_TAP, now_us, gesture->down_position, 0, 0);
+        }
+        else
+        {
+            gesture->state = GESTURE_TAP_WAIT;
+            gesture->tap_position = gesture->down_position;
+            gesture->tap_us = now_us;
+        }
+    }
+    else
+    {
+        // Too long for a tap, too short for a hold or too short a swipe.
+        gesture_flush_tap(gesture, now_us);
+    }
+}
+
+/* The touch after a tap turned out not to be its second tap. */
+static void gesture_flush_tap(iqs7222c_gesture_t *gesture, uint32_t now_us)
+{
+    if (gesture->second_tap)
+    {
+        gesture->second_tap = false;
+        gesture_emit(gesture, IQS7222C_GESTURE_TAP, now_us, gesture->tap_position, 0, 0);
+    }
+}
+
+static void gesture_emit(iqs7222c_gesture_t *gesture, uint8_t type, uint32_t now_us,
+                         uint16_t position, int32_t distance, int32_t velocity)
+{
+    iqs7222c_gesture_event_t event = {
+        .timestamp_us = now_us,
+        .velocity = velocity,
+        .distance = distance,
+        .position = position,
+        .type = type,
+        .slider = gesture->slider,
+    };
+
+    if (gesture->handler != NULL)
+    {
+        gesture->handler(gesture, &event, gesture->p_context);
+    }
+}
+
+static uint32_t gesture_distance(uint16_t a, uint16_t b)
+{
+    return (a > b) ? (uint32_t)(a - b) : (uint32_t)(b - a);
+}
+
+static void gesture_event(iqs7222c_t *dev, const iqs7222c_event_t *event, void *p_context)
+{
+    iqs7222c_gesture_t *gesture = p_context;
+
+    (void)dev;
+    if (event->index == gesture->slider)
+    {
+        iqs7222c_gesture_update(gesture, event->value, event->timestamp_us);
+    }
+}
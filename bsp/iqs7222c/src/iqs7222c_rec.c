@@ -0,0 +1,363 @@
+/** @file iqs7222c_rec.c
+*
+* @brief Compact recorder for per window diagnostics: RDY time, info flags,
+* prox and touch states, slider outputs and the counts and LTA of every
+* channel. Each frame starts with a mask of the fields that changed since the
+* previous frame, followed by the time step as a zig-zag varint of its
+* difference to the previous step (0 at a steady report rate) and then only
+* the changed fields. States are varints, slider outputs zig-zag varint
+* deltas, counts and LTA deltas zig-zag encoded and bit packed with the
+* smallest width that holds all ten channels. An unchanged window costs two
+* bytes. The reader is plain C and builds on target and host.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c_rec.h"
+#include <stddef.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+/* Frame mask, the fields present in this order */
+#define REC_INFO 0x01
+#define REC_PROX 0x02
+#define REC_TOUCH 0x04
+#define REC_SLIDER0 0x08
+#define REC_SLIDER1 0x10
+#define REC_COUNTS 0x20
+#define REC_LTA 0x40
+
+//----------------------------- DATA TYPES ------------------------------------
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static void rec_start(iqs7222c_rec_frame_t *last, uint32_t *lastDt);
+static uint8_t *rec_varint(uint8_t *out, uint32_t value);
+static uint8_t *rec_pack(uint8_t *out, const uint16_t *values, const uint16_t *last);
+static bool rec_get_varint(iqs7222c_rec_reader_t *reader, uint32_t *value);
+static bool rec_unpack(iqs7222c_rec_reader_t *reader, uint16_t *values);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+static const uint8_t recHeader[IQS7222C_REC_HEADER_BYTES] = {'I', 'Q', 'R', IQS7222C_REC_VERSION};
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+/* Start a recording in buffer. The first IQS7222C_REC_HEADER_BYTES hold the
+ * stream header, false if the buffer cannot hold it. */
+bool iqs7222c_rec_init(iqs7222c_rec_t *rec, uint8_t *buffer, uint32_t size)
+{
+    memset(rec, 0, sizeof(*rec));
+    if (size < IQS7222C_REC_HEADER_BYTES)
+    {
+        return false;
+    }
+
+    rec->buffer = buffer;
+    rec->size = size;
+    memcpy(buffer, recHeader, sizeof(recHeader));
+    rec->length = sizeof(recHeader);
+    rec->last_seq = UINT32_MAX;
+    rec_start(&rec->last, &rec->last_dt);
+    return true;
+}
+
+/* Append one frame, false if it was dropped because the buffer is full. */
+bool iqs7222c_rec_add(iqs7222c_rec_t *rec, const iqs7222c_rec_frame_t *frame)
+{
+    const iqs7222c_rec_frame_t *last = &rec->last;
+    uint8_t encoded[IQS7222C_REC_MAX_FRAME_BYTES];
+    uint8_t *out = &encoded[1];
+    uint8_t mask = 0;
+
+    uint32_t dt = frame->timestamp_us - last->timestamp_us;
+    int32_t ddt = (int32_t)(dt - rec->last_dt);
+    out = rec_varint(out, ((uint32_t)ddt << 1) ^ (uint32_t)(ddt >> 31));
+
+    if (frame->info_flags != last->info_flags)
+    {
+        mask |= REC_INFO;
+        *out++ = frame->info_flags;
+    }
+    if (frame->prox != last->prox)
+    {
+        mask |= REC_PROX;
+        out = rec_varint(out, frame->prox);
+    }
+    if (frame->touch != last->touch)
+    {
+        mask |= REC_TOUCH;
+        out = rec_varint(out, frame->touch);
+    }
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        if (frame->slider[i] != last->slider[i])
+        {
+            int16_t delta = (int16_t)(frame->slider[i] - last->slider[i]);
+
+            mask |= (i == 0) ? REC_SLIDER0 : REC_SLIDER1;
+            out = rec_varint(out, (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15)));
+        }
+    }
+    if (memcmp(frame->counts, last->counts, sizeof(frame->counts)) != 0)
+    {
+        mask |= REC_COUNTS;
+        out = rec_pack(out, frame->counts, last->counts);
+    }
+    if (memcmp(frame->lta, last->lta, sizeof(frame->lta)) != 0)
+    {
+        mask |= REC_LTA;
+        out = rec_pack(out, frame->lta, last->lta);
+    }
+    encoded[0] = mask;
+
+    uint32_t length = (uint32_t)(out - encoded);
+    if (length > rec->size - rec->length)
+    {
+        rec->dropped++;
+        return false;
+    }
+
+    memcpy(&rec->buffer[rec->length], encoded, length);
+    rec->length += length;
+    rec->frames++;
+    rec->last_dt = dt;
+    rec->last = *frame;
+    return true;
+}
+
+/* Record the latest decoded window of dev with the counts and LTA last read
+ * into its memory map (see iqs7222c_getTelemetry). Call after each update,
+ * e.g. when iqs7222c_isNewDataAvailable; a window that was already recorded
+ * is skipped. Returns true if a frame was added. */
+bool iqs7222c_rec_capture(iqs7222c_rec_t *rec, iqs7222c_t *dev)
+{
+    iqs7222c_frame_t frame;
+    iqs7222c_telemetry_t telemetry;
+    iqs7222c_rec_frame_t record;
+
+    uint32_t seq = iqs7222c_readFrame(dev, &frame);
+    if (seq == rec->last_seq)
+    {
+        return false;
+    }
+    rec->last_seq = seq;
+
+    iqs7222c_getTelemetry(dev, &telemetry);
+    record.timestamp_us = frame.timestamp_us;
+    record.info_flags = frame.info_flags;
+    record.prox = frame.prox;
+    record.touch = frame.touch;
+    record.slider[0] = frame.slider[0];
+    record.slider[1] = frame.slider[1];
+    memcpy(record.counts, telemetry.counts, sizeof(record.counts));
+    memcpy(record.lta, telemetry.lta, sizeof(record.lta));
+    return iqs7222c_rec_add(rec, &record);
+}
+
+/* Read back a recording of length bytes, false if the header does not
+ * match. */
+bool iqs7222c_rec_reader_init(iqs7222c_rec_reader_t *reader, const uint8_t *buffer,
+                              uint32_t length)
+{
+    memset(reader, 0, sizeof(*reader));
+    if ((length < IQS7222C_REC_HEADER_BYTES) ||
+        (memcmp(buffer, recHeader, sizeof(recHeader)) != 0))
+    {
+        return false;
+    }
+
+    reader->buffer = buffer;
+    reader->length = length;
+    reader->pos = sizeof(recHeader);
+    rec_start(&reader->last, &reader->last_dt);
+    return true;
+}
+
+/* Next frame, false at the end of the recording or on a truncated frame. */
+bool iqs7222c_rec_read(iqs7222c_rec_reader_t *reader, iqs7222c_rec_frame_t *frame)
+{
+    iqs7222c_rec_frame_t next = reader->last;
+    uint32_t value;
+
+    if (reader->pos >= reader->length)
+    {
+        return false;
+    }
+    uint8_t mask = reader->buffer[reader->pos++];
+
+    if (!rec_get_varint(reader, &value))
+    {
+        return false;
+    }
+    uint32_t dt = reader->last_dt + ((value >> 1) ^ (uint32_t)-(int32_t)(value & 1u));
+    next.timestamp_us += dt;
+
+    if (mask & REC_INFO)
+    {
+        if (reader->pos >= reader->length)
+        {
+            return false;
+        }
+        next.info_flags = reader->buffer[reader->pos++];
+    }
+    if (mask & REC_PROX)
+    {
+        if (!rec_get_varint(reader, &value))
+        {
+            return false;
+        }
+        next.prox = (uint16_t)value;
+    }
+    if (mask & REC_TOUCH)
+    {
+        if (!rec_get_varint(reader, &value))
+        {
+            return false;
+        }
+        next.touch = (uint16_t)value;
+    }
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        if (mask & ((i == 0) ? REC_SLIDER0 : REC_SLIDER1))
+        {
+            if (!rec_get_varint(reader, &value))
+            {
+                return false;
+            }
+            next.slider[i] += (uint16_t)((value >> 1) ^ (uint32_t)-(int32_t)(value & 1u));
+        }
+    }
+    if ((mask & REC_COUNTS) && !rec_unpack(reader, next.counts))
+    {
+        return false;
+    }
+    if ((mask & REC_LTA) && !rec_unpack(reader, next.lta))
+    {
+        return false;
+    }
+
+    reader->last_dt = dt;
+    reader->last = next;
+    *frame = next;
+    return true;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* State both sides start from. */
+static void rec_start(iqs7222c_rec_frame_t *last, uint32_t *lastDt)
+{
+    memset(last, 0, sizeof(*last));
+    last->slider[0] = IQS7222C_SLIDER_NO_TOUCH;
+    last->slider[1] = IQS7222C_SLIDER_NO_TOUCH;
+    *lastDt = 0;
+}
+
+/* Seven bits per byte, least significant first, bit 7 set on all but the
+ * last byte. */
+static uint8_t *rec_varint(uint8_t *out, uint32_t value)
+{
+    while (value >= 0x80u)
+    {
+        *out++ = (uint8_t)(value | 0x80u);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+/* Zig-zag deltas of all channels, a width byte and then each delta in
+ * width bits, least significant bit first, padded to a whole byte. */
+static uint8_t *rec_pack(uint8_t *out, const uint16_t *values, const uint16_t *last)
+{
+    uint16_t zigzag[IQS7222C_CHANNELS];
+    uint16_t all = 0;
+    uint8_t width = 0;
+
+    for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+    {
+        int16_t delta = (int16_t)(values[ch] - last[ch]);
+
+        zigzag[ch] = (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+        all |= zigzag[ch];
+    }
+    while ((width < 16) && ((all >> width) != 0))
+    {
+        width++;
+    }
+    *out++ = width;
+
+    uint32_t bits = 0;
+    uint8_t used = 0;
+    for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+    {
+        bits |= (uint32_t)zigzag[ch] << used;
+        used += width;
+        while (used >= 8)
+        {
+            *out++ = (uint8_t)bits;
+            bits >>= 8;
+            used -= 8;
+        }
+    }
+    if (used != 0)
+    {
+        *out++ = (uint8_t)bits;
+    }
+    return out;
+}
+
+static bool rec_get_varint(iqs7222c_rec_reader_t *reader, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        if (reader->pos >= reader->length)
+        {
+            return false;
+        }
+        uint8_t byte = reader->buffer[reader->pos++];
+        result |= (uint32_t)(byte & 0x7Fu) << shift;
+        if ((byte & 0x80u) == 0)
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Inverse of rec_pack, applied to the previous values. */
+static bool rec_unpack(iqs7222c_rec_reader_t *reader, uint16_t *values)
+{
+    if (reader->pos >= reader->length)
+    {
+        return false;
+    }
+    uint8_t width = reader->buffer[reader->pos++];
+    if ((width > 16) || ((IQS7222C_CHANNELS * width + 7u) / 8u > reader->length - reader->pos))
+    {
+        return false;
+    }
+
+    uint32_t bits = 0;
+    uint8_t have = 0;
+    for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+    {
+        while (have < width)
+        {
+            bits |= (uint32_t)reader->buffer[reader->pos++] << have;
+            have += 8;
+        }
+        uint16_t zigzag = (uint16_t)(bits & ((1u << width) - 1u));
+        bits >>= width;
+        have -= width;
+        values[ch] += (uint16_t)((zigzag >> 1) ^ (uint16_t)-(int16_t)(zigzag & 1u));
+    }
+    return true;
+}
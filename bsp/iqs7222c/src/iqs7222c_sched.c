@@ -0,0 +1,169 @@
+/** @file iqs7222c_sched.c
+*
+* @brief Window scheduler for several IQS7222C sharing one TWI bus. RDY edges
+* only mark a device as pending; iqs7222c_sched_run then services the pending
+* windows earliest deadline first, where the deadline is the RDY edge plus the
+* COMMS_TIMEOUT of that device, read from its register shadow. A window already
+* past its deadline is closed on the device side, it is counted as missed and
+* skipped instead of blocking the bus with an out of window transfer. Control
+* commands are queued per device and written in that device's next window,
+* ahead of its status burst; a write that fails stays queued.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c_sched.h"
+#include <stddef.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+//----------------------------- DATA TYPES ------------------------------------
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static iqs7222c_sched_slot_t *sched_slot(const iqs7222c_sched_t *sched, const iqs7222c_t *dev);
+static iqs7222c_sched_slot_t *sched_next(iqs7222c_sched_t *sched, uint32_t now);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+void iqs7222c_sched_init(iqs7222c_sched_t *sched)
+{
+    memset(sched, 0, sizeof(*sched));
+}
+
+/* Register a device after iqs7222c_begin. Its windows are then serviced by
+ * iqs7222c_sched_run instead of iqs7222c_run. */
+bool iqs7222c_sched_add(iqs7222c_sched_t *sched, iqs7222c_t *dev)
+{
+    if (sched->count >= IQS7222C_SCHED_MAX_DEVICES)
+    {
+        return false;
+    }
+
+    iqs7222c_sched_slot_t *slot = &sched->slots[sched->count++];
+    memset(slot, 0, sizeof(*slot));
+    slot->dev = dev;
+    return true;
+}
+
+/* Queue control settings action bits for the device's next window. Requests
+ * made before that window are merged into one write. */
+bool iqs7222c_sched_request(iqs7222c_sched_t *sched, iqs7222c_t *dev, uint8_t controlBits)
+{
+    iqs7222c_sched_slot_t *slot = sched_slot(sched, dev);
+    if (slot == NULL)
+    {
+        return false;
+    }
+
+    slot->control_bits |= controlBits;
+    return true;
+}
+
+/* Service every pending window, earliest deadline first, re-evaluating the
+ * order after each one since new RDY edges may arrive meanwhile. Call from
+ * the main loop after a RDY interrupt. Returns the number of windows read. */
+uint8_t iqs7222c_sched_run(iqs7222c_sched_t *sched)
+{
+    uint8_t serviced = 0;
+
+    if (sched->count == 0)
+    {
+        return 0;
+    }
+
+    for (;;)
+    {
+        uint32_t now = i2c_touch_time_us(&sched->slots[0].dev->bus);
+        iqs7222c_sched_slot_t *slot = sched_next(sched, now);
+        if (slot == NULL)
+        {
+            break;
+        }
+
+        iqs7222c_t *dev = slot->dev;
+        uint32_t lateness = now - dev->rdy_time_us;
+        if (lateness > slot->stats.max_lateness_us)
+        {
+            slot->stats.max_lateness_us = lateness;
+        }
+
+        // A failed write keeps the bits queued for the next window.
+        if ((slot->control_bits != 0) &&
+            (iqs7222c_setControlBits(dev, slot->control_bits, RESTART) == I2C_TOUCH_SUCCESS))
+        {
+            slot->control_bits = 0;
+            slot->stats.commands++;
+        }
+        iqs7222c_run(dev);
+        slot->stats.serviced++;
+        serviced++;
+    }
+
+    return serviced;
+}
+
+const iqs7222c_sched_stats_t *iqs7222c_sched_stats(const iqs7222c_sched_t *sched,
+                                                   const iqs7222c_t *dev)
+{
+    iqs7222c_sched_slot_t *slot = sched_slot(sched, dev);
+    return (slot != NULL) ? &slot->stats : NULL;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+static iqs7222c_sched_slot_t *sched_slot(const iqs7222c_sched_t *sched, const iqs7222c_t *dev)
+{
+    for (uint8_t i = 0; i < sched->count; i++)
+    {
+        if (sched->slots[i].dev == dev)
+        {
+            return (iqs7222c_sched_slot_t *)&sched->slots[i];
+        }
+    }
+    return NULL;
+}
+
+/* Pending window with the least time left. Windows past their deadline are
+ * dropped on the way. A device whose comms timeout is unknown (shadow not
+ * read yet, or COMMS_TIMEOUT 0) is never dropped and goes after the others. */
+static iqs7222c_sched_slot_t *sched_next(iqs7222c_sched_t *sched, uint32_t now)
+{
+    iqs7222c_sched_slot_t *next = NULL;
+    uint32_t nextLeft = 0;
+
+    for (uint8_t i = 0; i < sched->count; i++)
+    {
+        iqs7222c_sched_slot_t *slot = &sched->slots[i];
+        if (!slot->dev->device_rdy)
+        {
+            continue;
+        }
+
+        uint32_t window = iqs7222c_getCommsTimeoutUs(slot->dev);
+        uint32_t age = now - slot->dev->rdy_time_us;
+        if ((window != UINT32_MAX) && (age >= window))
+        {
+            slot->dev->device_rdy = false;
+            slot->stats.missed++;
+            continue;
+        }
+
+        uint32_t left = (window != UINT32_MAX) ? window - age : UINT32_MAX;
+        if ((next == NULL) || (left < nextLeft))
+        {
+            next = slot;
+            nextLeft = left;
+        }
+    }
+
+    return next;
+}
+
+//--------------------------- INTERRUPT HANDLERS ------------------------------
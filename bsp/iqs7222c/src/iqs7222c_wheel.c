@@ -0,0 +1,173 @@
+/** @file iqs7222c_wheel.c
+*
+* @brief Rotation of a slider set up as a wheel (IQS7222C_MM_SLIDER_SETUP_0/1).
+* The absolute coordinate of every window is unwrapped across the 0 / range
+* boundary into a signed position. Of the three readings of a step (as read,
+* plus or minus a turn) the one closest to the previous step is taken, so a
+* steady spin of up to a full turn per window keeps its direction; from rest
+* the shortest way round is taken. The position is cut into detents with the
+* remainder carried over, a detent counts only after its full travel in one
+* direction, so noise at a detent boundary never toggles it. Every step
+* needs its own window: in event mode keep the slider event bits of
+* IQS7222C_MM_EVENT_ENABLE set, as IQS7222C_init.h does, or turn on stream in
+* touch.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c_wheel.h"
+#include <stddef.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+//----------------------------- DATA TYPES ------------------------------------
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static int32_t wheel_unwrap(const iqs7222c_wheel_t *wheel, uint16_t position, uint32_t now_us);
+static int32_t wheel_abs(int32_t value);
+static void wheel_event(iqs7222c_t *dev, const iqs7222c_event_t *event, void *p_context);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+/* 24 detents per turn of a wheel with the given resolution. */
+void iqs7222c_wheel_default_config(iqs7222c_wheel_config_t *config, uint16_t range)
+{
+    config->range = range;
+    config->counts_per_detent = (range >= 24u) ? (uint16_t)(range / 24u) : 1u;
+}
+
+void iqs7222c_wheel_init(iqs7222c_wheel_t *wheel, const iqs7222c_wheel_config_t *config,
+                         IQS7222C_slider_e slider, iqs7222c_wheel_handler_t handler,
+                         void *p_context)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->config = *config;
+    if (wheel->config.counts_per_detent == 0)
+    {
+        wheel->config.counts_per_detent = 1;
+    }
+    wheel->slider = slider;
+    wheel->handler = handler;
+    wheel->p_context = p_context;
+}
+
+/* Feed the wheel from the slider events of dev, the handler then runs in the
+ * context that decodes the status burst. */
+bool iqs7222c_wheel_attach(iqs7222c_wheel_t *wheel, iqs7222c_t *dev)
+{
+    return iqs7222c_subscribe(dev, IQS7222C_EVENT_MASK(IQS7222C_EVENT_SLIDER), IQS7222C_ALL_CHANNELS,
+                              wheel_event, wheel);
+}
+
+void iqs7222c_wheel_detach(iqs7222c_wheel_t *wheel, iqs7222c_t *dev)
+{
+    iqs7222c_unsubscribe(dev, wheel_event, wheel);
+}
+
+/* Wheel coordinate of the window at now_us, IQS7222C_SLIDER_NO_TOUCH when
+ * not touched. Returns the detents crossed, the handler is called when they
+ * are not 0. A touch down only sets the reference, lifting stops the wheel. */
+int32_t iqs7222c_wheel_update(iqs7222c_wheel_t *wheel, uint16_t position, uint32_t now_us)
+{
+    int32_t counts = wheel->config.counts_per_detent;
+    int32_t detents = 0;
+
+    if (position == IQS7222C_SLIDER_NO_TOUCH)
+    {
+        wheel->touched = false;
+        wheel->velocity = 0;
+        return 0;
+    }
+    if (wheel->config.range > 0)
+    {
+        position %= wheel->config.range;
+    }
+    if (!wheel->touched)
+    {
+        wheel->touched = true;
+        wheel->last_position = position;
+        wheel->last_us = now_us;
+        wheel->last_step = 0;
+        wheel->remainder = 0;
+        return 0;
+    }
+
+    int32_t step = wheel_unwrap(wheel, position, now_us);
+    uint32_t ticks = (now_us - wheel->last_us) >> 6;
+    // Counts per second as step * 1e6 / dt, in 32 bits with dt in 64 us ticks.
+    wheel->velocity = step * 15625 / (int32_t)((ticks > 0) ? ticks : 1u);
+    wheel->last_step = step;
+    wheel->last_position = position;
+    wheel->last_us = now_us;
+    wheel->position += step;
+
+    wheel->remainder += step;
+    if (wheel_abs(wheel->remainder) >= counts)
+    {
+        detents = wheel->remainder / counts;
+        wheel->remainder -= detents * counts;
+        wheel->total += detents;
+
+        iqs7222c_wheel_event_t event = {
+            .timestamp_us = now_us,
+            .detents = detents,
+            .total = wheel->total,
+            .velocity = wheel->velocity,
+            .slider = wheel->slider,
+        };
+        if (wheel->handler != NULL)
+        {
+            wheel->handler(wheel, &event, wheel->p_context);
+        }
+    }
+    return detents;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Signed step from the last coordinate, the reading closest to the last step,
+ * or to 0 once the wheel has rested. */
+static int32_t wheel_unwrap(const iqs7222c_wheel_t *wheel, uint16_t position, uint32_t now_us)
+{
+    int32_t range = wheel->config.range;
+    int32_t step = (int32_t)position - (int32_t)wheel->last_position;
+    int32_t predicted = (now_us - wheel->last_us > IQS7222C_WHEEL_REST_US) ? 0 : wheel->last_step;
+
+    if (range == 0)
+    {
+        return step;
+    }
+    if (wheel_abs(step + range - predicted) < wheel_abs(step - predicted))
+    {
+        step += range;
+    }
+    else if (wheel_abs(step - range - predicted) < wheel_abs(step - predicted))
+    {
+        step -= range;
+    }
+    return step;
+}
+
+static int32_t wheel_abs(int32_t value)
+{
+    return (value < 0) ? -value : value;
+}
+
+static void wheel_event(iqs7222c_t *dev, const iqs7222c_event_t *event, void *p_context)
+{
+    iqs7222c_wheel_t *wheel = p_context;
+
+    (void)dev;
+    if (event->index == wheel->slider)
+    {
+        iqs7222c_wheel_update(wheel, event->value, event->timestamp_us);
+    }
+}
@@ -0,0 +1,299 @@
+/** @file i2c_touch_replay.c
+*
+* @brief Host bus device that answers from an i2c_touch_trace recording. Each
+* write and read the driver makes is matched against the next record and
+* gets the recorded result and data back, so the driver takes the same path
+* as on the traced system. RDY falling edges are replayed with the recorded
+* spacing to the previous transfer. An edge recorded ahead of a transfer is
+* delivered on the next clock step. The RDY line goes high when the trace
+* shows the window closed with a stop. Transfers that differ from the trace
+* are counted as mismatches; a transfer of the wrong kind is NACKed and does
+* not consume the record.
+*
+* Traces of one device only. The host clock is free to jump between records
+* (see i2c_touch_replay_next_us), so a trace replays as fast as the driver
+* runs. Driver timers are not in the trace, so step the clock at most as far
+* as the recording loop did between driver calls.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "i2c_touch_replay.h"
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	uint8_t type;
+	uint32_t time_us;
+	uint8_t address;
+	uint8_t flags;
+	int result;
+	uint32_t len;
+	const uint8_t *payload;
+} replay_record_t;
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static int replay_tx(void *device, uint8_t address, uint8_t const *data, uint32_t len, bool stop);
+static int replay_rx(void *device, uint8_t address, uint8_t *data, uint32_t len);
+static bool replay_pin_is_set(void *device, uint32_t pin);
+static void replay_advance(void *device, uint32_t now_us);
+static bool replay_parse(const i2c_touch_replay_t *replay, uint32_t pos, replay_record_t *record);
+static bool replay_head(const i2c_touch_replay_t *replay, replay_record_t *record);
+static bool replay_edge_held(const i2c_touch_replay_t *replay, const replay_record_t *edge);
+static bool replay_transfer(i2c_touch_replay_t *replay, uint8_t type, replay_record_t *record);
+static void replay_consume(i2c_touch_replay_t *replay, const replay_record_t *record);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+const i2c_touch_host_device_t i2c_touch_replay_device = {
+	.tx = replay_tx,
+	.rx = replay_rx,
+	.pin_is_set = replay_pin_is_set,
+	.advance = replay_advance,
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+/* Replay length bytes of trace, false if the file header does not match.
+ * Attach with i2c_touch_host_attach on replay->address and begin the driver
+ * on replay->pin. */
+bool i2c_touch_replay_init(i2c_touch_replay_t *replay, const uint8_t *trace, uint32_t length)
+{
+	static const uint8_t header[I2C_TOUCH_TRACE_HEADER_BYTES] = {'I', '2', 'C', 'T',
+	                                                             I2C_TOUCH_TRACE_VERSION};
+
+	memset(replay, 0, sizeof(*replay));
+	if ((length < sizeof(header)) || (memcmp(trace, header, sizeof(header)) != 0))
+	{
+		return false;
+	}
+
+	replay->trace = trace;
+	replay->length = length;
+	replay->pos = sizeof(header);
+	replay->rdy_pin = UINT32_MAX;
+	replay->pin = UINT32_MAX;
+
+	replay_record_t record;
+	bool addressFound = false;
+	for (uint32_t pos = replay->pos; replay_parse(replay, pos, &record);
+	     pos += I2C_TOUCH_TRACE_RECORD_BYTES + record.len)
+	{
+		if ((record.type == I2C_TOUCH_TRACE_EDGE) && (replay->pin == UINT32_MAX))
+		{
+			replay->pin = record.address;
+		}
+		else if ((record.type != I2C_TOUCH_TRACE_EDGE) && !addressFound)
+		{
+			replay->address = record.address;
+			addressFound = true;
+		}
+		if (addressFound && (replay->pin != UINT32_MAX))
+		{
+			break;
+		}
+	}
+	return true;
+}
+
+/* Host time at which the next record is due: an edge at its replay time, a
+ * transfer at its recorded spacing (the driver may issue it earlier or
+ * later). UINT32_MAX at the end of the trace. */
+uint32_t i2c_touch_replay_next_us(const i2c_touch_replay_t *replay)
+{
+	replay_record_t record;
+
+	if (replay->pending_edges != 0)
+	{
+		return replay->now_us;
+	}
+	if (!replay_head(replay, &record))
+	{
+		return UINT32_MAX;
+	}
+	if (!replay->synced)
+	{
+		return replay->now_us;
+	}
+
+	uint32_t due = record.time_us + replay->offset_us;
+	return ((int32_t)(due - replay->now_us) > 0) ? due : replay->now_us;
+}
+
+/* Every record replayed and every edge delivered. */
+bool i2c_touch_replay_done(const i2c_touch_replay_t *replay)
+{
+	return (replay->pos >= replay->length) && (replay->pending_edges == 0);
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+static int replay_tx(void *device, uint8_t address, uint8_t const *data, uint32_t len, bool stop)
+{
+	i2c_touch_replay_t *replay = device;
+	replay_record_t record;
+
+	if (!replay_transfer(replay, I2C_TOUCH_TRACE_TX, &record))
+	{
+		return I2C_TOUCH_ERROR_ANACK;
+	}
+
+	if ((record.address != address) || (record.len != len) ||
+	    (memcmp(record.payload, data, len) != 0) ||
+	    (((record.flags & I2C_TOUCH_TRACE_STOP) != 0) != stop))
+	{
+		replay->stats.mismatches++;
+	}
+
+	if (record.flags & I2C_TOUCH_TRACE_STOP)
+	{
+		replay->window_open = false;
+	}
+	return record.result;
+}
+
+static int replay_rx(void *device, uint8_t address, uint8_t *data, uint32_t len)
+{
+	i2c_touch_replay_t *replay = device;
+	replay_record_t record;
+
+	if (!replay_transfer(replay, I2C_TOUCH_TRACE_RX, &record))
+	{
+		return I2C_TOUCH_ERROR_ANACK;
+	}
+
+	if ((record.address != address) || (record.len != len))
+	{
+		replay->stats.mismatches++;
+	}
+	uint32_t copy = (record.len < len) ? record.len : len;
+	memcpy(data, record.payload, copy);
+	memset(&data[copy], 0, len - copy);
+
+	// Every read ends with a stop.
+	replay->window_open = false;
+	return record.result;
+}
+
+static bool replay_pin_is_set(void *device, uint32_t pin)
+{
+	i2c_touch_replay_t *replay = device;
+	return (pin != replay->rdy_pin) || !replay->window_open;
+}
+
+/* Edges that are due pull RDY low, one per clock step: a window still open
+ * from the previous edge timed out, so the line goes high first. */
+static void replay_advance(void *device, uint32_t now_us)
+{
+	i2c_touch_replay_t *replay = device;
+	replay_record_t record;
+
+	replay->now_us = now_us;
+	if (!replay->synced && replay_head(replay, &record))
+	{
+		replay->offset_us = now_us - record.time_us;
+		replay->synced = true;
+	}
+
+	while (replay_head(replay, &record) && (record.type == I2C_TOUCH_TRACE_EDGE) &&
+	       ((int32_t)(now_us - (record.time_us + replay->offset_us)) >= 0) &&
+	       !replay_edge_held(replay, &record))
+	{
+		replay_consume(replay, &record);
+	}
+
+	if (replay->pending_edges != 0)
+	{
+		if (replay->window_open)
+		{
+			replay->window_open = false;
+		}
+		else
+		{
+			replay->window_open = true;
+			replay->pending_edges--;
+			replay->stats.edges++;
+		}
+	}
+}
+
+static bool replay_parse(const i2c_touch_replay_t *replay, uint32_t pos, replay_record_t *record)
+{
+	const uint8_t *p = &replay->trace[pos];
+
+	if (replay->length - pos < I2C_TOUCH_TRACE_RECORD_BYTES)
+	{
+		return false;
+	}
+
+	record->type = p[0];
+	record->time_us = (uint32_t)p[1] | ((uint32_t)p[2] << 8) | ((uint32_t)p[3] << 16) |
+	                  ((uint32_t)p[4] << 24);
+	record->address = p[5];
+	record->flags = p[6];
+	record->result = p[7] | (p[8] << 8);
+	record->len = (uint32_t)p[9] | ((uint32_t)p[10] << 8);
+	record->payload = &p[I2C_TOUCH_TRACE_RECORD_BYTES];
+	return record->len <= replay->length - pos - I2C_TOUCH_TRACE_RECORD_BYTES;
+}
+
+static bool replay_head(const i2c_touch_replay_t *replay, replay_record_t *record)
+{
+	return replay_parse(replay, replay->pos, record);
+}
+
+/* An edge stamped after the start of the transfer recorded behind it
+ * fell during that transfer, it waits until the driver issues it. */
+static bool replay_edge_held(const i2c_touch_replay_t *replay, const replay_record_t *edge)
+{
+	replay_record_t next;
+	uint32_t pos = replay->pos;
+
+	while (replay_parse(replay, pos, &next))
+	{
+		if (next.type != I2C_TOUCH_TRACE_EDGE)
+		{
+			return (int32_t)(edge->time_us - next.time_us) > 0;
+		}
+		pos += I2C_TOUCH_TRACE_RECORD_BYTES + next.len;
+	}
+	return false;
+}
+
+/* Next record of type for a transfer, passing edges recorded ahead of it. */
+static bool replay_transfer(i2c_touch_replay_t *replay, uint8_t type, replay_record_t *record)
+{
+	while (replay_head(replay, record) && (record->type == I2C_TOUCH_TRACE_EDGE))
+	{
+		replay_consume(replay, record);
+	}
+	if (!replay_head(replay, record) || (record->type != type))
+	{
+		replay->stats.mismatches++;
+		return false;
+	}
+
+	replay_consume(replay, record);
+	replay->offset_us = replay->now_us - record->time_us;
+	replay->synced = true;
+	replay->stats.transfers++;
+	return true;
+}
+
+static void replay_consume(i2c_touch_replay_t *replay, const replay_record_t *record)
+{
+	if (record->type == I2C_TOUCH_TRACE_EDGE)
+	{
+		replay->rdy_pin = record->address;
+		replay->pending_edges++;
+	}
+	replay->pos += I2C_TOUCH_TRACE_RECORD_BYTES + record->len;
+}
@@ -0,0 +1,60 @@
+/** @file i2c_touch_replay.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef I2C_TOUCH_REPLAY_H
+#define I2C_TOUCH_REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "i2c_touch_host.h"
+#include "i2c_touch_trace.h"
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	uint32_t transfers;  // tx and rx records answered
+	uint32_t edges;      // RDY falling edges replayed
+	uint32_t mismatches; // transfers that differ from the trace
+} i2c_touch_replay_stats_t;
+
+/* Device on the host bus answering from a trace of one device. */
+typedef struct
+{
+	const uint8_t *trace;
+	uint32_t length;
+	uint8_t address;  // of the first transfer in the trace
+	uint32_t pin;     // of the first RDY edge, UINT32_MAX if none
+	i2c_touch_replay_stats_t stats;
+
+	// Private.
+	uint32_t pos;           // next record
+	uint32_t now_us;        // host clock at the last advance
+	uint32_t offset_us;     // host clock minus trace time
+	bool synced;            // offset_us set
+	bool window_open;       // RDY low
+	uint16_t pending_edges; // edges passed by a transfer, not yet delivered
+	uint32_t rdy_pin;
+} i2c_touch_replay_t;
+
+extern const i2c_touch_host_device_t i2c_touch_replay_device;
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+bool i2c_touch_replay_init(i2c_touch_replay_t *replay, const uint8_t *trace, uint32_t length);
+uint32_t i2c_touch_replay_next_us(const i2c_touch_replay_t *replay);
+bool i2c_touch_replay_done(const i2c_touch_replay_t *replay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2C_TOUCH_REPLAY_H
@@ -0,0 +1,286 @@
+/** @file iqs7222c_bench.c
+*
+* @brief Host benchmarks for the driver hot paths, run against the host
+* backend and the register model. Build from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_bench.c \
+*       bsp/iqs7222c/src/iqs7222c.c src/host/iqs7222c_sim.c \
+*       src/wrappers/i2c_touch.c src/wrappers/i2c_touch_host.c -o iqs7222c_bench
+*
+* and run ./iqs7222c_bench [-j] [iterations]. Each case reports host CPU time
+* per operation and, from iqs7222c_getBusStats, bus bytes and simulated wire
+* time per operation. -j prints one JSON object per case and line instead of
+* the table.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+#include "iqs7222c_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define BENCH_ITERATIONS 1000000u
+#define BENCH_STEP_US 100
+
+//----------------------------- DATA TYPES ------------------------------------
+
+/* Bus traffic of one case, summed over all classes. */
+typedef struct
+{
+	uint64_t bytes;
+	uint64_t wire_us;
+} bench_bus_t;
+
+typedef struct
+{
+	const char *name;
+	void (*run)(uint32_t ops, bench_bus_t *bus);
+	uint32_t divisor; // ops = iterations / divisor, for the slow cases
+} bench_case_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static void bench_status_update(uint32_t ops, bench_bus_t *bus);
+static void bench_channel_state(uint32_t ops, bench_bus_t *bus);
+static void bench_channel_masks(uint32_t ops, bench_bus_t *bus);
+static void bench_init(uint32_t ops, bench_bus_t *bus);
+static void bench_write_mm(uint32_t ops, bench_bus_t *bus);
+static void bench_telemetry(uint32_t ops, bench_bus_t *bus);
+static void bench_start(bool touched);
+static void bench_bus_add(bench_bus_t *bus);
+static uint64_t bench_now_ns(void);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t sim;
+static iqs7222c_t dev;
+static volatile uint32_t sink;
+
+static const bench_case_t benchCases[] = {
+	{"status_update", bench_status_update, 10},
+	{"channel_state_x20", bench_channel_state, 1},
+	{"channel_masks", bench_channel_masks, 1},
+	{"init", bench_init, 10000},
+	{"write_mm", bench_write_mm, 100},
+	{"telemetry", bench_telemetry, 10},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = BENCH_ITERATIONS;
+	bool json = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-j") == 0)
+		{
+			json = true;
+		}
+		else
+		{
+			iterations = (uint32_t)strtoul(argv[i], NULL, 0);
+		}
+	}
+
+	if (!json)
+	{
+		printf("%-20s %10s %12s %14s %14s\n", "case", "ops", "ns/op", "bus bytes/op", "wire us/op");
+	}
+	for (uint32_t i = 0; i < sizeof(benchCases) / sizeof(benchCases[0]); i++)
+	{
+		const bench_case_t *benchCase = &benchCases[i];
+		uint32_t ops = iterations / benchCase->divisor;
+		bench_bus_t bus = {0};
+
+		ops = (ops != 0) ? ops : 1;
+		uint64_t start = bench_now_ns();
+		benchCase->run(ops, &bus);
+		uint64_t elapsed = bench_now_ns() - start;
+
+		double nsPerOp = (double)elapsed / ops;
+		double bytesPerOp = (double)bus.bytes / ops;
+		double wirePerOp = (double)bus.wire_us / ops;
+		if (json)
+		{
+			printf("{\"case\":\"%s\",\"ops\":%u,\"ns_per_op\":%.2f,\"bus_bytes_per_op\":%.2f,"
+			       "\"wire_us_per_op\":%.2f}\n",
+			       benchCase->name, ops, nsPerOp, bytesPerOp, wirePerOp);
+		}
+		else
+		{
+			printf("%-20s %10u %12.2f %14.2f %14.2f\n", benchCase->name, ops, nsPerOp, bytesPerOp,
+			       wirePerOp);
+		}
+	}
+	return 0;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* The per window status read and decode, one fixed burst with both slider
+ * outputs, and the consumer draining the event queue. Includes the host
+ * backend and model handling the transfer. */
+static void bench_status_update(uint32_t ops, bench_bus_t *bus)
+{
+	iqs7222c_event_t events[IQS7222C_EVENT_QUEUE_SIZE];
+
+	bench_start(true);
+	iqs7222c_setReadPlan(&dev, IQS7222C_READ_FIXED, IQS7222C_READ_SLIDERS);
+	iqs7222c_resetBusStats(&dev);
+
+	for (uint32_t i = 0; i < ops; i++)
+	{
+		iqs7222c_queueValueUpdates(&dev);
+		iqs7222c_readEvents(&dev, events, IQS7222C_EVENT_QUEUE_SIZE);
+	}
+	bench_bus_add(bus);
+}
+
+/* Every channel through the per channel queries, as a polling consumer does
+ * each frame. */
+static void bench_channel_state(uint32_t ops, bench_bus_t *bus)
+{
+	uint32_t active = 0;
+
+	(void)bus;
+	bench_start(true);
+	for (uint32_t i = 0; i < ops; i++)
+	{
+		for (uint8_t channel = IQS7222C_CH0; channel <= IQS7222C_CH9; channel++)
+		{
+			active += iqs7222c_channel_touchState(&dev, channel);
+			active += iqs7222c_channel_proxState(&dev, channel);
+		}
+	}
+	sink = active;
+}
+
+/* The same information from the bulk masks, visiting the active channels
+ * only. */
+static void bench_channel_masks(uint32_t ops, bench_bus_t *bus)
+{
+	uint32_t active = 0;
+
+	(void)bus;
+	bench_start(true);
+	for (uint32_t i = 0; i < ops; i++)
+	{
+		iqs7222c_channel_masks_t masks = iqs7222c_getChannelMasks(&dev);
+
+		for (uint16_t m = masks.touch; m != 0;)
+		{
+			active += iqs7222c_nextChannel(&m) + 1u;
+		}
+		for (uint16_t m = masks.prox; m != 0;)
+		{
+			active += iqs7222c_nextChannel(&m) + 1u;
+		}
+	}
+	sink = active;
+}
+
+/* iqs7222c_begin and the full cold start-up sequence from power on,
+ * including the simulated waits for RDY windows, reset and ATI. */
+static void bench_init(uint32_t ops, bench_bus_t *bus)
+{
+	for (uint32_t i = 0; i < ops; i++)
+	{
+		bench_start(false);
+		bench_bus_add(bus);
+	}
+}
+
+/* The full IQS7222C_init.h configuration write. */
+static void bench_write_mm(uint32_t ops, bench_bus_t *bus)
+{
+	bench_start(false);
+	iqs7222c_resetBusStats(&dev);
+
+	for (uint32_t i = 0; i < ops; i++)
+	{
+		iqs7222c_writeMM(&dev, STOP);
+	}
+	bench_bus_add(bus);
+}
+
+/* Counts and LTA of all channels read and decoded. */
+static void bench_telemetry(uint32_t ops, bench_bus_t *bus)
+{
+	iqs7222c_telemetry_t telemetry;
+	int32_t total = 0;
+
+	bench_start(true);
+	iqs7222c_resetBusStats(&dev);
+
+	for (uint32_t i = 0; i < ops; i++)
+	{
+		iqs7222c_readTelemetry(&dev, &telemetry, STOP);
+		total += telemetry.delta[IQS7222C_CH3];
+	}
+	sink = (uint32_t)total;
+	bench_bus_add(bus);
+}
+
+/* A freshly powered device through start-up, optionally with two channels
+ * touched and decoded. */
+static void bench_start(bool touched)
+{
+	iqs7222c_sim_config_t config;
+
+	memset(&dev, 0, sizeof(dev));
+	i2c_touch_host_setup(&host, 400000);
+	iqs7222c_sim_default_config(&config);
+	iqs7222c_sim_init(&sim, &config);
+	i2c_touch_host_attach(&host, config.address, &iqs7222c_sim_device, &sim);
+
+	if (!iqs7222c_begin(&dev, config.address, config.rdy_pin, &host))
+	{
+		fprintf(stderr, "begin failed\n");
+		exit(1);
+	}
+	while (!iqs7222c_init(&dev))
+	{
+		i2c_touch_host_advance(&host, BENCH_STEP_US);
+	}
+
+	if (touched)
+	{
+		iqs7222c_sim_set_delta(&sim, IQS7222C_CH3, 200);
+		iqs7222c_sim_set_delta(&sim, IQS7222C_CH5, 200);
+		for (uint32_t i = 0; i < 1000; i++)
+		{
+			i2c_touch_host_advance(&host, BENCH_STEP_US);
+			iqs7222c_run(&dev);
+		}
+	}
+}
+
+static void bench_bus_add(bench_bus_t *bus)
+{
+	iqs7222c_bus_stats_t stats = iqs7222c_getBusStats(&dev);
+
+	for (uint8_t op = 0; op < IQS7222C_BUS_OPS; op++)
+	{
+		bus->bytes += stats.op[op].bytes;
+		bus->wire_us += stats.op[op].wire_us;
+	}
+}
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
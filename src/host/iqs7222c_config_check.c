@@ -0,0 +1,494 @@
+/** @file iqs7222c_config_check.c
+*
+* @brief Host check of the configuration burst planner, run against the host
+* backend and the register model. Each case stages single bytes with
+* iqs7222c_setConfig, compares the bursts of iqs7222c_planConfig with the
+* expected list, writes them with iqs7222c_flushConfig and then compares the
+* whole writable register image of the model with the staged bytes. Build
+* from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_config_check.c \
+*       bsp/iqs7222c/src/iqs7222c.c src/host/iqs7222c_sim.c \
+*       src/wrappers/i2c_touch.c src/wrappers/i2c_touch_host.c -o iqs7222c_config_check
+*
+* and run ./iqs7222c_config_check, which exits with 1 if a case fails. No
+* address range is longer than the default IQS7222C_MAX_BURST_BYTES, build
+* once more with -DIQS7222C_MAX_BURST_BYTES=16 to split bursts inside a range.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+#include "iqs7222c_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_STEP_US 100
+#define CHECK_MAX_BURSTS 32
+
+/* Writable registers, the extended setup ranges and then the system range. */
+#define CHECK_RANGES 7
+#define CHECK_IMAGE_WORDS (IQS7222C_SHADOW_BYTES / 2)
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	bool (*run)(void);
+} check_case_t;
+
+/* Address range of the shadow, with the same number of words per block. */
+typedef struct
+{
+	uint8_t first;
+	uint8_t last;
+	uint8_t words;
+	bool extended;
+} check_range_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static bool check_unchanged(void);
+static bool check_low_byte(void);
+static bool check_high_byte(void);
+static bool check_gap_bridged(void);
+static bool check_gap_split(void);
+static bool check_range_end(void);
+static bool check_mid_block(void);
+static bool check_max_burst(void);
+static bool check_bounds(void);
+static bool check_invalid_shadow(void);
+static bool check_invalid_image(void);
+static void check_start(void);
+static void check_stage(uint16_t address, bool extended, uint8_t byte, uint8_t value);
+static uint8_t check_byte(uint16_t address, uint8_t byte);
+static bool check_plan(const iqs7222c_burst_t *expected, uint16_t count);
+static bool check_flush(void);
+static uint16_t check_range_address(const check_range_t *range, uint16_t offset);
+static int check_image_index(uint16_t address, bool extended);
+static void check_image_read(uint16_t image[]);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t sim;
+static iqs7222c_t dev;
+
+/* Register image before the staged bytes, with the staged bytes applied. */
+static uint16_t expected[CHECK_IMAGE_WORDS];
+
+static const check_range_t checkRanges[CHECK_RANGES] = {
+	{0x80, 0x85, 3, true},
+	{0x90, 0x99, 3, true},
+	{0xA0, 0xA9, 6, true},
+	{0xAA, 0xAA, 2, true},
+	{0xB0, 0xB1, 10, true},
+	{0xC0, 0xC2, 3, true},
+	{IQS7222C_MM_CONTROL_SETTINGS, 0xDC, 1, false},
+};
+
+/* The invalid shadow cases come last, they soft reset the model. */
+static const check_case_t checkCases[] = {
+	{"unchanged", check_unchanged},
+	{"low_byte", check_low_byte},
+	{"high_byte", check_high_byte},
+	{"gap_bridged", check_gap_bridged},
+	{"gap_split", check_gap_split},
+	{"range_end", check_range_end},
+	{"mid_block", check_mid_block},
+	{"max_burst", check_max_burst},
+	{"bounds", check_bounds},
+	{"invalid_shadow", check_invalid_shadow},
+	{"invalid_image", check_invalid_image},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(void)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	check_start();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		bool passed = checkCases[i].run();
+
+		printf("%-16s %s\n", checkCases[i].name, passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed, max burst %u bytes\n", count - failed, count,
+	       IQS7222C_MAX_BURST_BYTES);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Bytes equal to a valid shadow stage nothing. */
+static bool check_unchanged(void)
+{
+	check_stage(0x9301, true, 0, check_byte(0x9301, 0));
+	check_stage(0x9301, true, 1, check_byte(0x9301, 1));
+	return check_plan(NULL, 0);
+}
+
+/* A changed low byte is written on its own. */
+static bool check_low_byte(void)
+{
+	const iqs7222c_burst_t bursts[] = {{0x9301, 0, 1, true}};
+
+	check_stage(0x9301, true, 0, check_byte(0x9301, 0) ^ 0x5A);
+	bool planned = check_plan(bursts, 1);
+	return check_flush() && planned;
+}
+
+/* A changed high byte takes its unchanged low byte along, so the burst
+ * starts on the register. */
+static bool check_high_byte(void)
+{
+	const iqs7222c_burst_t bursts[] = {{0x9401, 0, 2, true}};
+
+	check_stage(0x9401, true, 0, check_byte(0x9401, 0));
+	check_stage(0x9401, true, 1, check_byte(0x9401, 1) ^ 0x11);
+	bool planned = check_plan(bursts, 1);
+	return check_flush() && planned;
+}
+
+/* Two unchanged bytes between two registers are rewritten. */
+static bool check_gap_bridged(void)
+{
+	const iqs7222c_burst_t bursts[] = {{0x9500, 0, 6, true}};
+
+	check_stage(0x9500, true, 0, check_byte(0x9500, 0) ^ 0x01);
+	check_stage(0x9500, true, 1, check_byte(0x9500, 1) ^ 0x01);
+	check_stage(0x9502, true, 0, check_byte(0x9502, 0) ^ 0x01);
+	check_stage(0x9502, true, 1, check_byte(0x9502, 1) ^ 0x01);
+	bool planned = check_plan(bursts, 1);
+	return check_flush() && planned;
+}
+
+/* Three unchanged bytes are not. */
+static bool check_gap_split(void)
+{
+	const iqs7222c_burst_t bursts[] = {{0x9600, 0, 1, true}, {0x9602, 0, 1, true}};
+
+	check_stage(0x9600, true, 0, check_byte(0x9600, 0) ^ 0x01);
+	check_stage(0x9602, true, 0, check_byte(0x9602, 0) ^ 0x01);
+	bool planned = check_plan(bursts, 2);
+	return check_flush() && planned;
+}
+
+/* Registers next to each other in the shadow but in different address
+ * ranges take one burst each. */
+static bool check_range_end(void)
+{
+	const iqs7222c_burst_t bursts[] = {
+		{0x8502, 0, 2, true},
+		{0x9000, 0, 2, true},
+		{0xA905, 0, 2, true},
+		{0xAA00, 0, 2, true},
+	};
+	const uint16_t addresses[] = {0x8502, 0x9000, 0xA905, 0xAA00};
+
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		check_stage(addresses[i], true, 0, check_byte(addresses[i], 0) ^ 0x02);
+		check_stage(addresses[i], true, 1, check_byte(addresses[i], 1) ^ 0x02);
+	}
+	bool planned = check_plan(bursts, 4);
+	return check_flush() && planned;
+}
+
+/* A burst runs on across blocks of one range and ends with the last changed
+ * byte, in the middle of a block. */
+static bool check_mid_block(void)
+{
+	const iqs7222c_burst_t bursts[] = {{0xA003, 0, 11, true}};
+	const uint16_t addresses[] = {0xA003, 0xA004, 0xA005, 0xA100, 0xA101, 0xA102};
+
+	for (uint8_t i = 0; i < 6; i++)
+	{
+		check_stage(addresses[i], true, 0, check_byte(addresses[i], 0) ^ 0x04);
+		if (i < 5)
+		{
+			check_stage(addresses[i], true, 1, check_byte(addresses[i], 1) ^ 0x04);
+		}
+	}
+	bool planned = check_plan(bursts, 1);
+	return check_flush() && planned;
+}
+
+/* A whole range is split at IQS7222C_MAX_BURST_BYTES. */
+static bool check_max_burst(void)
+{
+	const check_range_t *range = &checkRanges[2];
+	iqs7222c_burst_t bursts[CHECK_MAX_BURSTS];
+	uint16_t length = (uint16_t)((range->last - range->first + 1) * range->words * 2);
+	uint16_t count = 0;
+
+	for (uint16_t offset = 0; offset < length; offset++)
+	{
+		uint16_t address = check_range_address(range, offset);
+		check_stage(address, true, offset & 1, check_byte(address, offset & 1) ^ 0x08);
+	}
+	for (uint16_t offset = 0; offset < length; offset += IQS7222C_MAX_BURST_BYTES)
+	{
+		uint16_t left = (uint16_t)(length - offset);
+		bursts[count].address = check_range_address(range, offset);
+		bursts[count].length = (uint8_t)((left < IQS7222C_MAX_BURST_BYTES) ? left : IQS7222C_MAX_BURST_BYTES);
+		bursts[count].extended = true;
+		count++;
+	}
+	bool planned = check_plan(bursts, count);
+	return check_flush() && planned;
+}
+
+/* Ranges past the writable registers are refused and stage nothing. */
+static bool check_bounds(void)
+{
+	const uint8_t bytes[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+	bool passed = true;
+
+	passed &= iqs7222c_setConfig(&dev, 0xC202, true, bytes, 4) == I2C_TOUCH_ERROR_INVALID_PARAM;
+	passed &= iqs7222c_setConfig(&dev, 0x8600, true, bytes, 2) == I2C_TOUCH_ERROR_INVALID_PARAM;
+	passed &= iqs7222c_setConfig(&dev, 0xDC, false, bytes, 4) == I2C_TOUCH_ERROR_INVALID_PARAM;
+	if (!passed)
+	{
+		printf("  setConfig accepted a range past the writable registers\n");
+	}
+	return passed && check_plan(NULL, 0);
+}
+
+/* After a soft reset every staged byte is written, equal or not, and gaps
+ * are never bridged since their contents are unknown. */
+static bool check_invalid_shadow(void)
+{
+	const iqs7222c_burst_t bursts[] = {
+		{0x9301, 0, 1, true},
+		{0x9302, 0, 1, true},
+		{0x9400, 0, 2, true},
+	};
+
+	iqs7222c_SW_Reset(&dev, STOP);
+	i2c_touch_host_advance(&host, CHECK_STEP_US);
+	check_image_read(expected);
+
+	check_stage(0x9301, true, 0, check_byte(0x9301, 0));
+	check_stage(0x9302, true, 0, check_byte(0x9302, 0));
+	check_stage(0x9400, true, 0, check_byte(0x9400, 0));
+	check_stage(0x9400, true, 1, check_byte(0x9400, 1) ^ 0x20);
+	bool planned = check_plan(bursts, 3);
+	return check_flush() && planned;
+}
+
+/* The whole image, restaged from the model, takes one burst per range, split
+ * at IQS7222C_MAX_BURST_BYTES. */
+static bool check_invalid_image(void)
+{
+	iqs7222c_burst_t bursts[CHECK_MAX_BURSTS];
+	uint16_t count = 0;
+
+	for (uint8_t r = 0; r < CHECK_RANGES; r++)
+	{
+		const check_range_t *range = &checkRanges[r];
+		uint16_t length = (uint16_t)((range->last - range->first + 1) * range->words * 2);
+
+		for (uint16_t offset = 0; offset < length; offset++)
+		{
+			uint16_t address = check_range_address(range, offset);
+			check_stage(address, range->extended, offset & 1, check_byte(address, offset & 1));
+		}
+		for (uint16_t offset = 0; offset < length; offset += IQS7222C_MAX_BURST_BYTES)
+		{
+			uint16_t left = (uint16_t)(length - offset);
+			bursts[count].address = check_range_address(range, offset);
+			bursts[count].length =
+				(uint8_t)((left < IQS7222C_MAX_BURST_BYTES) ? left : IQS7222C_MAX_BURST_BYTES);
+			bursts[count].extended = range->extended;
+			count++;
+		}
+	}
+	bool planned = check_plan(bursts, count);
+	return check_flush() && planned;
+}
+
+/* Model and driver through a cold start, with a valid shadow. */
+static void check_start(void)
+{
+	iqs7222c_sim_config_t config;
+
+	memset(&dev, 0, sizeof(dev));
+	i2c_touch_host_setup(&host, 400000);
+	iqs7222c_sim_default_config(&config);
+	iqs7222c_sim_init(&sim, &config);
+	i2c_touch_host_attach(&host, config.address, &iqs7222c_sim_device, &sim);
+
+	if (!iqs7222c_begin(&dev, config.address, config.rdy_pin, &host))
+	{
+		fprintf(stderr, "begin failed\n");
+		exit(1);
+	}
+	while (!iqs7222c_init(&dev))
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+	check_image_read(expected);
+}
+
+/* Stage one byte of a register, low byte 0, and apply it to the expected
+ * image. */
+static void check_stage(uint16_t address, bool extended, uint8_t byte, uint8_t value)
+{
+	uint16_t *word = &expected[check_image_index(address, extended)];
+
+	if (byte == 0)
+	{
+		iqs7222c_setConfig(&dev, address, extended, &value, 1);
+		*word = (uint16_t)((*word & 0xFF00) | value);
+	}
+	else
+	{
+		// A single high byte is staged together with the low byte before it.
+		uint8_t bytes[2] = {(uint8_t)*word, value};
+		iqs7222c_setConfig(&dev, address, extended, bytes, 2);
+		*word = (uint16_t)((*word & 0x00FF) | (value << 8));
+	}
+}
+
+/* Byte of the expected image, low byte 0. */
+static uint8_t check_byte(uint16_t address, uint8_t byte)
+{
+	bool extended = (address >= 0x100);
+	uint16_t word = expected[check_image_index(address, extended)];
+
+	return (uint8_t)(byte ? (word >> 8) : word);
+}
+
+static bool check_plan(const iqs7222c_burst_t *bursts, uint16_t count)
+{
+	iqs7222c_burst_t planned[CHECK_MAX_BURSTS];
+	uint16_t planCount = iqs7222c_planConfig(&dev, planned, CHECK_MAX_BURSTS);
+	bool passed = (planCount == count);
+
+	for (uint16_t i = 0; passed && (i < count); i++)
+	{
+		passed = (planned[i].address == bursts[i].address) && (planned[i].length == bursts[i].length) &&
+		         (planned[i].extended == bursts[i].extended);
+	}
+	if (!passed)
+	{
+		printf("  planned %u bursts:", planCount);
+		for (uint16_t i = 0; (i < planCount) && (i < CHECK_MAX_BURSTS); i++)
+		{
+			printf(" %s%04X+%u", planned[i].extended ? "x" : "", planned[i].address, planned[i].length);
+		}
+		printf("\n  expected %u bursts:", count);
+		for (uint16_t i = 0; i < count; i++)
+		{
+			printf(" %s%04X+%u", bursts[i].extended ? "x" : "", bursts[i].address, bursts[i].length);
+		}
+		printf("\n");
+	}
+	return passed;
+}
+
+/* Write the staged bytes in one window and compare the model with the
+ * expected image. Nothing is staged afterwards, also after a failed plan, so
+ * the next case starts clean. */
+static bool check_flush(void)
+{
+	uint16_t image[CHECK_IMAGE_WORDS];
+	bool passed = true;
+
+	while (!iqs7222c_waitForReady(&dev))
+	{
+		iqs7222c_force_I2C_communication(&dev);
+	}
+	if (iqs7222c_flushConfig(&dev, STOP) != I2C_TOUCH_SUCCESS)
+	{
+		printf("  flushConfig failed\n");
+		passed = false;
+	}
+	if (iqs7222c_planConfig(&dev, NULL, 0) != 0)
+	{
+		printf("  bytes still staged after flushConfig\n");
+		passed = false;
+	}
+
+	check_image_read(image);
+	for (uint16_t r = 0, index = 0; r < CHECK_RANGES; r++)
+	{
+		const check_range_t *range = &checkRanges[r];
+		uint16_t length = (uint16_t)((range->last - range->first + 1) * range->words * 2);
+
+		for (uint16_t offset = 0; offset < length; offset += 2, index++)
+		{
+			// The model clears the command bits of the control settings.
+			uint16_t address = check_range_address(range, offset);
+			if ((address == IQS7222C_MM_CONTROL_SETTINGS) || (image[index] == expected[index]))
+			{
+				continue;
+			}
+			printf("  %04X is %04X, expected %04X\n", address, image[index], expected[index]);
+			passed = false;
+		}
+	}
+	memcpy(expected, image, sizeof(image));
+	return passed;
+}
+
+/* Register address of a byte offset in an address range. */
+static uint16_t check_range_address(const check_range_t *range, uint16_t offset)
+{
+	uint16_t block = (uint16_t)(offset / (range->words * 2));
+	uint16_t word = (uint16_t)((offset % (range->words * 2)) / 2);
+
+	if (!range->extended)
+	{
+		return (uint16_t)(range->first + offset / 2);
+	}
+	return (uint16_t)(((range->first + block) << 8) | word);
+}
+
+/* Word of a register in the image, the order of checkRanges. */
+static int check_image_index(uint16_t address, bool extended)
+{
+	int index = 0;
+
+	for (uint8_t r = 0; r < CHECK_RANGES; r++)
+	{
+		const check_range_t *range = &checkRanges[r];
+		uint8_t high = extended ? (uint8_t)(address >> 8) : (uint8_t)address;
+		uint8_t low = extended ? (uint8_t)address : 0;
+
+		if ((range->extended == extended) && (high >= range->first) && (high <= range->last) &&
+		    (low < range->words))
+		{
+			return index + (high - range->first) * range->words + low;
+		}
+		index += (range->last - range->first + 1) * range->words;
+	}
+	fprintf(stderr, "%04X is not a writable register\n", address);
+	exit(1);
+}
+
+static void check_image_read(uint16_t image[])
+{
+	for (uint16_t r = 0, index = 0; r < CHECK_RANGES; r++)
+	{
+		const check_range_t *range = &checkRanges[r];
+		uint16_t length = (uint16_t)((range->last - range->first + 1) * range->words * 2);
+
+		for (uint16_t offset = 0; offset < length; offset += 2, index++)
+		{
+			image[index] = iqs7222c_sim_read_word(&sim, check_range_address(range, offset));
+		}
+	}
+}
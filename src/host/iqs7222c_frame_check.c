@@ -0,0 +1,218 @@
+/** @file iqs7222c_frame_check.c
+*
+* @brief Host check of the frame double buffer. The driver source is built
+* into this file with FRAME_READ_BARRIER replaced by a hook, so frames can be
+* published while iqs7222c_readFrame is between its two loads of the
+* sequence counter, the way the RDY interrupt would. Each case publishes a
+* different number of frames during the first copy and checks how often the
+* reader went round and which frame it returned. Build from the repository
+* root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Ibsp/iqs7222c/src -Isrc/wrappers -Isrc/host \
+*       src/host/iqs7222c_frame_check.c src/host/iqs7222c_sim.c \
+*       src/wrappers/i2c_touch.c src/wrappers/i2c_touch_host.c \
+*       -o iqs7222c_frame_check
+*
+* without bsp/iqs7222c/src/iqs7222c.c, and run ./iqs7222c_frame_check, which
+* exits with 1 if a case fails.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+static void check_read_barrier(void);
+#define FRAME_READ_BARRIER() check_read_barrier()
+#include "iqs7222c.c"
+
+#include "iqs7222c_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_STEP_US 100
+/* RDY time of frame n, tells the frames apart. */
+#define CHECK_FRAME_TIME_US(n) (1000u * (n) + 7u)
+/* Written to a buffer the decoder is in the middle of. */
+#define CHECK_TORN_FLAGS 0xDEAD
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	bool (*run)(void);
+} check_case_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static bool check_quiet(void);
+static bool check_one_publish(void);
+static bool check_publish_and_start(void);
+static bool check_two_publishes(void);
+static void check_start(void);
+static void check_publish(void);
+static void check_start_writing(void);
+static bool check_read(uint32_t publishes, bool startNext, uint32_t passes, uint32_t frame);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t sim;
+static iqs7222c_t checkDev;
+
+/* Frames the hook publishes at the first barrier of the first copy, and
+ * whether it then leaves the decoder in the middle of the next one. */
+static uint32_t hookPublishes;
+static bool hookStartNext;
+static uint32_t barriers;
+static uint32_t published;
+
+static const check_case_t checkCases[] = {
+	{"quiet", check_quiet},
+	{"one_publish", check_one_publish},
+	{"publish_start", check_publish_and_start},
+	{"two_publishes", check_two_publishes},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(void)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		check_start();
+		bool passed = checkCases[i].run();
+
+		printf("%-16s %s\n", checkCases[i].name, passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed\n", count - failed, count);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Nothing published meanwhile, one pass. */
+static bool check_quiet(void)
+{
+	return check_read(0, false, 1, published);
+}
+
+/* The decoder wrote the other buffer, the copy is still good and is the
+ * frame the reader started with. */
+static bool check_one_publish(void)
+{
+	uint32_t before = published;
+
+	return check_read(1, false, 1, before);
+}
+
+/* A publish and the start of the next one rewrite the buffer being copied:
+ * retry, and return the completed frame, not the half written one. */
+static bool check_publish_and_start(void)
+{
+	uint32_t before = published;
+
+	return check_read(1, true, 2, before + 1);
+}
+
+/* Straddling two publishes also rewrites it: retry and return the newest. */
+static bool check_two_publishes(void)
+{
+	uint32_t before = published;
+
+	return check_read(2, false, 2, before + 2);
+}
+
+/* Bring the driver up against the model and publish a first frame. */
+static void check_start(void)
+{
+	iqs7222c_sim_config_t config;
+
+	memset(&checkDev, 0, sizeof(checkDev));
+	i2c_touch_host_setup(&host, 400000);
+	iqs7222c_sim_default_config(&config);
+	iqs7222c_sim_init(&sim, &config);
+	i2c_touch_host_attach(&host, config.address, &iqs7222c_sim_device, &sim);
+
+	if (!iqs7222c_begin(&checkDev, config.address, config.rdy_pin, &host))
+	{
+		fprintf(stderr, "begin failed\n");
+		exit(1);
+	}
+	while (!iqs7222c_init(&checkDev))
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+
+	hookPublishes = 0;
+	hookStartNext = false;
+	published = checkDev.frame_seq >> 1;
+	check_publish();
+}
+
+/* Publish frame number published + 1, as the decoder does. */
+static void check_publish(void)
+{
+	published++;
+	checkDev.window_time_us = CHECK_FRAME_TIME_US(published);
+	publishFrame(&checkDev);
+}
+
+/* The decoder has bumped the sequence to odd and scribbled over the back
+ * buffer when the reader runs again. */
+static void check_start_writing(void)
+{
+	uint32_t seq = checkDev.frame_seq;
+
+	checkDev.frame_seq = seq + 1u;
+	checkDev.frames[((seq >> 1) + 1u) & 1u].info_flags = CHECK_TORN_FLAGS;
+	checkDev.frames[((seq >> 1) + 1u) & 1u].timestamp_us = 0;
+}
+
+/* One iqs7222c_readFrame with the given interference. It must take passes
+ * rounds and return frame number frame, with that frame's content. */
+static bool check_read(uint32_t publishes, bool startNext, uint32_t passes, uint32_t frame)
+{
+	iqs7222c_frame_t copy;
+
+	hookPublishes = publishes;
+	hookStartNext = startNext;
+	barriers = 0;
+	uint32_t seq = iqs7222c_readFrame(&checkDev, &copy);
+	uint32_t rounds = barriers / 2;
+
+	if ((rounds != passes) || (seq != frame) || (copy.timestamp_us != CHECK_FRAME_TIME_US(frame)) ||
+	    (copy.info_flags == CHECK_TORN_FLAGS))
+	{
+		printf("  %u passes, frame %u at %u us, expected %u passes, frame %u\n", rounds, seq,
+		       copy.timestamp_us, passes, frame);
+		return false;
+	}
+	return true;
+}
+
+/* The first barrier sits between the start load and the copy. */
+static void check_read_barrier(void)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (barriers++ != 0)
+	{
+		return;
+	}
+	for (uint32_t i = 0; i < hookPublishes; i++)
+	{
+		check_publish();
+	}
+	if (hookStartNext)
+	{
+		check_start_writing();
+	}
+}
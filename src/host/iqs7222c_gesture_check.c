@@ -0,0 +1,311 @@
+/** @file iqs7222c_gesture_check.c
+*
+* @brief Host check of the slider gesture recognizer, run through the driver
+* and the register model. Each case starts the model and the driver with the
+* default init, which leaves the part in event mode with the slider events
+* enabled, attaches a recognizer to slider 0 and moves a finger over the
+* slider. The gestures delivered by the driver's slider events and by
+* iqs7222c_gesture_poll are compared with the expected list. Build from the
+* repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_gesture_check.c \
+*       bsp/iqs7222c/src/iqs7222c_gesture.c bsp/iqs7222c/src/iqs7222c.c \
+*       src/host/iqs7222c_sim.c src/wrappers/i2c_touch.c \
+*       src/wrappers/i2c_touch_host.c -o iqs7222c_gesture_check
+*
+* and run ./iqs7222c_gesture_check, which exits with 1 if a case fails.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+#include "iqs7222c_gesture.h"
+#include "iqs7222c_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_STEP_US 100
+#define CHECK_MAX_GESTURES 8
+#define CHECK_RESOLUTION 2000
+#define CHECK_CHANNEL 0
+#define CHECK_TOUCH_DELTA 300
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	bool (*run)(void);
+} check_case_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static bool check_tap(void);
+static bool check_double_tap(void);
+static bool check_hold(void);
+static bool check_swipe(void);
+static bool check_fling(void);
+static bool check_tap_then_swipe(void);
+static bool check_tap_then_far_tap(void);
+static void check_start(void);
+static void check_touch(uint16_t position);
+static void check_lift(void);
+static void check_tap_at(uint16_t position);
+static void check_run(uint32_t ms);
+static bool check_expect(const uint8_t types[], uint32_t count);
+static void check_gesture(iqs7222c_gesture_t *recognizer, const iqs7222c_gesture_event_t *event,
+                          void *p_context);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t sim;
+static iqs7222c_t dev;
+static iqs7222c_gesture_t gesture;
+
+static iqs7222c_gesture_event_t gestures[CHECK_MAX_GESTURES];
+static uint32_t gestureCount;
+
+static const char *const gestureNames[] = {
+	"TAP", "DOUBLE_TAP", "HOLD", "HOLD_RELEASE", "SWIPE", "FLING",
+};
+
+static const check_case_t checkCases[] = {
+	{"tap", check_tap},
+	{"double_tap", check_double_tap},
+	{"hold", check_hold},
+	{"swipe", check_swipe},
+	{"fling", check_fling},
+	{"tap_then_swipe", check_tap_then_swipe},
+	{"tap_then_far_tap", check_tap_then_far_tap},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(void)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		check_start();
+		bool passed = checkCases[i].run();
+
+		printf("%-16s %s\n", checkCases[i].name, passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed\n", count - failed, count);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* A short touch is a TAP once the double tap gap has passed. */
+static bool check_tap(void)
+{
+	static const uint8_t expected[] = {IQS7222C_GESTURE_TAP};
+
+	check_tap_at(500);
+	check_run(400);
+	return check_expect(expected, 1) && (gestures[0].position == 500);
+}
+
+/* A second tap within the gap and near the first, the first is not sent. */
+static bool check_double_tap(void)
+{
+	static const uint8_t expected[] = {IQS7222C_GESTURE_DOUBLE_TAP};
+
+	check_tap_at(500);
+	check_run(100);
+	check_tap_at(510);
+	check_run(400);
+	return check_expect(expected, 1);
+}
+
+/* HOLD comes from the poll while the finger rests, without a window. */
+static bool check_hold(void)
+{
+	static const uint8_t expected[] = {IQS7222C_GESTURE_HOLD, IQS7222C_GESTURE_HOLD_RELEASE};
+
+	check_touch(800);
+	check_run(700);
+	if (!check_expect(expected, 1))
+	{
+		return false;
+	}
+	check_lift();
+	check_run(100);
+	return check_expect(expected, 2);
+}
+
+/* 380 counts in 400 ms, about 950 counts per second, below the fling speed
+ * of 4000. */
+static bool check_swipe(void)
+{
+	static const uint8_t expected[] = {IQS7222C_GESTURE_SWIPE};
+
+	for (uint16_t i = 0; i < 20; i++)
+	{
+		check_touch((uint16_t)(200 + i * 20));
+		check_run(20);
+	}
+	check_lift();
+	check_run(400);
+	return check_expect(expected, 1) && (gestures[0].distance >= 300) &&
+	       (gestures[0].velocity > 0) && (gestures[0].velocity < 4000);
+}
+
+/* 200 counts every 16 ms and lifted while moving. */
+static bool check_fling(void)
+{
+	static const uint8_t expected[] = {IQS7222C_GESTURE_FLING};
+
+	for (uint16_t i = 0; i < 8; i++)
+	{
+		check_touch((uint16_t)(1800 - i * 200));
+		check_run(16);
+	}
+	check_lift();
+	check_run(400);
+	return check_expect(expected, 1) && (gestures[0].distance <= -1000) &&
+	       (gestures[0].velocity <= -4000);
+}
+
+/* A touch after a tap that moves away flushes the pending TAP. */
+static bool check_tap_then_swipe(void)
+{
+	static const uint8_t expected[] = {IQS7222C_GESTURE_TAP, IQS7222C_GESTURE_SWIPE};
+
+	check_tap_at(500);
+	check_run(100);
+	for (uint16_t i = 0; i < 10; i++)
+	{
+		check_touch((uint16_t)(500 + i * 40));
+		check_run(20);
+	}
+	check_lift();
+	check_run(400);
+	return check_expect(expected, 2) && (gestures[0].position == 500);
+}
+
+/* A second tap further than swipe_min away flushes the first TAP at once. */
+static bool check_tap_then_far_tap(void)
+{
+	static const uint8_t expected[] = {IQS7222C_GESTURE_TAP, IQS7222C_GESTURE_TAP};
+
+	check_tap_at(500);
+	check_run(100);
+	check_tap_at(1500);
+	check_run(400);
+	return check_expect(expected, 2) && (gestures[0].position == 500) &&
+	       (gestures[1].position == 1500);
+}
+
+static void check_start(void)
+{
+	iqs7222c_sim_config_t config;
+	iqs7222c_gesture_config_t gestureConfig;
+
+	memset(&dev, 0, sizeof(dev));
+	i2c_touch_host_setup(&host, 400000);
+	iqs7222c_sim_default_config(&config);
+	iqs7222c_sim_init(&sim, &config);
+	i2c_touch_host_attach(&host, config.address, &iqs7222c_sim_device, &sim);
+
+	if (!iqs7222c_begin(&dev, config.address, config.rdy_pin, &host))
+	{
+		fprintf(stderr, "begin failed\n");
+		exit(1);
+	}
+	while (!iqs7222c_init(&dev))
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+
+	iqs7222c_gesture_default_config(&gestureConfig, CHECK_RESOLUTION);
+	iqs7222c_gesture_init(&gesture, &gestureConfig, IQS7222C_SLIDER0, check_gesture, NULL);
+	if (!iqs7222c_gesture_attach(&gesture, &dev))
+	{
+		fprintf(stderr, "attach failed\n");
+		exit(1);
+	}
+	check_run(100);
+	gestureCount = 0;
+}
+
+/* Finger on the slider channel at position. */
+static void check_touch(uint16_t position)
+{
+	iqs7222c_sim_set_delta(&sim, CHECK_CHANNEL, CHECK_TOUCH_DELTA);
+	iqs7222c_sim_set_slider(&sim, IQS7222C_SLIDER0, position);
+}
+
+static void check_lift(void)
+{
+	iqs7222c_sim_set_delta(&sim, CHECK_CHANNEL, 0);
+	iqs7222c_sim_set_slider(&sim, IQS7222C_SLIDER0, IQS7222C_SIM_SLIDER_IDLE);
+}
+
+/* Touch for 60 ms and lift. */
+static void check_tap_at(uint16_t position)
+{
+	check_touch(position);
+	check_run(60);
+	check_lift();
+}
+
+/* Service every window and poll the recognizer when it is due. */
+static void check_run(uint32_t ms)
+{
+	for (uint32_t step = 0; step < ms * 1000u / CHECK_STEP_US; step++)
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+		iqs7222c_run(&dev);
+
+		uint32_t next = iqs7222c_gesture_next_us(&gesture);
+		uint32_t now = i2c_touch_time_us(&dev.bus);
+		if ((next != UINT32_MAX) && ((int32_t)(now - next) >= 0))
+		{
+			iqs7222c_gesture_poll(&gesture, now);
+		}
+	}
+}
+
+/* The gestures so far are exactly types. */
+static bool check_expect(const uint8_t types[], uint32_t count)
+{
+	bool match = (gestureCount == count);
+
+	for (uint32_t i = 0; match && (i < count); i++)
+	{
+		match = (gestures[i].type == types[i]);
+	}
+	if (!match)
+	{
+		printf("  got");
+		for (uint32_t i = 0; i < gestureCount; i++)
+		{
+			printf(" %s", gestureNames[gestures[i].type]);
+		}
+		printf("\n");
+	}
+	return match;
+}
+
+static void check_gesture(iqs7222c_gesture_t *recognizer, const iqs7222c_gesture_event_t *event,
+                          void *p_context)
+{
+	(void)recognizer;
+	(void)p_context;
+	if (gestureCount < CHECK_MAX_GESTURES)
+	{
+		gestures[gestureCount++] = *event;
+	}
+}
@@ -0,0 +1,350 @@
+/** @file iqs7222c_rec_check.c
+*
+* @brief Host round trip check of the recorder. Each case writes a sequence
+* of frames with iqs7222c_rec_add, reads them back with iqs7222c_rec_read and
+* compares every field. The longest encoded frame of each case must fit
+* IQS7222C_REC_MAX_FRAME_BYTES, and the worst case frame, every field changed
+* with the widest encoding, is checked on its own. Build from the repository
+* root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include -Isrc/wrappers \
+*       src/host/iqs7222c_rec_check.c bsp/iqs7222c/src/iqs7222c_rec.c \
+*       bsp/iqs7222c/src/iqs7222c.c src/wrappers/i2c_touch.c \
+*       src/wrappers/i2c_touch_host.c -o iqs7222c_rec_check
+*
+* and run ./iqs7222c_rec_check [seed], which exits with 1 if a case fails.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c_rec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_FRAMES 20000u
+#define CHECK_BUFFER_BYTES (IQS7222C_REC_HEADER_BYTES + CHECK_FRAMES * IQS7222C_REC_MAX_FRAME_BYTES)
+#define CHECK_REPORT_US 10000u
+
+/* Mask, a 5 byte time step, info flags, 3 byte varints for prox, touch and
+ * both sliders, and counts and LTA at 16 bits with their width byte. */
+#define CHECK_WORST_FRAME_BYTES (1u + 5u + 1u + 4u * 3u + 2u * (1u + IQS7222C_CHANNELS * 2u))
+
+#if CHECK_WORST_FRAME_BYTES > IQS7222C_REC_MAX_FRAME_BYTES
+#error "IQS7222C_REC_MAX_FRAME_BYTES does not hold the worst case frame"
+#endif
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	uint32_t (*generate)(iqs7222c_rec_frame_t frames[]);
+	uint32_t longest; // exact longest frame, 0 for any up to IQS7222C_REC_MAX_FRAME_BYTES
+} check_case_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static uint32_t check_random(iqs7222c_rec_frame_t frames[]);
+static uint32_t check_timestamps(iqs7222c_rec_frame_t frames[]);
+static uint32_t check_sliders(iqs7222c_rec_frame_t frames[]);
+static uint32_t check_wide_deltas(iqs7222c_rec_frame_t frames[]);
+static uint32_t check_worst_case(iqs7222c_rec_frame_t frames[]);
+static bool check_round_trip(const iqs7222c_rec_frame_t frames[], uint32_t count, uint32_t *maxBytes);
+static bool check_equal(const iqs7222c_rec_frame_t *a, const iqs7222c_rec_frame_t *b);
+static void check_idle(iqs7222c_rec_frame_t *frame);
+static uint32_t check_rand(void);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static uint32_t randState = 1;
+static iqs7222c_rec_frame_t checkFrames[CHECK_FRAMES];
+static uint8_t buffer[CHECK_BUFFER_BYTES];
+
+static const check_case_t checkCases[] = {
+	{"random", check_random, 0},
+	{"timestamp_jumps", check_timestamps, 0},
+	{"slider_no_touch", check_sliders, 0},
+	{"wide_deltas", check_wide_deltas, 0},
+	{"worst_case", check_worst_case, CHECK_WORST_FRAME_BYTES},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(int argc, char **argv)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	if (argc > 1)
+	{
+		randState = (uint32_t)strtoul(argv[1], NULL, 0);
+		randState = (randState != 0) ? randState : 1;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t maxBytes = 0;
+		uint32_t frameCount = checkCases[i].generate(checkFrames);
+		bool passed = check_round_trip(checkFrames, frameCount, &maxBytes);
+
+		if (passed && (checkCases[i].longest != 0) && (maxBytes != checkCases[i].longest))
+		{
+			printf("  expected %u bytes\n", checkCases[i].longest);
+			passed = false;
+		}
+		printf("%-16s %6u frames, longest %2u bytes %s\n", checkCases[i].name, frameCount, maxBytes,
+		       passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed, worst case frame %u of %u bytes\n", count - failed, count,
+	       CHECK_WORST_FRAME_BYTES, IQS7222C_REC_MAX_FRAME_BYTES);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Every field changes now and then, counts mostly by a few counts. */
+static uint32_t check_random(iqs7222c_rec_frame_t frames[])
+{
+	iqs7222c_rec_frame_t frame;
+
+	check_idle(&frame);
+	for (uint32_t i = 0; i < CHECK_FRAMES; i++)
+	{
+		frame.timestamp_us += (check_rand() % 8 == 0) ? check_rand() : CHECK_REPORT_US + check_rand() % 3;
+		if (check_rand() % 4 == 0)
+		{
+			frame.info_flags = (uint8_t)check_rand();
+		}
+		if (check_rand() % 4 == 0)
+		{
+			frame.prox = (uint16_t)check_rand();
+		}
+		if (check_rand() % 4 == 0)
+		{
+			frame.touch = (uint16_t)check_rand();
+		}
+		for (uint8_t s = 0; s < 2; s++)
+		{
+			if (check_rand() % 4 == 0)
+			{
+				frame.slider[s] = (check_rand() % 3 == 0) ? IQS7222C_SLIDER_NO_TOUCH : (uint16_t)check_rand();
+			}
+		}
+		for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+		{
+			uint32_t kind = check_rand() % 8;
+
+			if (kind == 0)
+			{
+				frame.counts[ch] = (uint16_t)check_rand();
+			}
+			else if (kind < 4)
+			{
+				frame.counts[ch] += (uint16_t)(check_rand() % 9 - 4);
+			}
+			if (check_rand() % 6 == 0)
+			{
+				frame.lta[ch] += (uint16_t)((check_rand() % 2) ? check_rand() : 1u);
+			}
+		}
+		frames[i] = frame;
+	}
+	return CHECK_FRAMES;
+}
+
+/* Steady steps with jumps forward, backward and across the 32 bit wrap. */
+static uint32_t check_timestamps(iqs7222c_rec_frame_t frames[])
+{
+	static const uint32_t steps[] = {
+		CHECK_REPORT_US, CHECK_REPORT_US, 0, 1, CHECK_REPORT_US, 0x7FFFFFFFu, 0x80000000u,
+		0xFFFFFFFFu, CHECK_REPORT_US, 0x80000001u, 0x3FFFFFFFu, 0xC0000000u, CHECK_REPORT_US,
+	};
+	uint32_t count = 0;
+	iqs7222c_rec_frame_t frame;
+
+	check_idle(&frame);
+	frame.timestamp_us = 0xFFFFFF00u;
+	for (uint32_t round = 0; round < 100; round++)
+	{
+		for (uint32_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+		{
+			frame.timestamp_us += steps[i] + ((round & 1) ? check_rand() % 64 : 0);
+			frames[count++] = frame;
+		}
+		frame.timestamp_us += check_rand();
+		frames[count++] = frame;
+	}
+	return count;
+}
+
+/* Touch down and lift at both ends of the coordinate range, both sliders
+ * independently. */
+static uint32_t check_sliders(iqs7222c_rec_frame_t frames[])
+{
+	static const uint16_t positions[] = {
+		IQS7222C_SLIDER_NO_TOUCH, 0, IQS7222C_SLIDER_NO_TOUCH, 0xFFFE, IQS7222C_SLIDER_NO_TOUCH,
+		0x7FFF, 0x8000, IQS7222C_SLIDER_NO_TOUCH, 0x7FFE, 1, IQS7222C_SLIDER_NO_TOUCH,
+		IQS7222C_SLIDER_NO_TOUCH, 0xFFFE, 0,
+	};
+	const uint32_t length = sizeof(positions) / sizeof(positions[0]);
+	uint32_t count = 0;
+	iqs7222c_rec_frame_t frame;
+
+	check_idle(&frame);
+	for (uint32_t i = 0; i < length * length; i++)
+	{
+		frame.timestamp_us += CHECK_REPORT_US;
+		frame.slider[0] = positions[i % length];
+		frame.slider[1] = positions[i / length];
+		frames[count++] = frame;
+	}
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		frame.timestamp_us += CHECK_REPORT_US;
+		frame.slider[i & 1] =
+			(frame.slider[i & 1] == IQS7222C_SLIDER_NO_TOUCH) ? (uint16_t)check_rand() : IQS7222C_SLIDER_NO_TOUCH;
+		frames[count++] = frame;
+	}
+	return count;
+}
+
+/* Counts and LTA deltas of up to 16 bits, so every pack width appears,
+ * including wrapping deltas of -32768 and +32767. */
+static uint32_t check_wide_deltas(iqs7222c_rec_frame_t frames[])
+{
+	static const uint16_t values[] = {0x0000, 0xFFFF, 0x0000, 0x8000, 0x0000, 0x7FFF, 0xFFFF, 0x8000, 0x7FFF};
+	const uint32_t length = sizeof(values) / sizeof(values[0]);
+	uint32_t count = 0;
+	iqs7222c_rec_frame_t frame;
+
+	check_idle(&frame);
+	for (uint32_t i = 0; i < length; i++)
+	{
+		frame.timestamp_us += CHECK_REPORT_US;
+		for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+		{
+			frame.counts[ch] = values[(i + ch) % length];
+			frame.lta[ch] = values[(i + 2u * ch) % length];
+		}
+		frames[count++] = frame;
+	}
+	for (uint8_t width = 0; width <= 16; width++)
+	{
+		for (uint32_t i = 0; i < 50; i++)
+		{
+			uint32_t span = (width == 16) ? 0x10000u : (1u << width);
+
+			frame.timestamp_us += CHECK_REPORT_US;
+			for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+			{
+				frame.counts[ch] += (uint16_t)(check_rand() % span);
+				frame.lta[ch] -= (uint16_t)(check_rand() % span);
+			}
+			frames[count++] = frame;
+		}
+	}
+	return count;
+}
+
+/* One frame with every field changed and encoded at its widest. */
+static uint32_t check_worst_case(iqs7222c_rec_frame_t frames[])
+{
+	iqs7222c_rec_frame_t frame;
+
+	check_idle(&frame);
+	frames[0] = frame;
+	// The step changes by -2^31, the zig-zag value then takes 32 bits.
+	frame.timestamp_us += 0x80000000u;
+	frame.info_flags = 0xFF;
+	frame.prox = 0xFFFF;
+	frame.touch = 0xFFFF;
+	frame.slider[0] = 0x7FFF;
+	frame.slider[1] = 0x7FFF;
+	for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+	{
+		frame.counts[ch] = 0x8000;
+		frame.lta[ch] = 0x8000;
+	}
+	frames[1] = frame;
+	return 2;
+}
+
+/* Record and read back, the reader must end with the last frame. */
+static bool check_round_trip(const iqs7222c_rec_frame_t frames[], uint32_t count, uint32_t *maxBytes)
+{
+	iqs7222c_rec_t rec;
+	iqs7222c_rec_reader_t reader;
+	iqs7222c_rec_frame_t frame;
+	uint32_t read = 0;
+
+	iqs7222c_rec_init(&rec, buffer, sizeof(buffer));
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t length = rec.length;
+
+		if (!iqs7222c_rec_add(&rec, &frames[i]))
+		{
+			printf("  frame %u dropped\n", i);
+			return false;
+		}
+		length = rec.length - length;
+		*maxBytes = (length > *maxBytes) ? length : *maxBytes;
+	}
+	if (*maxBytes > IQS7222C_REC_MAX_FRAME_BYTES)
+	{
+		printf("  a frame took %u bytes\n", *maxBytes);
+		return false;
+	}
+
+	if (!iqs7222c_rec_reader_init(&reader, buffer, rec.length))
+	{
+		printf("  header not accepted\n");
+		return false;
+	}
+	while (iqs7222c_rec_read(&reader, &frame))
+	{
+		if ((read >= count) || !check_equal(&frame, &frames[read]))
+		{
+			printf("  frame %u differs\n", read);
+			return false;
+		}
+		read++;
+	}
+	if ((read != count) || (reader.pos != rec.length))
+	{
+		printf("  read %u of %u frames, %u of %u bytes\n", read, count, reader.pos, rec.length);
+		return false;
+	}
+	return true;
+}
+
+static bool check_equal(const iqs7222c_rec_frame_t *a, const iqs7222c_rec_frame_t *b)
+{
+	return (a->timestamp_us == b->timestamp_us) && (a->info_flags == b->info_flags) && (a->prox == b->prox) &&
+	       (a->touch == b->touch) && (a->slider[0] == b->slider[0]) && (a->slider[1] == b->slider[1]) &&
+	       (memcmp(a->counts, b->counts, sizeof(a->counts)) == 0) &&
+	       (memcmp(a->lta, b->lta, sizeof(a->lta)) == 0);
+}
+
+/* The state recorder and reader start from. */
+static void check_idle(iqs7222c_rec_frame_t *frame)
+{
+	memset(frame, 0, sizeof(*frame));
+	frame->slider[0] = IQS7222C_SLIDER_NO_TOUCH;
+	frame->slider[1] = IQS7222C_SLIDER_NO_TOUCH;
+}
+
+/* xorshift32, the same sequence on every host for a given seed. */
+static uint32_t check_rand(void)
+{
+	randState ^= randState << 13;
+	randState ^= randState >> 17;
+	randState ^= randState << 5;
+	return randState;
+}
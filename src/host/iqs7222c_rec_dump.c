@@ -0,0 +1,96 @@
+/** @file iqs7222c_rec_dump.c
+*
+* @brief Decode an iqs7222c_rec recording into CSV, one line per window. Build
+* from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include -Isrc/wrappers \
+*       src/host/iqs7222c_rec_dump.c bsp/iqs7222c/src/iqs7222c_rec.c \
+*       bsp/iqs7222c/src/iqs7222c.c src/wrappers/i2c_touch.c \
+*       src/wrappers/i2c_touch_host.c -o iqs7222c_rec_dump
+*
+* and run ./iqs7222c_rec_dump trace.bin > trace.csv. A summary goes to
+* stderr.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c_rec.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(int argc, char **argv)
+{
+	iqs7222c_rec_reader_t reader;
+	iqs7222c_rec_frame_t frame;
+	uint32_t frames = 0;
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s recording\n", argv[0]);
+		return 2;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (file == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	rewind(file);
+	uint8_t *buffer = malloc(length > 0 ? (size_t)length : 1u);
+	if ((buffer == NULL) || (fread(buffer, 1, (size_t)length, file) != (size_t)length))
+	{
+		fprintf(stderr, "%s: read failed\n", argv[1]);
+		return 1;
+	}
+	fclose(file);
+
+	if (!iqs7222c_rec_reader_init(&reader, buffer, (uint32_t)length))
+	{
+		fprintf(stderr, "%s: not an iqs7222c_rec recording\n", argv[1]);
+		return 1;
+	}
+
+	printf("timestamp_us,info_flags,prox,touch,slider0,slider1");
+	for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+	{
+		printf(",counts%u", ch);
+	}
+	for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+	{
+		printf(",lta%u", ch);
+	}
+	printf("\n");
+
+	while (iqs7222c_rec_read(&reader, &frame))
+	{
+		printf("%u,0x%02x,0x%03x,0x%03x,%u,%u", frame.timestamp_us, frame.info_flags, frame.prox,
+		       frame.touch, frame.slider[0], frame.slider[1]);
+		for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+		{
+			printf(",%u", frame.counts[ch]);
+		}
+		for (uint8_t ch = 0; ch < IQS7222C_CHANNELS; ch++)
+		{
+			printf(",%u", frame.lta[ch]);
+		}
+		printf("\n");
+		frames++;
+	}
+
+	fprintf(stderr, "%u frames, %ld bytes", frames, length);
+	if (reader.pos != reader.length)
+	{
+		fprintf(stderr, ", stopped at byte %u", reader.pos);
+	}
+	fprintf(stderr, "\n");
+	free(buffer);
+	return 0;
+}
@@ -0,0 +1,148 @@
+/** @file iqs7222c_replay.c
+*
+* @brief Run the driver against an i2c_touch_trace recording, one CSV line per
+* decoded window. Build from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_replay.c \
+*       src/host/i2c_touch_replay.c bsp/iqs7222c/src/iqs7222c.c \
+*       src/wrappers/i2c_touch.c src/wrappers/i2c_touch_host.c -o iqs7222c_replay
+*
+* and run ./iqs7222c_replay trace.bin > frames.csv. The driver goes through
+* iqs7222c_begin, iqs7222c_init and iqs7222c_run, windows that were read
+* asynchronously on the target are read by iqs7222c_run here. A summary with
+* the transfers that differ from the trace and the replay speed goes to
+* stderr, the exit code is 1 if any differ.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+#include "i2c_touch_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+/* Longest clock step between driver calls, the init timers must not be
+ * skipped. */
+#define REPLAY_MAX_STEP_US 500u
+
+//----------------------------- DATA TYPES ------------------------------------
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static void replay_step(i2c_touch_host_t *host, const i2c_touch_replay_t *replay);
+static uint64_t replay_now_ns(void);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+static i2c_touch_host_t host;
+static i2c_touch_replay_t replay;
+static iqs7222c_t dev;
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(int argc, char **argv)
+{
+	iqs7222c_frame_t frame;
+	uint32_t frames = 0;
+	uint32_t lastSeq = 0;
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s trace\n", argv[0]);
+		return 2;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (file == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	rewind(file);
+	uint8_t *buffer = malloc(length > 0 ? (size_t)length : 1u);
+	if ((buffer == NULL) || (fread(buffer, 1, (size_t)length, file) != (size_t)length))
+	{
+		fprintf(stderr, "%s: read failed\n", argv[1]);
+		return 1;
+	}
+	fclose(file);
+
+	if (!i2c_touch_replay_init(&replay, buffer, (uint32_t)length))
+	{
+		fprintf(stderr, "%s: not an i2c_touch_trace recording\n", argv[1]);
+		return 1;
+	}
+
+	// Bus frequency 0, the recorded spacing already holds the wire time.
+	i2c_touch_host_setup(&host, 0);
+	i2c_touch_host_attach(&host, replay.address, &i2c_touch_replay_device, &replay);
+
+	uint64_t startNs = replay_now_ns();
+	iqs7222c_begin(&dev, replay.address, (uint8_t)replay.pin, &host);
+	while (!iqs7222c_init(&dev) && !i2c_touch_replay_done(&replay))
+	{
+		replay_step(&host, &replay);
+	}
+
+	printf("timestamp_us,info_flags,events,prox,touch,slider0,slider1\n");
+	while (!i2c_touch_replay_done(&replay))
+	{
+		replay_step(&host, &replay);
+		iqs7222c_run(&dev);
+		uint32_t seq = iqs7222c_readFrame(&dev, &frame);
+		if (seq != lastSeq)
+		{
+			lastSeq = seq;
+			frames++;
+			printf("%u,0x%04x,0x%04x,0x%03x,0x%03x,%u,%u\n", frame.timestamp_us, frame.info_flags,
+			       frame.events, frame.prox, frame.touch, frame.slider[0], frame.slider[1]);
+		}
+	}
+	uint64_t wallNs = replay_now_ns() - startNs;
+
+	uint64_t virtualUs = i2c_touch_host_now_ns(&host) / 1000u;
+	fprintf(stderr, "%u frames, %u transfers, %u edges, %u mismatches, %llu ms traced in %.3f ms",
+	        frames, replay.stats.transfers, replay.stats.edges, replay.stats.mismatches,
+	        (unsigned long long)(virtualUs / 1000u), (double)wallNs / 1e6);
+	if (wallNs > 0)
+	{
+		fprintf(stderr, " (%.0fx)", (double)virtualUs * 1000.0 / (double)wallNs);
+	}
+	fprintf(stderr, "\n");
+	free(buffer);
+	return (replay.stats.mismatches == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Jump to the next record, or less if the driver may have a timer due. */
+static void replay_step(i2c_touch_host_t *host, const i2c_touch_replay_t *replay)
+{
+	uint32_t nowUs = (uint32_t)(i2c_touch_host_now_ns(host) / 1000u);
+	uint32_t stepUs = i2c_touch_replay_next_us(replay) - nowUs;
+
+	if (stepUs == 0)
+	{
+		stepUs = 1;
+	}
+	else if (stepUs > REPLAY_MAX_STEP_US)
+	{
+		stepUs = REPLAY_MAX_STEP_US;
+	}
+	i2c_touch_host_advance(host, stepUs);
+}
+
+static uint64_t replay_now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
@@ -0,0 +1,340 @@
+/** @file iqs7222c_sched_check.c
+*
+* @brief Host check of the window scheduler, run with two register models on
+* one host bus. Each case starts both models and drivers with the default
+* init, gives the devices different COMMS_TIMEOUTs and registers them with
+* iqs7222c_sched, device B first. Touches open the windows; the order in
+* which the bus addresses the devices and the per device scheduler counters
+* are compared with the expected ones. Build from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_sched_check.c \
+*       bsp/iqs7222c/src/iqs7222c_sched.c bsp/iqs7222c/src/iqs7222c.c \
+*       src/host/iqs7222c_sim.c src/wrappers/i2c_touch.c \
+*       src/wrappers/i2c_touch_host.c -o iqs7222c_sched_check
+*
+* and run ./iqs7222c_sched_check, which exits with 1 if a case fails.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+#include "iqs7222c_sched.h"
+#include "iqs7222c_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_STEP_US 100
+#define CHECK_EDGE_TIMEOUT_MS 100
+#define CHECK_MAX_ORDER 8
+#define CHECK_CHANNEL 0
+#define CHECK_TOUCH_DELTA 300
+
+/* A has the short window, B the long one. */
+#define CHECK_A_ADDRESS 0x44
+#define CHECK_A_PIN 0
+#define CHECK_A_TIMEOUT_MS 10
+#define CHECK_B_ADDRESS 0x45
+#define CHECK_B_PIN 1
+#define CHECK_B_TIMEOUT_MS 30
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	bool (*run)(void);
+} check_case_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static bool check_timeouts(void);
+static bool check_edf_order(void);
+static bool check_missed(void);
+static bool check_command_retry(void);
+static void check_start(void);
+static void check_device_start(iqs7222c_sim_t *model, iqs7222c_t *device, uint8_t address,
+                               uint32_t pin, uint16_t timeoutMs);
+static bool check_edge(iqs7222c_sim_t *model, iqs7222c_t *device, int16_t delta);
+static void check_advance(uint32_t us);
+static bool check_order(const uint8_t addresses[], uint32_t count);
+static bool check_stats(const iqs7222c_t *device, uint32_t serviced, uint32_t missed,
+                        uint32_t commands);
+static int check_tx(void *device, uint8_t address, uint8_t const *data, uint32_t len, bool stop);
+static int check_rx(void *device, uint8_t address, uint8_t *data, uint32_t len);
+static bool check_pin_is_set(void *device, uint32_t pin);
+static void check_model_advance(void *device, uint32_t now_us);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t simA;
+static iqs7222c_sim_t simB;
+static iqs7222c_t devA;
+static iqs7222c_t devB;
+static iqs7222c_sched_t sched;
+
+/* Addresses in the order the bus started talking to them, repeats merged. */
+static uint8_t order[CHECK_MAX_ORDER];
+static uint32_t orderCount;
+static bool failNextTx;
+
+/* The register model with the bus traffic logged and a failure injected on
+ * request. */
+static const i2c_touch_host_device_t checkDevice = {
+	.tx = check_tx,
+	.rx = check_rx,
+	.pin_is_set = check_pin_is_set,
+	.advance = check_model_advance,
+};
+
+static const check_case_t checkCases[] = {
+	{"timeouts", check_timeouts},
+	{"edf_order", check_edf_order},
+	{"missed", check_missed},
+	{"command_retry", check_command_retry},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(void)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		check_start();
+		bool passed = checkCases[i].run();
+
+		printf("%-16s %s\n", checkCases[i].name, passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed\n", count - failed, count);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Each device reports its own window length from the written setup. */
+static bool check_timeouts(void)
+{
+	return (iqs7222c_getCommsTimeoutUs(&devA) == CHECK_A_TIMEOUT_MS * 1000u) &&
+	       (iqs7222c_getCommsTimeoutUs(&devB) == CHECK_B_TIMEOUT_MS * 1000u);
+}
+
+/* B's window opens first, but A's shorter one closes first: A is read first
+ * although B is registered first. */
+static bool check_edf_order(void)
+{
+	static const uint8_t expected[] = {CHECK_A_ADDRESS, CHECK_B_ADDRESS};
+
+	if (!check_edge(&simB, &devB, CHECK_TOUCH_DELTA) ||
+	    !check_edge(&simA, &devA, CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	uint32_t gapUs = devA.rdy_time_us - devB.rdy_time_us;
+	if (gapUs >= (CHECK_B_TIMEOUT_MS - CHECK_A_TIMEOUT_MS) * 1000u)
+	{
+		printf("  edges %u us apart, deadlines not crossed\n", gapUs);
+		return false;
+	}
+
+	orderCount = 0;
+	return (iqs7222c_sched_run(&sched) == 2) && check_order(expected, 2) &&
+	       check_stats(&devA, 1, 0, 0) && check_stats(&devB, 1, 0, 0);
+}
+
+/* A's window times out before the run: it is counted as missed and not read,
+ * B's longer window is still read. */
+static bool check_missed(void)
+{
+	static const uint8_t expected[] = {CHECK_B_ADDRESS};
+
+	if (!check_edge(&simA, &devA, CHECK_TOUCH_DELTA) ||
+	    !check_edge(&simB, &devB, CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	uint32_t waitUs = CHECK_A_TIMEOUT_MS * 1000u - (devB.rdy_time_us - devA.rdy_time_us);
+	if (waitUs > CHECK_A_TIMEOUT_MS * 1000u)
+	{
+		waitUs = 0;
+	}
+	check_advance(waitUs + CHECK_STEP_US);
+
+	orderCount = 0;
+	return (iqs7222c_sched_run(&sched) == 1) && check_order(expected, 1) && !devA.device_rdy &&
+	       check_stats(&devA, 0, 1, 0) && check_stats(&devB, 1, 0, 0);
+}
+
+/* A failed control write stays queued and goes out in the next window. */
+static bool check_command_retry(void)
+{
+	iqs7222c_sched_request(&sched, &devA, TP_RESEED_BIT);
+
+	if (!check_edge(&simA, &devA, CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	failNextTx = true;
+	iqs7222c_sched_run(&sched);
+	if (!check_stats(&devA, 1, 0, 0) || (sched.slots[1].control_bits != TP_RESEED_BIT))
+	{
+		return false;
+	}
+
+	if (!check_edge(&simA, &devA, 0))
+	{
+		return false;
+	}
+	iqs7222c_sched_run(&sched);
+	return check_stats(&devA, 2, 0, 1) && (sched.slots[1].control_bits == 0);
+}
+
+static void check_start(void)
+{
+	i2c_touch_host_setup(&host, 400000);
+	check_device_start(&simA, &devA, CHECK_A_ADDRESS, CHECK_A_PIN, CHECK_A_TIMEOUT_MS);
+	check_device_start(&simB, &devB, CHECK_B_ADDRESS, CHECK_B_PIN, CHECK_B_TIMEOUT_MS);
+
+	// Let the windows of the setup writes close before the scheduler starts.
+	for (uint32_t step = 0; step < CHECK_EDGE_TIMEOUT_MS * 1000u / CHECK_STEP_US; step++)
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+		iqs7222c_run(&devA);
+		iqs7222c_run(&devB);
+	}
+
+	iqs7222c_sched_init(&sched);
+	iqs7222c_sched_add(&sched, &devB);
+	iqs7222c_sched_add(&sched, &devA);
+	failNextTx = false;
+	orderCount = 0;
+}
+
+static void check_device_start(iqs7222c_sim_t *model, iqs7222c_t *device, uint8_t address,
+                               uint32_t pin, uint16_t timeoutMs)
+{
+	iqs7222c_sim_config_t config;
+	uint8_t timeout[2] = {timeoutMs & 0xFF, timeoutMs >> 8};
+
+	memset(device, 0, sizeof(*device));
+	iqs7222c_sim_default_config(&config);
+	config.address = address;
+	config.rdy_pin = pin;
+	iqs7222c_sim_init(model, &config);
+	i2c_touch_host_attach(&host, address, &checkDevice, model);
+
+	if (!iqs7222c_begin(device, address, pin, &host))
+	{
+		fprintf(stderr, "begin failed\n");
+		exit(1);
+	}
+	while (!iqs7222c_init(device))
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+
+	iqs7222c_setConfig(device, IQS7222C_MM_COMMS_TIMEOUT, false, timeout, sizeof(timeout));
+	if (iqs7222c_flushConfig(device, STOP) != I2C_TOUCH_SUCCESS)
+	{
+		fprintf(stderr, "timeout setup failed\n");
+		exit(1);
+	}
+	// One window per touch, a learned burst may ask for a second one.
+	iqs7222c_setReadPlan(device, IQS7222C_READ_FIXED, IQS7222C_READ_SLIDERS);
+}
+
+/* Touch or lift and run, without servicing, until the device's RDY edge. */
+static bool check_edge(iqs7222c_sim_t *model, iqs7222c_t *device, int16_t delta)
+{
+	iqs7222c_sim_set_delta(model, CHECK_CHANNEL, delta);
+	for (uint32_t step = 0; step < CHECK_EDGE_TIMEOUT_MS * 1000u / CHECK_STEP_US; step++)
+	{
+		if (device->device_rdy)
+		{
+			return true;
+		}
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+	printf("  no window from 0x%02X\n", model->config.address);
+	return false;
+}
+
+static void check_advance(uint32_t us)
+{
+	for (uint32_t step = 0; step < us / CHECK_STEP_US; step++)
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+}
+
+/* The devices were addressed exactly in this order. */
+static bool check_order(const uint8_t addresses[], uint32_t count)
+{
+	bool match = (orderCount == count) && (memcmp(order, addresses, count) == 0);
+
+	if (!match)
+	{
+		printf("  order");
+		for (uint32_t i = 0; i < orderCount; i++)
+		{
+			printf(" 0x%02X", order[i]);
+		}
+		printf("\n");
+	}
+	return match;
+}
+
+static bool check_stats(const iqs7222c_t *device, uint32_t serviced, uint32_t missed,
+                        uint32_t commands)
+{
+	const iqs7222c_sched_stats_t *stats = iqs7222c_sched_stats(&sched, device);
+
+	if ((stats->serviced != serviced) || (stats->missed != missed) ||
+	    (stats->commands != commands))
+	{
+		printf("  0x%02X serviced %u missed %u commands %u, expected %u %u %u\n",
+		       device->address, stats->serviced, stats->missed, stats->commands, serviced,
+		       missed, commands);
+		return false;
+	}
+	return true;
+}
+
+static int check_tx(void *device, uint8_t address, uint8_t const *data, uint32_t len, bool stop)
+{
+	if (failNextTx)
+	{
+		failNextTx = false;
+		return I2C_TOUCH_ERROR_DNACK;
+	}
+	if (((orderCount == 0) || (order[orderCount - 1] != address)) &&
+	    (orderCount < CHECK_MAX_ORDER))
+	{
+		order[orderCount++] = address;
+	}
+	return iqs7222c_sim_device.tx(device, address, data, len, stop);
+}
+
+static int check_rx(void *device, uint8_t address, uint8_t *data, uint32_t len)
+{
+	return iqs7222c_sim_device.rx(device, address, data, len);
+}
+
+static bool check_pin_is_set(void *device, uint32_t pin)
+{
+	return iqs7222c_sim_device.pin_is_set(device, pin);
+}
+
+static void check_model_advance(void *device, uint32_t now_us)
+{
+	iqs7222c_sim_device.advance(device, now_us);
+}
@@ -0,0 +1,695 @@
+/** @file iqs7222c_sim.c
+*
+* @brief Register level model of the IQS7222C for host builds. Answers the
+* same I2C transfers as the real part (8-bit addresses 0x00 - 0xDC and the
+* extended 16-bit setup blocks 0x8000 - 0xC202), drives the RDY line, closes
+* windows on a stop (after every read, and after writes that end with one) or
+* on the comms timeout and runs the report cycle, power
+* mode, SHOW_RESET and ATI timing on the host backend clock.
+*
+* Simplifications: channel counts are LTA + the injected delta, prox is
+* reported when the delta exceeds the prox threshold in counts and touch when
+* it exceeds LTA * touch threshold / 256. A slider event is raised whenever a
+* slider output changes and opens a window in event mode if its bit is set in
+* IQS7222C_MM_EVENT_ENABLE. Transfers made while RDY is high are
+* answered as if the part clock stretched into a window and are counted in
+* out_of_window.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c_sim.h"
+#include "iqs7222c.h"
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+/* Info flags word. */
+#define SIM_INFO_ATI_ACTIVE 0x0001
+#define SIM_INFO_POWER_MODE_SHIFT 4
+#define SIM_INFO_POWER_MODE_MASK 0x0030
+
+/* Events word. */
+#define SIM_EVENT_PROX 0x0001
+#define SIM_EVENT_TOUCH 0x0002
+#define SIM_EVENT_SLIDER0 0x0100
+#define SIM_EVENT_SLIDER1 0x0200
+#define SIM_EVENT_ATI 0x1000
+#define SIM_EVENT_POWER 0x2000
+
+/* Control settings actions, cleared by the part once executed. */
+#define SIM_CONTROL_ACTIONS (ACK_RESET_BIT | SW_RESET_BIT | TP_REATI_BIT | TP_RESEED_BIT)
+
+/* Report rates used while the rate registers are 0, in ms. */
+#define SIM_DEFAULT_NP_RATE_MS 10
+#define SIM_DEFAULT_LP_RATE_MS 40
+#define SIM_DEFAULT_ULP_RATE_MS 160
+
+#define SIM_CHANNEL_COUNTS_MAX 0xFFFF
+#define SIM_END_OF_MAP 0xFFFF
+
+//----------------------------- DATA TYPES ------------------------------------
+
+/* Extended setup blocks: address high byte range and words per block. */
+typedef struct
+{
+	uint8_t first;
+	uint8_t last;
+	uint8_t words;
+} sim_ext_block_t;
+
+typedef enum
+{
+	SIM_DEADLINE_NONE = 0,
+	SIM_DEADLINE_BOOT,
+	SIM_DEADLINE_ATI,
+	SIM_DEADLINE_COMMS_TIMEOUT,
+	SIM_DEADLINE_REPORT,
+} sim_deadline_e;
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static int sim_tx(void *device, uint8_t address, uint8_t const *data, uint32_t len, bool stop);
+static int sim_rx(void *device, uint8_t address, uint8_t *data, uint32_t len);
+static bool sim_pin_is_set(void *device, uint32_t pin);
+static void sim_advance(void *device, uint32_t now_us);
+static void sim_pick(sim_deadline_e *what, uint32_t *next, bool active, uint32_t deadline,
+                     sim_deadline_e candidate, uint32_t now_us);
+
+static void sim_reset_registers(iqs7222c_sim_t *sim, uint32_t now_us);
+static void sim_start_ati(iqs7222c_sim_t *sim, uint32_t now_us);
+static void sim_report_cycle(iqs7222c_sim_t *sim, uint32_t now_us);
+static void sim_open_window(iqs7222c_sim_t *sim, uint32_t now_us);
+static void sim_close_window(iqs7222c_sim_t *sim, bool serviced);
+static void sim_stop(iqs7222c_sim_t *sim);
+static void sim_write_word(iqs7222c_sim_t *sim, uint16_t address, bool ext, uint16_t value, uint16_t mask);
+static uint16_t *sim_word(iqs7222c_sim_t *sim, uint16_t address, bool ext);
+static int sim_ext_index(uint16_t address);
+static uint16_t sim_ext_next(uint16_t address);
+static uint32_t sim_report_interval_us(const iqs7222c_sim_t *sim);
+static uint32_t sim_comms_timeout_us(const iqs7222c_sim_t *sim);
+static bool sim_due(uint32_t deadline, uint32_t now);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static const sim_ext_block_t ext_blocks[] = {
+	{0x80, 0x85, 3},  // cycle setup 0 - 4, global cycle setup
+	{0x90, 0x99, 3},  // button setup 0 - 9
+	{0xA0, 0xA9, 6},  // channel setup 0 - 9
+	{0xAA, 0xAA, 2},  // filter betas
+	{0xB0, 0xB1, 10}, // slider/wheel setup 0 - 1
+	{0xC0, 0xC2, 3},  // GPIO settings 0 - 2
+};
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+const i2c_touch_host_device_t iqs7222c_sim_device = {
+	.tx = sim_tx,
+	.rx = sim_rx,
+	.pin_is_set = sim_pin_is_set,
+	.advance = sim_advance,
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+void iqs7222c_sim_default_config(iqs7222c_sim_config_t *config)
+{
+	config->address = 0x44;
+	config->rdy_pin = 0;
+	config->boot_us = 15000;
+	config->ati_us = 40000;
+	config->comms_timeout_ms = 25;
+	config->lta = 1000;
+	config->product_major = 2;
+	config->product_minor = 6;
+}
+
+void iqs7222c_sim_init(iqs7222c_sim_t *sim, const iqs7222c_sim_config_t *config)
+{
+	memset(sim, 0, sizeof(*sim));
+	sim->config = *config;
+	for (uint8_t i = 0; i < IQS7222C_SIM_SLIDERS; i++)
+	{
+		sim->slider[i] = IQS7222C_SIM_SLIDER_IDLE;
+	}
+	sim_reset_registers(sim, 0);
+}
+
+void iqs7222c_sim_power_on(iqs7222c_sim_t *sim, uint32_t now_us)
+{
+	sim->now_us = now_us;
+	sim_reset_registers(sim, now_us);
+}
+
+void iqs7222c_sim_set_delta(iqs7222c_sim_t *sim, uint8_t channel, int16_t delta)
+{
+	if ((channel < IQS7222C_SIM_CHANNELS) && (sim->delta[channel] != delta))
+	{
+		sim->delta[channel] = delta;
+		sim->stimulus_us = sim->now_us;
+		sim->stimulus_pending = true;
+	}
+}
+
+void iqs7222c_sim_set_slider(iqs7222c_sim_t *sim, uint8_t slider, uint16_t value)
+{
+	if (slider < IQS7222C_SIM_SLIDERS)
+	{
+		sim->slider[slider] = value;
+	}
+}
+
+uint16_t iqs7222c_sim_read_word(const iqs7222c_sim_t *sim, uint16_t address)
+{
+	if (address < IQS7222C_SIM_REGS)
+	{
+		return sim->regs[address];
+	}
+
+	int index = sim_ext_index(address);
+	return (index < 0) ? 0 : sim->ext[index];
+}
+
+const iqs7222c_sim_stats_t *iqs7222c_sim_stats(const iqs7222c_sim_t *sim)
+{
+	return &sim->stats;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+static int sim_tx(void *device, uint8_t address, uint8_t const *data, uint32_t len, bool stop)
+{
+	iqs7222c_sim_t *sim = device;
+
+	if ((address != sim->config.address) || (len == 0))
+	{
+		sim->stats.nacks++;
+		return I2C_TOUCH_ERROR_ANACK;
+	}
+
+	sim->stats.transactions++;
+	sim->stats.bytes_written += len;
+
+	/* Force communication request opens a window straight away. */
+	if ((len == 2) && (data[0] == 0x00) && (data[1] == 0xFF) && !sim->window_open && !sim->booting)
+	{
+		sim_open_window(sim, sim->now_us);
+		return I2C_TOUCH_SUCCESS;
+	}
+
+	if (!sim->window_open)
+	{
+		sim->stats.out_of_window++;
+	}
+
+	uint32_t offset;
+	if ((data[0] >= 0x80) && (data[0] < 0xD0) && (len >= 2))
+	{
+		sim->pointer = (uint16_t)((data[0] << 8) | data[1]);
+		sim->pointer_ext = true;
+		offset = 2;
+	}
+	else
+	{
+		sim->pointer = data[0];
+		sim->pointer_ext = false;
+		offset = 1;
+	}
+
+	/* Address only writes just set the pointer for the read that follows. */
+	uint16_t pointer = sim->pointer;
+	for (uint32_t i = offset; i < len; i += 2)
+	{
+		if (pointer == SIM_END_OF_MAP)
+		{
+			break;
+		}
+		if (i + 1 < len)
+		{
+			sim_write_word(sim, pointer, sim->pointer_ext, (uint16_t)(data[i] | (data[i + 1] << 8)), 0xFFFF);
+		}
+		else
+		{
+			sim_write_word(sim, pointer, sim->pointer_ext, data[i], 0x00FF);
+		}
+		pointer = sim->pointer_ext ? sim_ext_next(pointer) : (uint16_t)(pointer + 1);
+	}
+
+	if (stop)
+	{
+		sim_stop(sim);
+	}
+	return I2C_TOUCH_SUCCESS;
+}
+
+static int sim_rx(void *device, uint8_t address, uint8_t *data, uint32_t len)
+{
+	iqs7222c_sim_t *sim = device;
+
+	if (address != sim->config.address)
+	{
+		sim->stats.nacks++;
+		return I2C_TOUCH_ERROR_ANACK;
+	}
+
+	sim->stats.transactions++;
+	sim->stats.bytes_read += len;
+	if (!sim->window_open)
+	{
+		sim->stats.out_of_window++;
+	}
+
+	uint16_t pointer = sim->pointer;
+	for (uint32_t i = 0; i < len; i += 2)
+	{
+		uint16_t *word = (pointer == SIM_END_OF_MAP) ? NULL : sim_word(sim, pointer, sim->pointer_ext);
+		uint16_t value = (word != NULL) ? *word : 0;
+		data[i] = (uint8_t)value;
+		if (i + 1 < len)
+		{
+			data[i + 1] = (uint8_t)(value >> 8);
+		}
+		if (pointer != SIM_END_OF_MAP)
+		{
+			pointer = sim->pointer_ext ? sim_ext_next(pointer) : (uint16_t)(pointer + 1);
+		}
+	}
+
+	/* Every read ends with a stop. */
+	sim_stop(sim);
+	return I2C_TOUCH_SUCCESS;
+}
+
+static bool sim_pin_is_set(void *device, uint32_t pin)
+{
+	iqs7222c_sim_t *sim = device;
+	return (pin != sim->config.rdy_pin) || !sim->window_open;
+}
+
+static void sim_advance(void *device, uint32_t now_us)
+{
+	iqs7222c_sim_t *sim = device;
+
+	for (;;)
+	{
+		/* Handle the earliest deadline that is due, ties in the order ATI
+		 * completion, comms timeout, report cycle. */
+		sim_deadline_e what = SIM_DEADLINE_NONE;
+		uint32_t next = now_us;
+
+		if (sim->booting)
+		{
+			sim_pick(&what, &next, true, sim->boot_done_us, SIM_DEADLINE_BOOT, now_us);
+		}
+		else
+		{
+			sim_pick(&what, &next, sim->ati_running, sim->ati_done_us, SIM_DEADLINE_ATI, now_us);
+			sim_pick(&what, &next, sim->window_open, sim->window_opened_us + sim_comms_timeout_us(sim),
+			         SIM_DEADLINE_COMMS_TIMEOUT, now_us);
+			sim_pick(&what, &next, true, sim->next_report_us, SIM_DEADLINE_REPORT, now_us);
+		}
+
+		if (what == SIM_DEADLINE_NONE)
+		{
+			break;
+		}
+
+		sim->now_us = next;
+		switch (what)
+		{
+		case SIM_DEADLINE_BOOT:
+			sim->booting = false;
+			sim->regs[IQS7222C_MM_INFOFLAGS] |= SHOW_RESET_BIT;
+			sim->idle_since_us = next;
+			sim->next_report_us = next;
+			sim_start_ati(sim, next);
+			break;
+
+		case SIM_DEADLINE_ATI:
+			sim->ati_running = false;
+			sim->regs[IQS7222C_MM_INFOFLAGS] &= ~SIM_INFO_ATI_ACTIVE;
+			sim->regs[IQS7222C_MM_EVENTS] |= SIM_EVENT_ATI;
+			break;
+
+		case SIM_DEADLINE_COMMS_TIMEOUT:
+			sim_close_window(sim, false);
+			break;
+
+		default:
+			sim_report_cycle(sim, next);
+			sim->next_report_us = next + sim_report_interval_us(sim);
+			break;
+		}
+	}
+	sim->now_us = now_us;
+}
+
+static void sim_pick(sim_deadline_e *what, uint32_t *next, bool active, uint32_t deadline,
+                     sim_deadline_e candidate, uint32_t now_us)
+{
+	if (!active || !sim_due(deadline, now_us))
+	{
+		return;
+	}
+	if ((*what == SIM_DEADLINE_NONE) || ((int32_t)(deadline - *next) < 0))
+	{
+		*what = candidate;
+		*next = deadline;
+	}
+}
+
+static void sim_reset_registers(iqs7222c_sim_t *sim, uint32_t now_us)
+{
+	memset(sim->regs, 0, sizeof(sim->regs));
+	memset(sim->ext, 0, sizeof(sim->ext));
+
+	sim->regs[IQS7222C_MM_PROD_NUM] = IQS7222C_PRODUCT_NUM;
+	sim->regs[IQS7222C_MM_MAJOR_VERSION_NUM] = sim->config.product_major;
+	sim->regs[IQS7222C_MM_MINOR_VERSION_NUM] = sim->config.product_minor;
+	for (uint8_t ch = 0; ch < IQS7222C_SIM_CHANNELS; ch++)
+	{
+		sim->regs[IQS7222C_MM_CHANNEL_0_COUNTS + ch] = sim->config.lta;
+		sim->regs[IQS7222C_MM_CHANNEL_0_LTA + ch] = sim->config.lta;
+	}
+	sim->regs[IQS7222C_MM_SLIDER_0_OUTPUT] = IQS7222C_SIM_SLIDER_IDLE;
+	sim->regs[IQS7222C_MM_SLIDER_1_OUTPUT] = IQS7222C_SIM_SLIDER_IDLE;
+
+	sim->window_open = false;
+	sim->reset_after_close = false;
+	sim->ati_running = false;
+	sim->booting = true;
+	sim->boot_done_us = now_us + sim->config.boot_us;
+}
+
+static void sim_start_ati(iqs7222c_sim_t *sim, uint32_t now_us)
+{
+	sim->ati_running = true;
+	sim->ati_done_us = now_us + sim->config.ati_us;
+	sim->regs[IQS7222C_MM_INFOFLAGS] |= SIM_INFO_ATI_ACTIVE;
+	sim->stats.ati_runs++;
+}
+
+static void sim_report_cycle(iqs7222c_sim_t *sim, uint32_t now_us)
+{
+	uint16_t prox = 0;
+	uint16_t touch = 0;
+
+	for (uint8_t ch = 0; ch < IQS7222C_SIM_CHANNELS; ch++)
+	{
+		uint16_t lta = sim->regs[IQS7222C_MM_CHANNEL_0_LTA + ch];
+		int32_t counts = (int32_t)lta + sim->delta[ch];
+		if (counts < 0)
+		{
+			counts = 0;
+		}
+		else if (counts > SIM_CHANNEL_COUNTS_MAX)
+		{
+			counts = SIM_CHANNEL_COUNTS_MAX;
+		}
+		sim->regs[IQS7222C_MM_CHANNEL_0_COUNTS + ch] = (uint16_t)counts;
+
+		int sidx = sim_ext_index((uint16_t)(IQS7222C_MM_BUTTON_SETUP_0 + (ch << 8)));
+		uint16_t proxThreshold = sim->ext[sidx] & 0xFF;
+		uint32_t touchThreshold = ((uint32_t)lta * (sim->ext[sidx + 1] & 0xFF)) >> 8;
+
+		if (sim->delta[ch] > (int32_t)proxThreshold)
+		{
+			prox |= (uint16_t)(1u << ch);
+		}
+		if (sim->delta[ch] > (int32_t)touchThreshold)
+		{
+			touch |= (uint16_t)(1u << ch);
+		}
+	}
+
+	uint16_t events = 0;
+	if (prox != sim->regs[IQS7222C_MM_PROX_EVENT_STATES])
+	{
+		events |= SIM_EVENT_PROX;
+	}
+	if (touch != sim->regs[IQS7222C_MM_TOUCH_EVENT_STATES])
+	{
+		events |= SIM_EVENT_TOUCH;
+	}
+	/* A slider event for every change of its output, movement, touch down
+	 * and lift alike. */
+	if (sim->slider[0] != sim->regs[IQS7222C_MM_SLIDER_0_OUTPUT])
+	{
+		events |= SIM_EVENT_SLIDER0;
+	}
+	if (sim->slider[1] != sim->regs[IQS7222C_MM_SLIDER_1_OUTPUT])
+	{
+		events |= SIM_EVENT_SLIDER1;
+	}
+	sim->regs[IQS7222C_MM_PROX_EVENT_STATES] = prox;
+	sim->regs[IQS7222C_MM_TOUCH_EVENT_STATES] = touch;
+	sim->regs[IQS7222C_MM_SLIDER_0_OUTPUT] = sim->slider[0];
+	sim->regs[IQS7222C_MM_SLIDER_1_OUTPUT] = sim->slider[1];
+
+	/* Power mode: any activity returns to normal power, otherwise step down
+	 * once the mode timeout (ms) expires. A timeout of 0 keeps the mode. */
+	uint16_t info = sim->regs[IQS7222C_MM_INFOFLAGS];
+	uint8_t mode = (info & SIM_INFO_POWER_MODE_MASK) >> SIM_INFO_POWER_MODE_SHIFT;
+	uint8_t newMode = mode;
+	if ((prox | touch) != 0)
+	{
+		sim->idle_since_us = now_us;
+		newMode = NORMAL_POWER_BIT;
+	}
+	else
+	{
+		uint32_t idle = now_us - sim->idle_since_us;
+		uint32_t npTimeout = (uint32_t)sim->regs[IQS7222C_MM_NP_TIMEOUT] * 1000u;
+		uint32_t lpTimeout = (uint32_t)sim->regs[IQS7222C_MM_LP_TIMEOUT] * 1000u;
+		if ((mode == NORMAL_POWER_BIT) && (npTimeout != 0) && (idle >= npTimeout))
+		{
+			newMode = LOW_POWER_BIT;
+		}
+		else if ((mode == LOW_POWER_BIT) && (lpTimeout != 0) && (idle >= npTimeout + lpTimeout))
+		{
+			newMode = ULP_BIT;
+		}
+	}
+	if (newMode != mode)
+	{
+		events |= SIM_EVENT_POWER;
+		info = (uint16_t)((info & ~SIM_INFO_POWER_MODE_MASK) | (newMode << SIM_INFO_POWER_MODE_SHIFT));
+		sim->regs[IQS7222C_MM_INFOFLAGS] = info;
+	}
+	sim->regs[IQS7222C_MM_EVENTS] |= events;
+
+	if (sim->window_open)
+	{
+		return;
+	}
+
+	/* Stream mode opens a window every cycle, event mode only for enabled
+	 * events, stream in touch additionally while any channel is touched. */
+	uint16_t control = sim->regs[IQS7222C_MM_CONTROL_SETTINGS];
+	bool open;
+	if (!(control & EVENT_MODE_BIT))
+	{
+		open = true;
+	}
+	else
+	{
+		open = (sim->regs[IQS7222C_MM_EVENTS] & sim->regs[IQS7222C_MM_EVENT_ENABLE]) != 0;
+		if ((control & STREAM_IN_TOUCH_BIT) && (touch != 0))
+		{
+			open = true;
+		}
+	}
+
+	if (open)
+	{
+		sim_open_window(sim, now_us);
+	}
+}
+
+static void sim_open_window(iqs7222c_sim_t *sim, uint32_t now_us)
+{
+	sim->window_open = true;
+	sim->window_opened_us = now_us;
+	sim->stats.windows_opened++;
+}
+
+static void sim_close_window(iqs7222c_sim_t *sim, bool serviced)
+{
+	uint16_t events = sim->regs[IQS7222C_MM_EVENTS];
+
+	sim->window_open = false;
+	if (serviced)
+	{
+		sim->stats.windows_serviced++;
+		if (sim->stimulus_pending && (events & (SIM_EVENT_PROX | SIM_EVENT_TOUCH)))
+		{
+			uint32_t latency = sim->now_us - sim->stimulus_us;
+			sim->stimulus_pending = false;
+			sim->stats.touch_latency_last_us = latency;
+			sim->stats.touch_latency_sum_us += latency;
+			sim->stats.touch_latency_count++;
+			if (latency > sim->stats.touch_latency_max_us)
+			{
+				sim->stats.touch_latency_max_us = latency;
+			}
+		}
+	}
+	else
+	{
+		sim->stats.windows_timed_out++;
+	}
+
+	/* Events are reported once per window. */
+	sim->regs[IQS7222C_MM_EVENTS] = 0;
+
+	if (sim->reset_after_close)
+	{
+		sim->stats.resets++;
+		sim_reset_registers(sim, sim->now_us);
+	}
+}
+
+/* A stop ends the window, or the one the part stretched the clock into for
+ * a transfer outside a window, where only a pending reset takes effect. */
+static void sim_stop(iqs7222c_sim_t *sim)
+{
+	if (sim->window_open)
+	{
+		sim_close_window(sim, true);
+	}
+	else if (sim->reset_after_close)
+	{
+		sim->stats.resets++;
+		sim_reset_registers(sim, sim->now_us);
+	}
+}
+
+static void sim_write_word(iqs7222c_sim_t *sim, uint16_t address, bool ext, uint16_t value, uint16_t mask)
+{
+	uint16_t *word = sim_word(sim, address, ext);
+
+	/* Only the setup blocks and 0xD0 - 0xDC are writable. */
+	if ((word == NULL) || (!ext && (address < IQS7222C_MM_CONTROL_SETTINGS)))
+	{
+		return;
+	}
+
+	*word = (uint16_t)((*word & ~mask) | (value & mask));
+
+	if (!ext && (address == IQS7222C_MM_CONTROL_SETTINGS))
+	{
+		if (value & ACK_RESET_BIT)
+		{
+			sim->regs[IQS7222C_MM_INFOFLAGS] &= ~SHOW_RESET_BIT;
+		}
+		if (value & SW_RESET_BIT)
+		{
+			sim->reset_after_close = true;
+		}
+		if (value & TP_REATI_BIT)
+		{
+			sim_start_ati(sim, sim->now_us);
+		}
+		if (value & TP_RESEED_BIT)
+		{
+			for (uint8_t ch = 0; ch < IQS7222C_SIM_CHANNELS; ch++)
+			{
+				sim->regs[IQS7222C_MM_CHANNEL_0_LTA + ch] = sim->regs[IQS7222C_MM_CHANNEL_0_COUNTS + ch];
+			}
+		}
+		*word &= (uint16_t)~SIM_CONTROL_ACTIONS;
+	}
+}
+
+static uint16_t *sim_word(iqs7222c_sim_t *sim, uint16_t address, bool ext)
+{
+	if (!ext)
+	{
+		return (address < IQS7222C_SIM_REGS) ? &sim->regs[address] : NULL;
+	}
+
+	int index = sim_ext_index(address);
+	return (index < 0) ? NULL : &sim->ext[index];
+}
+
+static int sim_ext_index(uint16_t address)
+{
+	uint8_t hi = (uint8_t)(address >> 8);
+	uint8_t lo = (uint8_t)address;
+	int base = 0;
+
+	for (size_t i = 0; i < sizeof(ext_blocks) / sizeof(ext_blocks[0]); i++)
+	{
+		const sim_ext_block_t *block = &ext_blocks[i];
+		if ((hi >= block->first) && (hi <= block->last))
+		{
+			return (lo < block->words) ? base + (hi - block->first) * block->words + lo : -1;
+		}
+		base += (block->last - block->first + 1) * block->words;
+	}
+	return -1;
+}
+
+/* Extended addresses auto-increment within a block and then continue at the
+ * start of the next block, e.g. 0x8002 -> 0x8100. */
+static uint16_t sim_ext_next(uint16_t address)
+{
+	uint8_t hi = (uint8_t)(address >> 8);
+	uint8_t lo = (uint8_t)address;
+	size_t count = sizeof(ext_blocks) / sizeof(ext_blocks[0]);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const sim_ext_block_t *block = &ext_blocks[i];
+		if ((hi >= block->first) && (hi <= block->last))
+		{
+			if (lo + 1 < block->words)
+			{
+				return (uint16_t)(address + 1);
+			}
+			if (hi < block->last)
+			{
+				return (uint16_t)((hi + 1) << 8);
+			}
+			return (i + 1 < count) ? (uint16_t)(ext_blocks[i + 1].first << 8) : SIM_END_OF_MAP;
+		}
+	}
+	return SIM_END_OF_MAP;
+}
+
+static uint32_t sim_report_interval_us(const iqs7222c_sim_t *sim)
+{
+	uint8_t mode = (sim->regs[IQS7222C_MM_INFOFLAGS] & SIM_INFO_POWER_MODE_MASK) >> SIM_INFO_POWER_MODE_SHIFT;
+	uint16_t rate;
+
+	if (mode == LOW_POWER_BIT)
+	{
+		rate = sim->regs[IQS7222C_MM_LP_REPORT_RATE];
+		rate = rate ? rate : SIM_DEFAULT_LP_RATE_MS;
+	}
+	else if (mode == ULP_BIT)
+	{
+		rate = sim->regs[IQS7222C_MM_ULP_REPORT_RATE];
+		rate = rate ? rate : SIM_DEFAULT_ULP_RATE_MS;
+	}
+	else
+	{
+		rate = sim->regs[IQS7222C_MM_NP_REPORT_RATE];
+		rate = rate ? rate : SIM_DEFAULT_NP_RATE_MS;
+	}
+	return (uint32_t)rate * 1000u;
+}
+
+static uint32_t sim_comms_timeout_us(const iqs7222c_sim_t *sim)
+{
+	uint16_t timeout = sim->regs[IQS7222C_MM_COMMS_TIMEOUT];
+	return (uint32_t)(timeout ? timeout : sim->config.comms_timeout_ms) * 1000u;
+}
+
+/* Wrap safe deadline <= now. */
+static bool sim_due(uint32_t deadline, uint32_t now)
+{
+	return (int32_t)(deadline - now) <= 0;
+}
+
+//--------------------------- INTERRUPT HANDLERS ------------------------------
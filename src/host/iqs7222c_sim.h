@@ -0,0 +1,113 @@
+/** @file iqs7222c_sim.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef IQS7222C_SIM_H
+#define IQS7222C_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "i2c_touch_host.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+#define IQS7222C_SIM_CHANNELS 10
+#define IQS7222C_SIM_SLIDERS 2
+/* 8-bit address space 0x00 - 0xDC, one 16-bit word per address. */
+#define IQS7222C_SIM_REGS 0xDD
+/* Extended (16-bit address) setup blocks, flattened. */
+#define IQS7222C_SIM_EXT_WORDS 144
+
+/* Slider output while no finger is on the slider. */
+#define IQS7222C_SIM_SLIDER_IDLE 0xFFFF
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	uint8_t address;                  // 7-bit I2C address the model answers on
+	uint32_t rdy_pin;                 // pin number reported through pin_is_set
+	uint32_t boot_us;                 // power-on or soft reset to first window
+	uint32_t ati_us;                  // duration of one ATI run
+	uint16_t comms_timeout_ms;        // used while IQS7222C_MM_COMMS_TIMEOUT is 0
+	uint16_t lta;                     // untouched channel counts
+	uint8_t product_major;
+	uint8_t product_minor;
+} iqs7222c_sim_config_t;
+
+typedef struct
+{
+	uint32_t transactions;            // tx and rx calls answered
+	uint32_t bytes_written;
+	uint32_t bytes_read;
+	uint32_t nacks;                   // wrong address
+	uint32_t out_of_window;           // transfers started while RDY was high
+	uint32_t windows_opened;
+	uint32_t windows_serviced;        // closed by the master with a stop
+	uint32_t windows_timed_out;       // closed by the comms timeout
+	uint32_t resets;
+	uint32_t ati_runs;
+	uint32_t touch_latency_last_us;   // stimulus to window close that reported it
+	uint32_t touch_latency_max_us;
+	uint64_t touch_latency_sum_us;
+	uint32_t touch_latency_count;
+} iqs7222c_sim_stats_t;
+
+typedef struct
+{
+	iqs7222c_sim_config_t config;
+	iqs7222c_sim_stats_t stats;
+
+	uint16_t regs[IQS7222C_SIM_REGS];
+	uint16_t ext[IQS7222C_SIM_EXT_WORDS];
+
+	/* Stimulus. */
+	int16_t delta[IQS7222C_SIM_CHANNELS];
+	uint16_t slider[IQS7222C_SIM_SLIDERS];
+	uint32_t stimulus_us;
+	bool stimulus_pending;
+
+	/* Timing, all in us on the host backend clock. */
+	uint32_t now_us;
+	uint32_t next_report_us;
+	uint32_t boot_done_us;
+	uint32_t ati_done_us;
+	uint32_t idle_since_us;
+	uint32_t window_opened_us;
+	bool booting;
+	bool ati_running;
+
+	/* Communication window. */
+	bool window_open;
+	bool reset_after_close;
+	bool events_reported;
+	uint16_t pointer;
+	bool pointer_ext;
+} iqs7222c_sim_t;
+
+extern const i2c_touch_host_device_t iqs7222c_sim_device;
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+void iqs7222c_sim_default_config(iqs7222c_sim_config_t *config);
+/* Initialise the model, powered on at time 0. */
+void iqs7222c_sim_init(iqs7222c_sim_t *sim, const iqs7222c_sim_config_t *config);
+void iqs7222c_sim_power_on(iqs7222c_sim_t *sim, uint32_t now_us);
+void iqs7222c_sim_set_delta(iqs7222c_sim_t *sim, uint8_t channel, int16_t delta);
+void iqs7222c_sim_set_slider(iqs7222c_sim_t *sim, uint8_t slider, uint16_t value);
+uint16_t iqs7222c_sim_read_word(const iqs7222c_sim_t *sim, uint16_t address);
+const iqs7222c_sim_stats_t *iqs7222c_sim_stats(const iqs7222c_sim_t *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IQS7222C_SIM_H
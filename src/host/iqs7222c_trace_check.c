@@ -0,0 +1,362 @@
+/** @file iqs7222c_trace_check.c
+*
+* @brief Host check of the trace capture and replay round trip. Each case
+* runs the driver against the register model through i2c_touch_trace_backend
+* while touches and slider moves are applied, then runs a fresh driver
+* against the recording with i2c_touch_replay the way iqs7222c_replay does.
+* The replay must answer every transfer without a mismatch and decode the
+* same frames as the capture. Build from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_trace_check.c \
+*       src/host/i2c_touch_replay.c src/wrappers/i2c_touch_trace.c \
+*       bsp/iqs7222c/src/iqs7222c.c src/host/iqs7222c_sim.c \
+*       src/wrappers/i2c_touch.c src/wrappers/i2c_touch_host.c \
+*       -o iqs7222c_trace_check
+*
+* and run ./iqs7222c_trace_check, which exits with 1 if a case fails.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "i2c_touch_replay.h"
+#include "i2c_touch_trace.h"
+#include "iqs7222c.h"
+#include "iqs7222c_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_STEP_US 100
+#define CHECK_ROUND_MS 20
+#define CHECK_ROUNDS 200
+#define CHECK_TOUCH_DELTA 300
+#define CHECK_TRACE_BYTES 65536
+#define CHECK_MAX_FRAMES 512
+
+/* Longest clock step between driver calls during the replay, the init timers
+ * must not be skipped. */
+#define CHECK_REPLAY_MAX_STEP_US 500u
+/* Clock steps after the last record, for a read still completing. */
+#define CHECK_REPLAY_TAIL_STEPS 10
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	bool (*run)(void);
+} check_case_t;
+
+/* How windows are read while capturing and while replaying. */
+typedef enum
+{
+	CHECK_READ_RUN,   /* iqs7222c_run throughout */
+	CHECK_READ_ASYNC, /* iqs7222c_run, then asynchronous updates */
+} check_read_e;
+
+typedef struct
+{
+	iqs7222c_frame_t frames[CHECK_MAX_FRAMES];
+	uint32_t count;
+	uint32_t last_seq;
+} check_frames_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static bool check_run_windows(void);
+static bool check_async_windows(void);
+static bool check_async_by_run(void);
+static bool check_tampered(void);
+static bool check_capture(check_read_e mode);
+static bool check_replay(check_read_e mode, uint32_t *mismatches);
+static bool check_round_trip(check_read_e captureMode, check_read_e replayMode);
+static void check_replay_step(void);
+static void check_grab(check_frames_t *frames);
+static bool check_same_frames(void);
+static void check_sink(void *p_context, const uint8_t *data, uint32_t len);
+static void check_update(iqs7222c_t *device, int result);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t sim;
+static iqs7222c_t dev;
+static i2c_touch_trace_t trace;
+static i2c_touch_replay_t replay;
+
+static uint8_t traceBytes[CHECK_TRACE_BYTES];
+static uint32_t traceLength;
+static bool traceOverflow;
+
+static check_frames_t captured;
+static check_frames_t replayed;
+/* Frames decoded before the capture switched to asynchronous updates. */
+static uint32_t asyncFrom;
+
+static const check_case_t checkCases[] = {
+	{"run_windows", check_run_windows},
+	{"async_windows", check_async_windows},
+	{"async_by_run", check_async_by_run},
+	{"tampered", check_tampered},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(void)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		bool passed = checkCases[i].run();
+
+		printf("%-16s %s\n", checkCases[i].name, passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed\n", count - failed, count);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Every window read by iqs7222c_run, on the target and in the replay. */
+static bool check_run_windows(void)
+{
+	return check_round_trip(CHECK_READ_RUN, CHECK_READ_RUN);
+}
+
+/* Windows read from the RDY interrupt, the replay switches at the same
+ * frame. */
+static bool check_async_windows(void)
+{
+	return check_round_trip(CHECK_READ_ASYNC, CHECK_READ_ASYNC);
+}
+
+/* Windows read asynchronously on the target are read by iqs7222c_run in the
+ * replay, as iqs7222c_replay does. */
+static bool check_async_by_run(void)
+{
+	return check_round_trip(CHECK_READ_ASYNC, CHECK_READ_RUN);
+}
+
+/* A recorded write the driver does not repeat is reported. */
+static bool check_tampered(void)
+{
+	uint32_t mismatches;
+	uint32_t pos = I2C_TOUCH_TRACE_HEADER_BYTES;
+
+	if (!check_capture(CHECK_READ_RUN))
+	{
+		return false;
+	}
+	// Change the last byte of the first write that carries data.
+	while (pos + I2C_TOUCH_TRACE_RECORD_BYTES <= traceLength)
+	{
+		uint8_t *record = &traceBytes[pos];
+		uint32_t len = record[9] | ((uint32_t)record[10] << 8);
+
+		if ((record[0] == I2C_TOUCH_TRACE_TX) && !(record[6] & I2C_TOUCH_TRACE_READ) && (len > 1))
+		{
+			record[I2C_TOUCH_TRACE_RECORD_BYTES + len - 1] ^= 0xFF;
+			break;
+		}
+		pos += I2C_TOUCH_TRACE_RECORD_BYTES + len;
+	}
+	if (pos + I2C_TOUCH_TRACE_RECORD_BYTES > traceLength)
+	{
+		printf("  no write in the trace\n");
+		return false;
+	}
+	return check_replay(CHECK_READ_RUN, &mismatches) && (mismatches != 0);
+}
+
+/* Touch and lift each channel in turn and move slider 0, recording every
+ * transfer. */
+static bool check_capture(check_read_e mode)
+{
+	iqs7222c_sim_config_t config;
+
+	memset(&dev, 0, sizeof(dev));
+	memset(&captured, 0, sizeof(captured));
+	traceLength = 0;
+	traceOverflow = false;
+	i2c_touch_host_setup(&host, 400000);
+	iqs7222c_sim_default_config(&config);
+	iqs7222c_sim_init(&sim, &config);
+	i2c_touch_host_attach(&host, config.address, &iqs7222c_sim_device, &sim);
+	i2c_touch_trace_init(&trace, &i2c_touch_host_backend, &host, check_sink, NULL);
+
+	if (!iqs7222c_beginBackend(&dev, config.address, config.rdy_pin, &i2c_touch_trace_backend,
+	                           &trace))
+	{
+		printf("  begin failed\n");
+		return false;
+	}
+	while (!iqs7222c_init(&dev))
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+
+	asyncFrom = UINT32_MAX;
+	for (uint32_t round = 0; round < CHECK_ROUNDS; round++)
+	{
+		if ((mode == CHECK_READ_ASYNC) && (round == CHECK_ROUNDS / 2))
+		{
+			asyncFrom = captured.count;
+			iqs7222c_startAsyncUpdates(&dev, check_update);
+		}
+		iqs7222c_sim_set_delta(&sim, (round / 2) % IQS7222C_SIM_CHANNELS,
+		                       (round & 1) ? 0 : CHECK_TOUCH_DELTA);
+		if ((round % 5) == 0)
+		{
+			iqs7222c_sim_set_slider(&sim, IQS7222C_SLIDER0, (uint16_t)(round * 10));
+		}
+		for (uint32_t step = 0; step < CHECK_ROUND_MS * 1000u / CHECK_STEP_US; step++)
+		{
+			i2c_touch_host_advance(&host, CHECK_STEP_US);
+			iqs7222c_run(&dev);
+			check_grab(&captured);
+			i2c_touch_trace_flush(&trace);
+		}
+	}
+	i2c_touch_trace_flush(&trace);
+
+	if (traceOverflow || (trace.dropped != 0) || (captured.count == 0))
+	{
+		printf("  capture: %u frames, %u bytes, %u dropped%s\n", captured.count, traceLength,
+		       trace.dropped, traceOverflow ? ", buffer full" : "");
+		return false;
+	}
+	return true;
+}
+
+/* Run a fresh driver against the recording. */
+static bool check_replay(check_read_e mode, uint32_t *mismatches)
+{
+	memset(&dev, 0, sizeof(dev));
+	memset(&replayed, 0, sizeof(replayed));
+	if (!i2c_touch_replay_init(&replay, traceBytes, traceLength))
+	{
+		printf("  not a trace\n");
+		return false;
+	}
+
+	// Bus frequency 0, the recorded spacing already holds the wire time.
+	i2c_touch_host_setup(&host, 0);
+	i2c_touch_host_attach(&host, replay.address, &i2c_touch_replay_device, &replay);
+	iqs7222c_begin(&dev, replay.address, (uint8_t)replay.pin, &host);
+	while (!iqs7222c_init(&dev) && !i2c_touch_replay_done(&replay))
+	{
+		check_replay_step();
+	}
+
+	while (!i2c_touch_replay_done(&replay))
+	{
+		check_replay_step();
+		if ((mode == CHECK_READ_ASYNC) && !dev.async_updates && (replayed.count == asyncFrom))
+		{
+			iqs7222c_startAsyncUpdates(&dev, check_update);
+		}
+		iqs7222c_run(&dev);
+		check_grab(&replayed);
+	}
+	for (uint32_t step = 0; step < CHECK_REPLAY_TAIL_STEPS; step++)
+	{
+		check_replay_step();
+		check_grab(&replayed);
+	}
+
+	*mismatches = replay.stats.mismatches;
+	return true;
+}
+
+static bool check_round_trip(check_read_e captureMode, check_read_e replayMode)
+{
+	uint32_t mismatches;
+
+	if (!check_capture(captureMode) || !check_replay(replayMode, &mismatches))
+	{
+		return false;
+	}
+	if (mismatches != 0)
+	{
+		printf("  %u of %u transfers differ from the trace\n", mismatches,
+		       replay.stats.transfers);
+		return false;
+	}
+	return check_same_frames();
+}
+
+/* Jump to the next record, or less if the driver may have a timer due. */
+static void check_replay_step(void)
+{
+	uint32_t nowUs = (uint32_t)(i2c_touch_host_now_ns(&host) / 1000u);
+	uint32_t stepUs = i2c_touch_replay_next_us(&replay) - nowUs;
+
+	if (stepUs == 0)
+	{
+		stepUs = 1;
+	}
+	else if (stepUs > CHECK_REPLAY_MAX_STEP_US)
+	{
+		stepUs = CHECK_REPLAY_MAX_STEP_US;
+	}
+	i2c_touch_host_advance(&host, stepUs);
+}
+
+/* Keep each published frame once, without its timestamp: the replay clock
+ * starts elsewhere. */
+static void check_grab(check_frames_t *frames)
+{
+	iqs7222c_frame_t frame;
+	uint32_t seq = iqs7222c_readFrame(&dev, &frame);
+
+	if ((seq != frames->last_seq) && (frames->count < CHECK_MAX_FRAMES))
+	{
+		frames->last_seq = seq;
+		frame.timestamp_us = 0;
+		frames->frames[frames->count++] = frame;
+	}
+}
+
+static bool check_same_frames(void)
+{
+	if (replayed.count != captured.count)
+	{
+		printf("  %u frames replayed, %u captured\n", replayed.count, captured.count);
+		return false;
+	}
+	for (uint32_t i = 0; i < captured.count; i++)
+	{
+		if (memcmp(&captured.frames[i], &replayed.frames[i], sizeof(iqs7222c_frame_t)) != 0)
+		{
+			printf("  frame %u differs\n", i);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void check_sink(void *p_context, const uint8_t *data, uint32_t len)
+{
+	(void)p_context;
+	if (traceLength + len > sizeof(traceBytes))
+	{
+		traceOverflow = true;
+		return;
+	}
+	memcpy(&traceBytes[traceLength], data, len);
+	traceLength += len;
+}
+
+static void check_update(iqs7222c_t *device, int result)
+{
+	(void)device;
+	(void)result;
+}
@@ -0,0 +1,272 @@
+/** @file iqs7222c_wheel_check.c
+*
+* @brief Host check of the wheel unwrapping, run through the driver and the
+* register model. Each case starts the model and the driver with the default
+* init, which leaves the part in event mode with the slider events enabled,
+* sets slider 0 up as a wheel with iqs7222c_setConfig and turns it one step
+* per RDY window. The unwrapped position and the detents delivered by the
+* driver's slider events are compared with the travel of the steps. Build
+* from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_wheel_check.c \
+*       bsp/iqs7222c/src/iqs7222c_wheel.c bsp/iqs7222c/src/iqs7222c.c \
+*       src/host/iqs7222c_sim.c src/wrappers/i2c_touch.c \
+*       src/wrappers/i2c_touch_host.c -o iqs7222c_wheel_check
+*
+* and run ./iqs7222c_wheel_check, which exits with 1 if a case fails.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "IQS7222C_init.h"
+#include "iqs7222c.h"
+#include "iqs7222c_sim.h"
+#include "iqs7222c_wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_STEP_US 100
+#define CHECK_WINDOW_TIMEOUT_MS 100
+#define CHECK_RANGE 2400
+#define CHECK_CHANNEL 0
+#define CHECK_TOUCH_DELTA 300
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	bool (*run)(void);
+} check_case_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static bool check_resolution(void);
+static bool check_forward_wrap(void);
+static bool check_backward_from_rest(void);
+static bool check_speed_up(void);
+static bool check_lift(void);
+static void check_start(void);
+static bool check_spin(uint16_t start, int32_t step, uint32_t windows);
+static bool check_window(uint16_t position);
+static bool check_turned(int32_t travel);
+static void check_rotate(iqs7222c_wheel_t *recognizer, const iqs7222c_wheel_event_t *event,
+                         void *p_context);
+static void check_slider(iqs7222c_t *device, const iqs7222c_event_t *event, void *p_context);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t sim;
+static iqs7222c_t dev;
+static iqs7222c_wheel_t wheel;
+
+static uint32_t sliderEvents;
+static int32_t handlerTotal;
+static int32_t handlerDetents;
+
+static const check_case_t checkCases[] = {
+	{"resolution", check_resolution},
+	{"forward_wrap", check_forward_wrap},
+	{"backward_rest", check_backward_from_rest},
+	{"speed_up", check_speed_up},
+	{"lift", check_lift},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(void)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		check_start();
+		bool passed = checkCases[i].run();
+
+		printf("%-16s %s\n", checkCases[i].name, passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed\n", count - failed, count);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* The resolution comes from the written setup, a plain slider has none. */
+static bool check_resolution(void)
+{
+	return (iqs7222c_wheelResolution(&dev, IQS7222C_SLIDER0) == CHECK_RANGE) &&
+	       (iqs7222c_wheelResolution(&dev, IQS7222C_SLIDER1) == 0);
+}
+
+/* +300 per window through 0 twice, two turns forward. */
+static bool check_forward_wrap(void)
+{
+	return check_spin(2000, 300, 16) && check_turned(16 * 300);
+}
+
+/* -450 per window from rest, the first step takes the short way round. */
+static bool check_backward_from_rest(void)
+{
+	return check_spin(300, -450, 12) && check_turned(-12 * 450);
+}
+
+/* A spin that speeds up smoothly is followed beyond half a turn per window. */
+static bool check_speed_up(void)
+{
+	int32_t travel = 0;
+	uint16_t position = 100;
+
+	if (!check_window(position))
+	{
+		return false;
+	}
+	for (int32_t step = 200; step <= 1800; step += 200)
+	{
+		position = (uint16_t)((position + step) % CHECK_RANGE);
+		travel += step;
+		if (!check_window(position))
+		{
+			return false;
+		}
+	}
+	return check_turned(travel);
+}
+
+/* Lifting and touching down elsewhere is not a jump. */
+static bool check_lift(void)
+{
+	if (!check_spin(0, 200, 6) || !check_window(IQS7222C_SLIDER_NO_TOUCH))
+	{
+		return false;
+	}
+	return check_spin(1800, 100, 2) && check_turned(6 * 200 + 2 * 100);
+}
+
+static void check_start(void)
+{
+	iqs7222c_sim_config_t config;
+	iqs7222c_wheel_config_t wheelConfig;
+	uint8_t general = SLIDER0SETUP_GENERAL | IQS7222C_SLIDER_WHEEL_ENABLE;
+	uint8_t resolution[2] = {CHECK_RANGE & 0xFF, CHECK_RANGE >> 8};
+
+	memset(&dev, 0, sizeof(dev));
+	i2c_touch_host_setup(&host, 400000);
+	iqs7222c_sim_default_config(&config);
+	iqs7222c_sim_init(&sim, &config);
+	i2c_touch_host_attach(&host, config.address, &iqs7222c_sim_device, &sim);
+
+	if (!iqs7222c_begin(&dev, config.address, config.rdy_pin, &host))
+	{
+		fprintf(stderr, "begin failed\n");
+		exit(1);
+	}
+	while (!iqs7222c_init(&dev))
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+
+	iqs7222c_setConfig(&dev, IQS7222C_MM_SLIDER_SETUP_0, true, &general, 1);
+	iqs7222c_setConfig(&dev, IQS7222C_MM_SLIDER_SETUP_0 + IQS7222C_SLIDER_RESOLUTION_WORD, true,
+	                   resolution, sizeof(resolution));
+	if (iqs7222c_flushConfig(&dev, STOP) != I2C_TOUCH_SUCCESS)
+	{
+		fprintf(stderr, "wheel setup failed\n");
+		exit(1);
+	}
+
+	iqs7222c_wheel_default_config(&wheelConfig, iqs7222c_wheelResolution(&dev, IQS7222C_SLIDER0));
+	iqs7222c_wheel_init(&wheel, &wheelConfig, IQS7222C_SLIDER0, check_rotate, NULL);
+	if (!iqs7222c_wheel_attach(&wheel, &dev) ||
+	    !iqs7222c_subscribe(&dev, IQS7222C_EVENT_MASK(IQS7222C_EVENT_SLIDER), IQS7222C_ALL_CHANNELS,
+	                        check_slider, NULL))
+	{
+		fprintf(stderr, "attach failed\n");
+		exit(1);
+	}
+	handlerTotal = 0;
+	handlerDetents = 0;
+}
+
+/* Touch at start, then windows more steps of step each. */
+static bool check_spin(uint16_t start, int32_t step, uint32_t windows)
+{
+	int32_t position = start;
+
+	if (!check_window(start))
+	{
+		return false;
+	}
+	for (uint32_t i = 0; i < windows; i++)
+	{
+		position = (position + step + CHECK_RANGE) % CHECK_RANGE;
+		if (!check_window((uint16_t)position))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Move the finger to position and run until the driver reports it. */
+static bool check_window(uint16_t position)
+{
+	uint32_t events = sliderEvents;
+
+	iqs7222c_sim_set_delta(&sim, CHECK_CHANNEL,
+	                       (position == IQS7222C_SLIDER_NO_TOUCH) ? 0 : CHECK_TOUCH_DELTA);
+	iqs7222c_sim_set_slider(&sim, IQS7222C_SLIDER0, position);
+	for (uint32_t step = 0; step < CHECK_WINDOW_TIMEOUT_MS * 1000u / CHECK_STEP_US; step++)
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+		iqs7222c_run(&dev);
+		if (sliderEvents != events)
+		{
+			return true;
+		}
+	}
+	printf("  no window for %u\n", position);
+	return false;
+}
+
+/* Unwrapped travel and detents, as returned and as seen by the handler. */
+static bool check_turned(int32_t travel)
+{
+	int32_t detents = travel / wheel.config.counts_per_detent;
+
+	if ((wheel.position != travel) || (wheel.total != detents) || (handlerTotal != detents) ||
+	    (handlerDetents != detents))
+	{
+		printf("  position %d total %d handler %d/%d, expected %d and %d\n", wheel.position,
+		       wheel.total, handlerTotal, handlerDetents, travel, detents);
+		return false;
+	}
+	return true;
+}
+
+static void check_rotate(iqs7222c_wheel_t *recognizer, const iqs7222c_wheel_event_t *event,
+                         void *p_context)
+{
+	(void)recognizer;
+	(void)p_context;
+	handlerTotal = event->total;
+	handlerDetents += event->detents;
+}
+
+static void check_slider(iqs7222c_t *device, const iqs7222c_event_t *event, void *p_context)
+{
+	(void)device;
+	(void)p_context;
+	if (event->index == IQS7222C_SLIDER0)
+	{
+		sliderEvents++;
+	}
+}
@@ -0,0 +1,318 @@
+/** @file iqs7222c_window_check.c
+*
+* @brief Host check of the RDY window accounting, run through the driver and
+* the register model. Each case starts the model and the driver with the
+* default init and a short COMMS_TIMEOUT, then opens windows with touches and
+* services them in time, late, after an overrun or after iqs7222c_sched
+* dropped one. The window counters and the calls of the overrun handler are
+* compared with the expected ones. Build from the repository root with
+*
+*   gcc -std=gnu99 -O2 -DI2C_TOUCH_HOST=1 -Ibsp/iqs7222c/include \
+*       -Isrc/wrappers -Isrc/host src/host/iqs7222c_window_check.c \
+*       bsp/iqs7222c/src/iqs7222c_sched.c bsp/iqs7222c/src/iqs7222c.c \
+*       src/host/iqs7222c_sim.c src/wrappers/i2c_touch.c \
+*       src/wrappers/i2c_touch_host.c -o iqs7222c_window_check
+*
+* and run ./iqs7222c_window_check, which exits with 1 if a case fails.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include "iqs7222c.h"
+#include "iqs7222c_sched.h"
+#include "iqs7222c_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+#define CHECK_STEP_US 100
+#define CHECK_EDGE_TIMEOUT_MS 100
+#define CHECK_TIMEOUT_MS 10
+#define CHECK_MAX_CALLS 8
+#define CHECK_CHANNEL 0
+#define CHECK_TOUCH_DELTA 300
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	const char *name;
+	bool (*run)(void);
+} check_case_t;
+
+//---------------------- PRIVATE FUNCTION PROTOTYPES --------------------------
+static bool check_in_time(void);
+static bool check_late(void);
+static bool check_overrun(void);
+static bool check_dropped(void);
+static void check_start(void);
+static bool check_edge(int16_t delta);
+static void check_wait_timeout(void);
+static bool check_stats(uint32_t edges, uint32_t serviced, uint32_t missed, uint32_t late,
+                        uint32_t overruns);
+static bool check_calls(const bool expected[], uint32_t count);
+static void check_overrun_handler(iqs7222c_t *device, bool overrun, void *p_context);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static i2c_touch_host_t host;
+static iqs7222c_sim_t sim;
+static iqs7222c_t dev;
+
+/* Arguments of the overrun handler calls, in order. */
+static bool calls[CHECK_MAX_CALLS];
+static uint32_t callCount;
+
+static const check_case_t checkCases[] = {
+	{"in_time", check_in_time},
+	{"late", check_late},
+	{"overrun", check_overrun},
+	{"dropped", check_dropped},
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+int main(void)
+{
+	uint32_t failed = 0;
+	uint32_t count = sizeof(checkCases) / sizeof(checkCases[0]);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		check_start();
+		bool passed = checkCases[i].run();
+
+		printf("%-16s %s\n", checkCases[i].name, passed ? "ok" : "FAIL");
+		failed += passed ? 0 : 1;
+	}
+	printf("%u of %u cases passed\n", count - failed, count);
+	return (failed == 0) ? 0 : 1;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+
+/* Windows read straight after their edge: serviced, no handler call. */
+static bool check_in_time(void)
+{
+	if (!check_edge(CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	iqs7222c_run(&dev);
+	if (!check_edge(0))
+	{
+		return false;
+	}
+	iqs7222c_run(&dev);
+	return check_stats(2, 2, 0, 0, 0) && check_calls(NULL, 0);
+}
+
+/* A read past the comms timeout is missed and late and sets the overrun,
+ * the next read in time clears it. */
+static bool check_late(void)
+{
+	static const bool expected[] = {true, false};
+
+	if (!check_edge(CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	check_wait_timeout();
+	iqs7222c_run(&dev);
+	if (!check_stats(1, 0, 1, 1, 0) || !check_calls(expected, 1))
+	{
+		return false;
+	}
+
+	if (!check_edge(0))
+	{
+		return false;
+	}
+	iqs7222c_run(&dev);
+	return check_stats(2, 1, 1, 1, 0) && check_calls(expected, 2);
+}
+
+/* A second edge before the first window is read is an overrun, reported
+ * from the interrupt. The read after it skips the first window. */
+static bool check_overrun(void)
+{
+	static const bool expected[] = {true, false};
+
+	if (!check_edge(CHECK_TOUCH_DELTA) || !check_edge(0))
+	{
+		return false;
+	}
+	if (!check_stats(2, 0, 0, 0, 1) || !check_calls(expected, 1))
+	{
+		return false;
+	}
+	iqs7222c_run(&dev);
+	if (!check_stats(2, 1, 1, 0, 1) || !check_calls(expected, 1))
+	{
+		return false;
+	}
+
+	if (!check_edge(CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	iqs7222c_run(&dev);
+	return check_stats(3, 2, 1, 0, 1) && check_calls(expected, 2);
+}
+
+/* A window the scheduler dropped is found as a skipped edge by the next
+ * read, which sets the overrun although that read is in time. */
+static bool check_dropped(void)
+{
+	static const bool expected[] = {true, false};
+	iqs7222c_sched_t sched;
+
+	iqs7222c_sched_init(&sched);
+	iqs7222c_sched_add(&sched, &dev);
+	if (!check_edge(CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	check_wait_timeout();
+	if ((iqs7222c_sched_run(&sched) != 0) || !check_stats(1, 0, 0, 0, 0) ||
+	    !check_calls(expected, 0))
+	{
+		return false;
+	}
+
+	if (!check_edge(0))
+	{
+		return false;
+	}
+	if ((iqs7222c_sched_run(&sched) != 1) || !check_stats(2, 1, 1, 0, 0) ||
+	    !check_calls(expected, 1))
+	{
+		return false;
+	}
+
+	if (!check_edge(CHECK_TOUCH_DELTA))
+	{
+		return false;
+	}
+	iqs7222c_sched_run(&sched);
+	return check_stats(3, 2, 1, 0, 0) && check_calls(expected, 2);
+}
+
+static void check_start(void)
+{
+	iqs7222c_sim_config_t config;
+	uint8_t timeout[2] = {CHECK_TIMEOUT_MS & 0xFF, CHECK_TIMEOUT_MS >> 8};
+
+	memset(&dev, 0, sizeof(dev));
+	i2c_touch_host_setup(&host, 400000);
+	iqs7222c_sim_default_config(&config);
+	iqs7222c_sim_init(&sim, &config);
+	i2c_touch_host_attach(&host, config.address, &iqs7222c_sim_device, &sim);
+
+	if (!iqs7222c_begin(&dev, config.address, config.rdy_pin, &host))
+	{
+		fprintf(stderr, "begin failed\n");
+		exit(1);
+	}
+	while (!iqs7222c_init(&dev))
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+
+	iqs7222c_setConfig(&dev, IQS7222C_MM_COMMS_TIMEOUT, false, timeout, sizeof(timeout));
+	if (iqs7222c_flushConfig(&dev, STOP) != I2C_TOUCH_SUCCESS)
+	{
+		fprintf(stderr, "timeout setup failed\n");
+		exit(1);
+	}
+	// One window per touch, a learned burst may ask for a second one.
+	iqs7222c_setReadPlan(&dev, IQS7222C_READ_FIXED, IQS7222C_READ_SLIDERS);
+	for (uint32_t step = 0; step < CHECK_EDGE_TIMEOUT_MS * 1000u / CHECK_STEP_US; step++)
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+		iqs7222c_run(&dev);
+	}
+
+	iqs7222c_resetWindowStats(&dev);
+	iqs7222c_setOverrunHandler(&dev, check_overrun_handler, NULL);
+	callCount = 0;
+}
+
+/* Touch or lift and run, without servicing, until the next RDY edge. */
+static bool check_edge(int16_t delta)
+{
+	uint32_t edges = dev.rdy_edges;
+
+	iqs7222c_sim_set_delta(&sim, CHECK_CHANNEL, delta);
+	for (uint32_t step = 0; step < CHECK_EDGE_TIMEOUT_MS * 1000u / CHECK_STEP_US; step++)
+	{
+		if (dev.rdy_edges != edges)
+		{
+			return true;
+		}
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+	printf("  no window\n");
+	return false;
+}
+
+/* Run past the comms timeout of the window just opened. */
+static void check_wait_timeout(void)
+{
+	for (uint32_t step = 0; step <= CHECK_TIMEOUT_MS * 1000u / CHECK_STEP_US; step++)
+	{
+		i2c_touch_host_advance(&host, CHECK_STEP_US);
+	}
+}
+
+static bool check_stats(uint32_t edges, uint32_t serviced, uint32_t missed, uint32_t late,
+                        uint32_t overruns)
+{
+	iqs7222c_window_stats_t stats = iqs7222c_getWindowStats(&dev);
+
+	if ((stats.rdy_edges != edges) || (stats.serviced != serviced) || (stats.missed != missed) ||
+	    (stats.late != late) || (stats.overruns != overruns))
+	{
+		printf("  edges %u serviced %u missed %u late %u overruns %u, expected %u %u %u %u %u\n",
+		       stats.rdy_edges, stats.serviced, stats.missed, stats.late, stats.overruns, edges,
+		       serviced, missed, late, overruns);
+		return false;
+	}
+	return true;
+}
+
+/* The handler was called exactly with these arguments. */
+static bool check_calls(const bool expected[], uint32_t count)
+{
+	bool match = (callCount == count);
+
+	for (uint32_t i = 0; match && (i < count); i++)
+	{
+		match = (calls[i] == expected[i]);
+	}
+	if (!match)
+	{
+		printf("  handler");
+		for (uint32_t i = 0; i < callCount; i++)
+		{
+			printf(" %s", calls[i] ? "true" : "false");
+		}
+		printf("\n");
+	}
+	return match;
+}
+
+static void check_overrun_handler(iqs7222c_t *device, bool overrun, void *p_context)
+{
+	(void)device;
+	(void)p_context;
+	if (callCount < CHECK_MAX_CALLS)
+	{
+		calls[callCount++] = overrun;
+	}
+}
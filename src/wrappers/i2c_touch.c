@@ -1,6 +1,8 @@
-/** @file i2c_touch.c 
+/** @file i2c_touch.c
 *
-* @brief A description of the module's purpose.
+* @brief Backend neutral register access for the touch controller. All
+* transfers are dispatched to the backend selected with i2c_touch_init or
+* i2c_touch_set_backend.
 *
 * @par
 * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
@@ -9,10 +11,8 @@
 
 //------------------------------ INCLUDES -------------------------------------
 #include <i2c_touch.h>
-#include "i2c.h"
 #include <stdio.h>
-#include "nrf_error.h"
-#include "sdk_errors.h"
+#include <string.h>
 
 //-------------------------------- MACROS -------------------------------------
 
@@ -22,51 +22,135 @@
 
 //----------------------- STATIC DATA & CONSTANTS -----------------------------
 
-static nrf_drv_twi_t *pTwi;
 //------------------------------ GLOBAL DATA ----------------------------------
 
 //---------------------------- PUBLIC FUNCTIONS -------------------------------
-void i2c_touch_init(const nrf_drv_twi_t *mTwi)
+void i2c_touch_init(i2c_touch_t *bus, const i2c_touch_bus_t *mTwi)
 {
 
 	if (mTwi != NULL)
 	{
-		pTwi = mTwi;
+#if I2C_TOUCH_HOST
+		i2c_touch_set_backend(bus, &i2c_touch_host_backend, (void *)mTwi);
+#else
+		i2c_touch_set_backend(bus, &i2c_touch_nrf_backend, (void *)mTwi);
+#endif
 	}
 }
 
-int i2c_touch_write_register(uint8_t I2Caddress, uint8_t reg, uint32_t len, uint8_t const *data, bool stop)
+void i2c_touch_set_backend(i2c_touch_t *bus, const i2c_touch_backend_t *backend, void *context)
+{
+	if (backend != NULL)
+	{
+		bus->backend = backend;
+		bus->context = context;
+	}
+}
+
+int i2c_touch_write_register(const i2c_touch_t *bus, uint8_t I2Caddress, uint8_t reg, uint32_t len,
+                             uint8_t const *data, bool stop)
 {
 	// Data to be sent over TWI is {reg,data} -- reg = internal register of Sensor to which data is written
+	// The register and the payload are handed over as two segments, the payload is not copied
 
-	ret_code_t retCode;
-	uint8_t buff[len + 1];
-	buff[0] = reg;
-	memcpy(buff + sizeof(reg), data, len);
-	retCode = nrf_drv_twi_tx(pTwi, I2Caddress, buff, sizeof(buff), stop);
-	return retCode;
+	return bus->backend->tx(bus->context, I2Caddress, &reg, sizeof(reg), data, len, stop);
 }
 
-int i2c_touch_write_register_16(uint8_t I2Caddress, uint16_t reg, uint32_t len, uint8_t const *data, bool stop)
+int i2c_touch_write_register_16(const i2c_touch_t *bus, uint8_t I2Caddress, uint16_t reg,
+                                uint32_t len, uint8_t const *data, bool stop)
 {
 	// Data to be sent over TWI is {reg,data} -- reg = internal register of Sensor to which data is written
+	// Extended register addresses are sent high byte first
 
-	ret_code_t retCode;
-	uint8_t buff[len + sizeof(reg)];
-	memcpy(buff, reg, sizeof(reg));
-	memcpy(buff + sizeof(reg), data, len);
-	retCode = nrf_drv_twi_tx(pTwi, I2Caddress, buff, sizeof(buff), stop);
+	uint8_t regBytes[2] = {(uint8_t)(reg >> 8), (uint8_t)reg};
+	return bus->backend->tx(bus->context, I2Caddress, regBytes, sizeof(regBytes), data, len, stop);
+}
+
+int i2c_touch_read_register(const i2c_touch_t *bus, uint8_t I2Caddress, uint8_t reg, uint32_t len,
+                            uint8_t *buff, bool stop)
+{
+	// The register address goes out without a stop, the read follows with a
+	// repeated start and always ends with a stop
+
+	(void)stop;
+	int retCode;
+	retCode = bus->backend->tx(bus->context, I2Caddress, &reg, 1, NULL, 0, false);
+	if (retCode == I2C_TOUCH_SUCCESS)
+	{
+		retCode = bus->backend->rx(bus->context, I2Caddress, buff, len);
+	}
 	return retCode;
 }
 
-int i2c_touch_read_register(uint8_t I2Caddress, uint8_t reg, uint32_t len, uint8_t *buff, bool stop)
+int i2c_touch_read_register_16(const i2c_touch_t *bus, uint8_t I2Caddress, uint16_t reg,
+                               uint32_t len, uint8_t *buff, bool stop)
 {
-	ret_code_t retCode;
-	retCode = nrf_drv_twi_tx(pTwi, I2Caddress, &reg, 1, stop);
-	retCode = nrf_drv_twi_rx(pTwi, I2Caddress, buff, len);
+	// Extended register addresses are sent high byte first, then read as in
+	// i2c_touch_read_register
+
+	(void)stop;
+	int retCode;
+	uint8_t regBytes[2] = {(uint8_t)(reg >> 8), (uint8_t)reg};
+	retCode = bus->backend->tx(bus->context, I2Caddress, regBytes, sizeof(regBytes), NULL, 0, false);
+	if (retCode == I2C_TOUCH_SUCCESS)
+	{
+		retCode = bus->backend->rx(bus->context, I2Caddress, buff, len);
+	}
 	return retCode;
 }
 
+int i2c_touch_read_register_async(const i2c_touch_t *bus, uint8_t I2Caddress, uint8_t reg,
+                                  uint32_t len, uint8_t *buff, i2c_touch_xfer_handler_t handler,
+                                  void *p_context)
+{
+	return bus->backend->read_async(bus->context, I2Caddress, reg, buff, len, handler, p_context);
+}
+
+int i2c_touch_pin_init(const i2c_touch_t *bus, uint32_t pin, i2c_touch_pin_handler_t handler,
+                       void *p_context)
+{
+	return bus->backend->pin_init(bus->context, pin, handler, p_context);
+}
+
+void i2c_touch_pin_uninit(const i2c_touch_t *bus, uint32_t pin)
+{
+	bus->backend->pin_uninit(bus->context, pin);
+}
+
+bool i2c_touch_pin_is_set(const i2c_touch_t *bus, uint32_t pin)
+{
+	return bus->backend->pin_is_set(bus->context, pin);
+}
+
+void i2c_touch_delay_us(const i2c_touch_t *bus, uint32_t us)
+{
+	bus->backend->delay_us(bus->context, us);
+}
+
+void i2c_touch_delay_ms(const i2c_touch_t *bus, uint32_t ms)
+{
+	while (ms--)
+	{
+		bus->backend->delay_us(bus->context, 1000);
+	}
+}
+
+uint32_t i2c_touch_time_us(const i2c_touch_t *bus)
+{
+	return bus->backend->time_us(bus->context);
+}
+
+int i2c_touch_timer_start(const i2c_touch_t *bus, i2c_touch_timer_t *timer, uint32_t us,
+                          i2c_touch_timer_handler_t handler, void *p_context)
+{
+	return bus->backend->timer_start(bus->context, timer, us, handler, p_context);
+}
+
+void i2c_touch_timer_stop(const i2c_touch_t *bus, i2c_touch_timer_t *timer)
+{
+	bus->backend->timer_stop(bus->context, timer);
+}
+
 //--------------------------- PRIVATE FUNCTIONS -------------------------------
 
 //--------------------------- INTERRUPT HANDLERS ------------------------------
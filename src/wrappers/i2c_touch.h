@@ -15,22 +15,157 @@ extern "C" {
 #endif
 
 //------------------------------ INCLUDES -------------------------------------
-#include "nrf_drv_twi.h"
 #include <stdbool.h>
 #include <stdint.h>
 
+/* Host build select. Define I2C_TOUCH_HOST=1 on the compiler command line to
+ * build the driver on a Linux machine against the host backend. */
+#ifndef I2C_TOUCH_HOST
+#define I2C_TOUCH_HOST 0
+#endif
+
+/* Non-blocking TWI on target. With I2C_TOUCH_TWI_ASYNC=1 the application
+ * initialises its TWI instance with i2c_touch_nrf_twi_handler as the event
+ * handler, i2c_touch_read_register_async then returns before the transfer is
+ * done and the blocking calls wait for the completion event. */
+#ifndef I2C_TOUCH_TWI_ASYNC
+#define I2C_TOUCH_TWI_ASYNC 0
+#endif
+
+#if !I2C_TOUCH_HOST
+#include "nrf_drv_twi.h"
+#include "app_timer.h"
+#endif
+
 //-------------------------- CONSTANTS & MACROS -------------------------------
 
+/* Return codes. Numerically equal to the nRF5 SDK codes so callers can compare
+ * against either set. */
+#define I2C_TOUCH_SUCCESS 0x0000
+#define I2C_TOUCH_ERROR_INVALID_PARAM 0x0007
+#define I2C_TOUCH_ERROR_INVALID_STATE 0x0008
+#define I2C_TOUCH_ERROR_BUSY 0x0011
+#define I2C_TOUCH_ERROR_ANACK 0x8201
+#define I2C_TOUCH_ERROR_DNACK 0x8202
+
 //----------------------------- DATA TYPES ------------------------------------
 
+/* Bus handle passed to i2c_touch_init. The nRF TWI driver instance on target,
+ * the host backend context on Linux. */
+#if I2C_TOUCH_HOST
+typedef struct i2c_touch_host i2c_touch_bus_t;
+#else
+typedef nrf_drv_twi_t i2c_touch_bus_t;
+#endif
+
+/* Called from interrupt context on a falling edge of a pin set up with
+ * i2c_touch_pin_init. */
+typedef void (*i2c_touch_pin_handler_t)(uint32_t pin, void *p_context);
+
+/* Called from interrupt context when a one-shot timer expires. */
+typedef void (*i2c_touch_timer_handler_t)(void *p_context);
+
+/* Called when a transfer started with i2c_touch_read_register_async has
+ * finished, with the I2C_TOUCH_* result. Interrupt context on target. */
+typedef void (*i2c_touch_xfer_handler_t)(int result, void *p_context);
+
+/* One-shot timer storage, owned by the caller. Zero initialise. */
+#if I2C_TOUCH_HOST
+typedef struct i2c_touch_timer
+{
+	uint64_t deadline_ns;
+	i2c_touch_timer_handler_t handler;
+	void *p_context;
+	struct i2c_touch_timer *next;
+	bool armed;
+} i2c_touch_timer_t;
+#else
+typedef struct
+{
+	app_timer_t data;
+	app_timer_id_t id;
+	i2c_touch_timer_handler_t handler;
+	void *p_context;
+} i2c_touch_timer_t;
+#endif
+
+/* Transport backend. Every bus, GPIO and clock access made by the driver goes
+ * through one of these so the same driver code runs on target and on host. */
+typedef struct
+{
+	/* Send prefix_len bytes of prefix followed by len bytes of data as one
+	 * write (one start, one address byte). Either part may be empty. Both
+	 * buffers are only read and may be in flash. stop == true ends the write
+	 * with a STOP condition, which closes the IQS7222C communication window;
+	 * false leaves the bus held for a repeated start, as before a read.
+	 * tx and rx wait for a read_async in flight to complete first. */
+	int (*tx)(void *context, uint8_t address, uint8_t const *prefix, uint32_t prefix_len,
+	          uint8_t const *data, uint32_t len, bool stop);
+	/* Receive len bytes from the device, always terminated with a STOP, so
+	 * every read ends the IQS7222C communication window. */
+	int (*rx)(void *context, uint8_t address, uint8_t *data, uint32_t len);
+	/* Configure pin as input. handler == NULL configures a plain input,
+	 * otherwise the handler is called with p_context on every falling edge. */
+	int (*pin_init)(void *context, uint32_t pin, i2c_touch_pin_handler_t handler, void *p_context);
+	void (*pin_uninit)(void *context, uint32_t pin);
+	bool (*pin_is_set)(void *context, uint32_t pin);
+	void (*delay_us)(void *context, uint32_t us);
+	/* Free running microsecond clock, wraps at 2^32. */
+	uint32_t (*time_us)(void *context);
+	/* One-shot timer, restarting it replaces the previous expiry. */
+	int (*timer_start)(void *context, i2c_touch_timer_t *timer, uint32_t us,
+	                   i2c_touch_timer_handler_t handler, void *p_context);
+	void (*timer_stop)(void *context, i2c_touch_timer_t *timer);
+	/* Write reg then read len bytes into data without waiting, the read ends
+	 * with a stop. data must stay valid until handler is called. Returns
+	 * I2C_TOUCH_ERROR_BUSY while a previous transfer is in flight. */
+	int (*read_async)(void *context, uint8_t address, uint8_t reg, uint8_t *data, uint32_t len,
+	                  i2c_touch_xfer_handler_t handler, void *p_context);
+} i2c_touch_backend_t;
+
+/* Backend bound to one bus. Every device keeps its own, devices on the same
+ * bus share the backend context. */
+typedef struct
+{
+	const i2c_touch_backend_t *backend;
+	void *context;
+} i2c_touch_t;
+
+#if I2C_TOUCH_HOST
+extern const i2c_touch_backend_t i2c_touch_host_backend;
+#else
+extern const i2c_touch_backend_t i2c_touch_nrf_backend;
+#endif
+
+#if !I2C_TOUCH_HOST && I2C_TOUCH_TWI_ASYNC
+void i2c_touch_nrf_twi_handler(nrf_drv_twi_evt_t const *p_event, void *p_context);
+#endif
+
 //---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
-void i2c_touch_init(const nrf_drv_twi_t *mTwi);
-int i2c_touch_write_register(uint8_t I2Caddress, uint8_t reg, uint32_t len,
+void i2c_touch_init(i2c_touch_t *bus, const i2c_touch_bus_t *mTwi);
+void i2c_touch_set_backend(i2c_touch_t *bus, const i2c_touch_backend_t *backend, void *context);
+int i2c_touch_write_register(const i2c_touch_t *bus, uint8_t I2Caddress, uint8_t reg, uint32_t len,
                              uint8_t const *data, bool stop);
-int i2c_touch_write_register_16(uint8_t I2Caddress, uint16_t reg, uint32_t len,
-                                uint8_t const *data, bool stop);
-int i2c_touch_read_register(uint8_t I2Caddress, uint8_t reg, uint32_t len,
+int i2c_touch_write_register_16(const i2c_touch_t *bus, uint8_t I2Caddress, uint16_t reg,
+                                uint32_t len, uint8_t const *data, bool stop);
+int i2c_touch_read_register(const i2c_touch_t *bus, uint8_t I2Caddress, uint8_t reg, uint32_t len,
                             uint8_t *buff, bool stop);
+int i2c_touch_read_register_16(const i2c_touch_t *bus, uint8_t I2Caddress, uint16_t reg,
+                               uint32_t len, uint8_t *buff, bool stop);
+int i2c_touch_read_register_async(const i2c_touch_t *bus, uint8_t I2Caddress, uint8_t reg,
+                                  uint32_t len, uint8_t *buff, i2c_touch_xfer_handler_t handler,
+                                  void *p_context);
+
+int i2c_touch_pin_init(const i2c_touch_t *bus, uint32_t pin, i2c_touch_pin_handler_t handler,
+                       void *p_context);
+void i2c_touch_pin_uninit(const i2c_touch_t *bus, uint32_t pin);
+bool i2c_touch_pin_is_set(const i2c_touch_t *bus, uint32_t pin);
+void i2c_touch_delay_us(const i2c_touch_t *bus, uint32_t us);
+void i2c_touch_delay_ms(const i2c_touch_t *bus, uint32_t ms);
+uint32_t i2c_touch_time_us(const i2c_touch_t *bus);
+int i2c_touch_timer_start(const i2c_touch_t *bus, i2c_touch_timer_t *timer, uint32_t us,
+                          i2c_touch_timer_handler_t handler, void *p_context);
+void i2c_touch_timer_stop(const i2c_touch_t *bus, i2c_touch_timer_t *timer);
 
 #ifdef __cplusplus
 }
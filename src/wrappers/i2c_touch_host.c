@@ -0,0 +1,413 @@
+/** @file i2c_touch_host.c
+*
+* @brief i2c_touch backend for Linux host builds. Transfers are routed by
+* address to the attached device models, time is either a virtual clock
+* advanced by delays and wire time or the monotonic wall clock. Falling edges
+* on registered RDY pins are detected after every clock or bus step and
+* delivered to their pin handlers.
+* Asynchronous reads reach the device at once but complete, and call their
+* handler, only after their wire time has passed on the clock. A blocking
+* transfer started meanwhile first waits for that completion.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include <i2c_touch_host.h>
+
+#if I2C_TOUCH_HOST
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+/* Start + address byte + stop, in bit times. */
+#define HOST_FRAME_OVERHEAD_BITS 11u
+#define HOST_BITS_PER_BYTE 9u
+
+//----------------------------- DATA TYPES ------------------------------------
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static int host_tx(void *context, uint8_t address, uint8_t const *prefix, uint32_t prefix_len,
+                   uint8_t const *data, uint32_t len, bool stop);
+static int host_rx(void *context, uint8_t address, uint8_t *data, uint32_t len);
+static int host_pin_init(void *context, uint32_t pin, i2c_touch_pin_handler_t handler, void *p_context);
+static void host_pin_uninit(void *context, uint32_t pin);
+static bool host_pin_is_set(void *context, uint32_t pin);
+static void host_delay_us(void *context, uint32_t us);
+static uint32_t host_time_us(void *context);
+static int host_timer_start(void *context, i2c_touch_timer_t *timer, uint32_t us,
+                            i2c_touch_timer_handler_t handler, void *p_context);
+static void host_timer_stop(void *context, i2c_touch_timer_t *timer);
+static int host_read_async(void *context, uint8_t address, uint8_t reg, uint8_t *data, uint32_t len,
+                           i2c_touch_xfer_handler_t handler, void *p_context);
+static const i2c_touch_host_slot_t *host_find(const i2c_touch_host_t *host, uint8_t address);
+static bool host_level(const i2c_touch_host_t *host, uint32_t pin);
+static void host_step(i2c_touch_host_t *host, uint64_t ns);
+static void host_wait(i2c_touch_host_t *host);
+static void host_charge_wire(i2c_touch_host_t *host, uint32_t len);
+static uint64_t host_wire_time_ns(const i2c_touch_host_t *host, uint32_t len);
+static uint64_t host_wall_ns(void);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+const i2c_touch_backend_t i2c_touch_host_backend = {
+	.tx = host_tx,
+	.rx = host_rx,
+	.pin_init = host_pin_init,
+	.pin_uninit = host_pin_uninit,
+	.pin_is_set = host_pin_is_set,
+	.delay_us = host_delay_us,
+	.time_us = host_time_us,
+	.timer_start = host_timer_start,
+	.timer_stop = host_timer_stop,
+	.read_async = host_read_async,
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+void i2c_touch_host_setup(i2c_touch_host_t *host, uint32_t bus_hz)
+{
+	host->bus_hz = bus_hz;
+	host->realtime = false;
+	host->device_count = 0;
+	host->pin_count = 0;
+	host->now_ns = 0;
+	host->wire_ns = 0;
+	host->timers = NULL;
+	host->xfer_deadline_ns = 0;
+	host->xfer_handler = NULL;
+	host->xfer_p_context = NULL;
+	host->xfer_result = I2C_TOUCH_SUCCESS;
+}
+
+/* Attach a device answering on a 7-bit address. */
+int i2c_touch_host_attach(i2c_touch_host_t *host, uint8_t address,
+                          const i2c_touch_host_device_t *device, void *device_context)
+{
+	if (host->device_count >= I2C_TOUCH_HOST_MAX_DEVICES)
+	{
+		return I2C_TOUCH_ERROR_INVALID_PARAM;
+	}
+
+	i2c_touch_host_slot_t *slot = &host->devices[host->device_count++];
+	slot->address = address;
+	slot->device = device;
+	slot->context = device_context;
+	return I2C_TOUCH_SUCCESS;
+}
+
+/* Let time pass without bus activity, e.g. while the application sleeps. */
+void i2c_touch_host_advance(i2c_touch_host_t *host, uint32_t us)
+{
+	host_step(host, (uint64_t)us * 1000u);
+}
+
+uint64_t i2c_touch_host_now_ns(const i2c_touch_host_t *host)
+{
+	return host->realtime ? host_wall_ns() : host->now_ns;
+}
+
+uint64_t i2c_touch_host_wire_ns(const i2c_touch_host_t *host)
+{
+	return host->wire_ns;
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+static int host_tx(void *context, uint8_t address, uint8_t const *prefix, uint32_t prefix_len,
+                   uint8_t const *data, uint32_t len, bool stop)
+{
+	i2c_touch_host_t *host = context;
+	host_wait(host);
+	if (prefix_len + len > I2C_TOUCH_HOST_MAX_TX)
+	{
+		return I2C_TOUCH_ERROR_INVALID_PARAM;
+	}
+
+	/* Device models take the write as one frame. */
+	uint8_t frame[I2C_TOUCH_HOST_MAX_TX];
+	if (prefix_len > 0)
+	{
+		memcpy(frame, prefix, prefix_len);
+	}
+	if (len > 0)
+	{
+		memcpy(&frame[prefix_len], data, len);
+	}
+
+	const i2c_touch_host_slot_t *slot = host_find(host, address);
+	int retCode = (slot != NULL) ? slot->device->tx(slot->context, address, frame, prefix_len + len, stop)
+	                             : I2C_TOUCH_ERROR_ANACK;
+	host_charge_wire(host, prefix_len + len);
+	return retCode;
+}
+
+static int host_rx(void *context, uint8_t address, uint8_t *data, uint32_t len)
+{
+	i2c_touch_host_t *host = context;
+	host_wait(host);
+
+	const i2c_touch_host_slot_t *slot = host_find(host, address);
+	int retCode = (slot != NULL) ? slot->device->rx(slot->context, address, data, len)
+	                             : I2C_TOUCH_ERROR_ANACK;
+	host_charge_wire(host, len);
+	return retCode;
+}
+
+static int host_pin_init(void *context, uint32_t pin, i2c_touch_pin_handler_t handler, void *p_context)
+{
+	i2c_touch_host_t *host = context;
+	i2c_touch_host_pin_t *slot = NULL;
+
+	for (uint8_t i = 0; i < host->pin_count; i++)
+	{
+		if (host->pins[i].pin == pin)
+		{
+			slot = &host->pins[i];
+		}
+	}
+	if (slot == NULL)
+	{
+		if (host->pin_count >= I2C_TOUCH_HOST_MAX_DEVICES)
+		{
+			return I2C_TOUCH_ERROR_INVALID_PARAM;
+		}
+		slot = &host->pins[host->pin_count++];
+	}
+
+	slot->pin = pin;
+	slot->handler = handler;
+	slot->p_context = p_context;
+	slot->level = host_level(host, pin);
+	return I2C_TOUCH_SUCCESS;
+}
+
+static void host_pin_uninit(void *context, uint32_t pin)
+{
+	i2c_touch_host_t *host = context;
+	for (uint8_t i = 0; i < host->pin_count; i++)
+	{
+		if (host->pins[i].pin == pin)
+		{
+			host->pins[i].handler = NULL;
+		}
+	}
+}
+
+static bool host_pin_is_set(void *context, uint32_t pin)
+{
+	return host_level(context, pin);
+}
+
+static void host_delay_us(void *context, uint32_t us)
+{
+	i2c_touch_host_t *host = context;
+
+	if (host->realtime)
+	{
+		struct timespec ts = {.tv_sec = us / 1000000u, .tv_nsec = (long)(us % 1000000u) * 1000};
+		nanosleep(&ts, NULL);
+	}
+	host_step(host, (uint64_t)us * 1000u);
+}
+
+static uint32_t host_time_us(void *context)
+{
+	i2c_touch_host_t *host = context;
+	return (uint32_t)(i2c_touch_host_now_ns(host) / 1000u);
+}
+
+static int host_timer_start(void *context, i2c_touch_timer_t *timer, uint32_t us,
+                            i2c_touch_timer_handler_t handler, void *p_context)
+{
+	i2c_touch_host_t *host = context;
+
+	if (!timer->armed)
+	{
+		timer->next = host->timers;
+		host->timers = timer;
+	}
+	timer->deadline_ns = i2c_touch_host_now_ns(host) + (uint64_t)us * 1000u;
+	timer->handler = handler;
+	timer->p_context = p_context;
+	timer->armed = true;
+	return I2C_TOUCH_SUCCESS;
+}
+
+static void host_timer_stop(void *context, i2c_touch_timer_t *timer)
+{
+	i2c_touch_host_t *host = context;
+
+	for (i2c_touch_timer_t **link = &host->timers; *link != NULL; link = &(*link)->next)
+	{
+		if (*link == timer)
+		{
+			*link = timer->next;
+			break;
+		}
+	}
+	timer->armed = false;
+}
+
+static int host_read_async(void *context, uint8_t address, uint8_t reg, uint8_t *data, uint32_t len,
+                           i2c_touch_xfer_handler_t handler, void *p_context)
+{
+	i2c_touch_host_t *host = context;
+	if (host->xfer_handler != NULL)
+	{
+		return I2C_TOUCH_ERROR_BUSY;
+	}
+
+	const i2c_touch_host_slot_t *slot = host_find(host, address);
+	int retCode = I2C_TOUCH_ERROR_ANACK;
+	if (slot != NULL)
+	{
+		retCode = slot->device->tx(slot->context, address, &reg, 1, false);
+		if (retCode == I2C_TOUCH_SUCCESS)
+		{
+			retCode = slot->device->rx(slot->context, address, data, len);
+		}
+	}
+
+	uint64_t ns = host_wire_time_ns(host, 1) + host_wire_time_ns(host, len);
+	host->wire_ns += ns;
+	host->xfer_deadline_ns = i2c_touch_host_now_ns(host) + ns;
+	host->xfer_result = retCode;
+	host->xfer_p_context = p_context;
+	host->xfer_handler = handler;
+	host_step(host, 0);
+	return I2C_TOUCH_SUCCESS;
+}
+
+static const i2c_touch_host_slot_t *host_find(const i2c_touch_host_t *host, uint8_t address)
+{
+	for (uint8_t i = 0; i < host->device_count; i++)
+	{
+		if (host->devices[i].address == address)
+		{
+			return &host->devices[i];
+		}
+	}
+	return NULL;
+}
+
+/* Devices release pins they do not drive, so the line is low if any device
+ * pulls it low. */
+static bool host_level(const i2c_touch_host_t *host, uint32_t pin)
+{
+	for (uint8_t i = 0; i < host->device_count; i++)
+	{
+		const i2c_touch_host_slot_t *slot = &host->devices[i];
+		if (!slot->device->pin_is_set(slot->context, pin))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Move the clock, let the devices catch up and deliver timer expiries,
+ * transfer completions and RDY falling edges. */
+static void host_step(i2c_touch_host_t *host, uint64_t ns)
+{
+	if (!host->realtime)
+	{
+		host->now_ns += ns;
+	}
+	uint64_t now = i2c_touch_host_now_ns(host);
+
+	/* Handlers may restart their own or other timers, rescan after each. */
+	bool fired = true;
+	while (fired)
+	{
+		fired = false;
+		for (i2c_touch_timer_t **link = &host->timers; *link != NULL; link = &(*link)->next)
+		{
+			i2c_touch_timer_t *timer = *link;
+			if (now >= timer->deadline_ns)
+			{
+				*link = timer->next;
+				timer->armed = false;
+				timer->handler(timer->p_context);
+				fired = true;
+				break;
+			}
+		}
+	}
+
+	if ((host->xfer_handler != NULL) && (now >= host->xfer_deadline_ns))
+	{
+		i2c_touch_xfer_handler_t xferHandler = host->xfer_handler;
+		host->xfer_handler = NULL;
+		xferHandler(host->xfer_result, host->xfer_p_context);
+	}
+
+	uint32_t nowUs = (uint32_t)(now / 1000u);
+	for (uint8_t i = 0; i < host->device_count; i++)
+	{
+		const i2c_touch_host_slot_t *slot = &host->devices[i];
+		if (slot->device->advance != NULL)
+		{
+			slot->device->advance(slot->context, nowUs);
+		}
+	}
+
+	/* A pin handler may start a transfer and step the clock again, record
+	 * the level first so the edge is delivered once. */
+	for (uint8_t i = 0; i < host->pin_count; i++)
+	{
+		i2c_touch_host_pin_t *pin = &host->pins[i];
+		bool level = host_level(host, pin->pin);
+		bool fell = pin->level && !level;
+		pin->level = level;
+		if (fell && (pin->handler != NULL))
+		{
+			pin->handler(pin->pin, pin->p_context);
+		}
+	}
+}
+
+/* Let the clock run to the completion of the read in flight, as a blocking
+ * transfer on target waits for the completion event. */
+static void host_wait(i2c_touch_host_t *host)
+{
+	while (host->xfer_handler != NULL)
+	{
+		uint64_t now = i2c_touch_host_now_ns(host);
+		host_step(host, (host->xfer_deadline_ns > now) ? host->xfer_deadline_ns - now : 0);
+	}
+}
+
+static void host_charge_wire(i2c_touch_host_t *host, uint32_t len)
+{
+	uint64_t ns = host_wire_time_ns(host, len);
+	host->wire_ns += ns;
+	host_step(host, ns);
+}
+
+static uint64_t host_wire_time_ns(const i2c_touch_host_t *host, uint32_t len)
+{
+	if (host->bus_hz == 0)
+	{
+		return 0;
+	}
+
+	uint64_t bits = HOST_FRAME_OVERHEAD_BITS + (uint64_t)len * HOST_BITS_PER_BYTE;
+	return (bits * 1000000000ull) / host->bus_hz;
+}
+
+static uint64_t host_wall_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+//--------------------------- INTERRUPT HANDLERS ------------------------------
+
+#endif // I2C_TOUCH_HOST
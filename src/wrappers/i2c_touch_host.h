@@ -0,0 +1,100 @@
+/** @file i2c_touch_host.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef I2C_TOUCH_HOST_H
+#define I2C_TOUCH_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "i2c_touch.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+
+/* Devices and RDY pins per host bus. */
+#ifndef I2C_TOUCH_HOST_MAX_DEVICES
+#define I2C_TOUCH_HOST_MAX_DEVICES 4
+#endif
+
+/* Longest write frame, register prefix included. */
+#ifndef I2C_TOUCH_HOST_MAX_TX
+#define I2C_TOUCH_HOST_MAX_TX 258
+#endif
+
+//----------------------------- DATA TYPES ------------------------------------
+
+/* Device attached to the host bus. A device model or a trace replayer
+ * implements these; the host backend owns the clock and the RDY edge
+ * detection. */
+typedef struct
+{
+	int (*tx)(void *device, uint8_t address, uint8_t const *data, uint32_t len, bool stop);
+	int (*rx)(void *device, uint8_t address, uint8_t *data, uint32_t len);
+	bool (*pin_is_set)(void *device, uint32_t pin);
+	/* Time moved forward to now_us. May be NULL. */
+	void (*advance)(void *device, uint32_t now_us);
+} i2c_touch_host_device_t;
+
+typedef struct
+{
+	uint8_t address;
+	const i2c_touch_host_device_t *device;
+	void *context;
+} i2c_touch_host_slot_t;
+
+typedef struct
+{
+	uint32_t pin;
+	bool level;
+	i2c_touch_pin_handler_t handler;
+	void *p_context;
+} i2c_touch_host_pin_t;
+
+/* Host bus context, passed to i2c_touch_init / iqs7222c_begin on Linux. All
+ * devices attached to one host share its clock. */
+struct i2c_touch_host
+{
+	/* SCL frequency used to charge wire time to the virtual clock, 0 = free. */
+	uint32_t bus_hz;
+	/* true = wall clock and real sleeps, false = virtual clock. */
+	bool realtime;
+
+	/* Private. */
+	i2c_touch_host_slot_t devices[I2C_TOUCH_HOST_MAX_DEVICES];
+	uint8_t device_count;
+	i2c_touch_host_pin_t pins[I2C_TOUCH_HOST_MAX_DEVICES];
+	uint8_t pin_count;
+	uint64_t now_ns;
+	uint64_t wire_ns;
+	i2c_touch_timer_t *timers;
+	uint64_t xfer_deadline_ns;
+	i2c_touch_xfer_handler_t xfer_handler;
+	void *xfer_p_context;
+	int xfer_result;
+};
+
+typedef struct i2c_touch_host i2c_touch_host_t;
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+void i2c_touch_host_setup(i2c_touch_host_t *host, uint32_t bus_hz);
+int i2c_touch_host_attach(i2c_touch_host_t *host, uint8_t address,
+                          const i2c_touch_host_device_t *device, void *device_context);
+void i2c_touch_host_advance(i2c_touch_host_t *host, uint32_t us);
+uint64_t i2c_touch_host_now_ns(const i2c_touch_host_t *host);
+uint64_t i2c_touch_host_wire_ns(const i2c_touch_host_t *host);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2C_TOUCH_HOST_H
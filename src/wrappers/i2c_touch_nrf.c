@@ -0,0 +1,447 @@
+/** @file i2c_touch_nrf.c
+*
+* @brief i2c_touch backend for nRF5x targets. Bus transfers use the
+* nrf_drv_twi API, the RDY line uses nrf_drv_gpiote and time is taken from the
+* app_timer RTC. With I2C_TOUCH_TWI_ASYNC the TWI runs in non-blocking mode,
+* completions arrive through i2c_touch_nrf_twi_handler and the blocking
+* transfers wait for them, and for a read in flight before they start. An
+* interrupt handler cannot wait for the TWI interrupt, blocking transfers from
+* one are refused with I2C_TOUCH_ERROR_INVALID_STATE.
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include <i2c_touch.h>
+
+#if !I2C_TOUCH_HOST
+
+#include "i2c.h"
+#include "nrf_error.h"
+#include "sdk_errors.h"
+#include "nrf_drv_gpiote.h"
+#include "nrf_delay.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "nrf.h"
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+
+/* RDY pins with an interrupt handler, one per device. */
+#ifndef I2C_TOUCH_NRF_MAX_PINS
+#define I2C_TOUCH_NRF_MAX_PINS 4
+#endif
+
+/* Longest write made of a register prefix and a payload, gathered on the
+ * stack. */
+#ifndef I2C_TOUCH_NRF_MAX_TX
+#define I2C_TOUCH_NRF_MAX_TX 130
+#endif
+
+//----------------------------- DATA TYPES ------------------------------------
+
+typedef struct
+{
+	uint32_t pin;
+	i2c_touch_pin_handler_t handler;
+	void *p_context;
+} nrf_pin_slot_t;
+
+#if I2C_TOUCH_TWI_ASYNC
+/* Transfer in flight on one TWI instance. */
+typedef struct
+{
+	volatile bool pending;
+	volatile int result;
+	i2c_touch_xfer_handler_t handler;
+	void *p_context;
+	uint8_t reg;
+} nrf_xfer_t;
+#endif
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static int nrf_tx(void *context, uint8_t address, uint8_t const *prefix, uint32_t prefix_len,
+                  uint8_t const *data, uint32_t len, bool stop);
+static int nrf_tx_single(nrf_drv_twi_t const *twi, uint8_t address, uint8_t const *data,
+                         uint32_t len, bool stop);
+static int nrf_rx(void *context, uint8_t address, uint8_t *data, uint32_t len);
+static int nrf_pin_init(void *context, uint32_t pin, i2c_touch_pin_handler_t handler, void *p_context);
+static void nrf_pin_uninit(void *context, uint32_t pin);
+static bool nrf_pin_is_set(void *context, uint32_t pin);
+static void nrf_delay(void *context, uint32_t us);
+static uint32_t nrf_time_us(void *context);
+static int nrf_timer_start(void *context, i2c_touch_timer_t *timer, uint32_t us,
+                           i2c_touch_timer_handler_t handler, void *p_context);
+static void nrf_timer_stop(void *context, i2c_touch_timer_t *timer);
+static int nrf_read_async(void *context, uint8_t address, uint8_t reg, uint8_t *data, uint32_t len,
+                          i2c_touch_xfer_handler_t handler, void *p_context);
+#if I2C_TOUCH_TWI_ASYNC
+static int nrf_claim(nrf_xfer_t *xfer, bool wait);
+static int nrf_wait(nrf_xfer_t *xfer, ret_code_t retCode);
+#endif
+static void nrf_timer_event(void *p_context);
+static void nrf_pin_event(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+
+static nrf_pin_slot_t pinSlots[I2C_TOUCH_NRF_MAX_PINS];
+static uint32_t lastTicks;
+static uint64_t elapsedTicks;
+
+#if I2C_TOUCH_TWI_ASYNC
+static nrf_xfer_t xfers[TWI_COUNT];
+#endif
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+const i2c_touch_backend_t i2c_touch_nrf_backend = {
+	.tx = nrf_tx,
+	.rx = nrf_rx,
+	.pin_init = nrf_pin_init,
+	.pin_uninit = nrf_pin_uninit,
+	.pin_is_set = nrf_pin_is_set,
+	.delay_us = nrf_delay,
+	.time_us = nrf_time_us,
+	.timer_start = nrf_timer_start,
+	.timer_stop = nrf_timer_stop,
+	.read_async = nrf_read_async,
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+/* A register write is gathered into one buffer. TWIM TXTX descriptors send
+ * the device address again before the second buffer, which the IQS7222C would
+ * take as a new register address, and EasyDMA cannot read flash. Address only
+ * writes go out as they are. */
+static int nrf_tx(void *context, uint8_t address, uint8_t const *prefix, uint32_t prefix_len,
+                  uint8_t const *data, uint32_t len, bool stop)
+{
+	nrf_drv_twi_t const *twi = context;
+
+	if (len == 0)
+	{
+		return nrf_tx_single(twi, address, prefix, prefix_len, stop);
+	}
+	if (prefix_len + len > I2C_TOUCH_NRF_MAX_TX)
+	{
+		return I2C_TOUCH_ERROR_INVALID_PARAM;
+	}
+
+	uint8_t frame[I2C_TOUCH_NRF_MAX_TX];
+	memcpy(frame, prefix, prefix_len);
+	memcpy(&frame[prefix_len], data, len);
+	return nrf_tx_single(twi, address, frame, prefix_len + len, stop);
+}
+
+/* nrf_drv_twi_tx takes no_stop, the inverse of the backend's stop flag. */
+static int nrf_tx_single(nrf_drv_twi_t const *twi, uint8_t address, uint8_t const *data,
+                         uint32_t len, bool stop)
+{
+#if I2C_TOUCH_TWI_ASYNC
+	nrf_xfer_t *xfer = &xfers[twi->inst_idx];
+	int retCode = nrf_claim(xfer, true);
+	if (retCode != I2C_TOUCH_SUCCESS)
+	{
+		return retCode;
+	}
+	return nrf_wait(xfer, nrf_drv_twi_tx(twi, address, data, len, !stop));
+#else
+	return nrf_drv_twi_tx(twi, address, data, len, !stop);
+#endif
+}
+
+static int nrf_rx(void *context, uint8_t address, uint8_t *data, uint32_t len)
+{
+#if I2C_TOUCH_TWI_ASYNC
+	nrf_drv_twi_t const *twi = context;
+	nrf_xfer_t *xfer = &xfers[twi->inst_idx];
+	int retCode = nrf_claim(xfer, true);
+	if (retCode != I2C_TOUCH_SUCCESS)
+	{
+		return retCode;
+	}
+	return nrf_wait(xfer, nrf_drv_twi_rx(twi, address, data, len));
+#else
+	return nrf_drv_twi_rx((nrf_drv_twi_t const *)context, address, data, len);
+#endif
+}
+
+#if I2C_TOUCH_TWI_ASYNC
+/* Take the instance for one transfer. The test and set run with interrupts
+ * off, an RDY interrupt cannot start a read in between. A blocking transfer
+ * (wait) waits for the read in flight to complete, which only thread mode
+ * can do: an interrupt handler would spin before the TWI interrupt. */
+static int nrf_claim(nrf_xfer_t *xfer, bool wait)
+{
+	bool claimed = false;
+
+	if (wait && (__get_IPSR() != 0))
+	{
+		return I2C_TOUCH_ERROR_INVALID_STATE;
+	}
+	while (!claimed)
+	{
+		CRITICAL_REGION_ENTER();
+		if (!xfer->pending)
+		{
+			xfer->pending = true;
+			claimed = true;
+		}
+		CRITICAL_REGION_EXIT();
+
+		if (!claimed && !wait)
+		{
+			return I2C_TOUCH_ERROR_BUSY;
+		}
+	}
+	return I2C_TOUCH_SUCCESS;
+}
+
+/* Wait for the completion event of a transfer the driver accepted. The
+ * instance was claimed by the caller, so a transfer the driver refused
+ * leaves nothing of ours in flight. */
+static int nrf_wait(nrf_xfer_t *xfer, ret_code_t retCode)
+{
+	if (retCode != NRF_SUCCESS)
+	{
+		xfer->pending = false;
+		return retCode;
+	}
+	while (xfer->pending)
+	{
+	}
+	return xfer->result;
+}
+#endif
+
+/* One TXRX descriptor, the register address is sent with a repeated start
+ * before the read. Without I2C_TOUCH_TWI_ASYNC the transfer is done in place
+ * and the handler is called before returning. */
+static int nrf_read_async(void *context, uint8_t address, uint8_t reg, uint8_t *data, uint32_t len,
+                          i2c_touch_xfer_handler_t handler, void *p_context)
+{
+#if I2C_TOUCH_TWI_ASYNC
+	nrf_drv_twi_t const *twi = context;
+	nrf_xfer_t *xfer = &xfers[twi->inst_idx];
+	int claim = nrf_claim(xfer, false);
+	if (claim != I2C_TOUCH_SUCCESS)
+	{
+		return claim;
+	}
+
+	xfer->reg = reg;
+	xfer->handler = handler;
+	xfer->p_context = p_context;
+	nrf_drv_twi_xfer_desc_t desc = NRF_DRV_TWI_XFER_DESC_TXRX(address, &xfer->reg, 1, data, len);
+	ret_code_t retCode = nrf_drv_twi_xfer(twi, &desc, 0);
+	if (retCode != NRF_SUCCESS)
+	{
+		xfer->handler = NULL;
+		xfer->pending = false;
+	}
+	return retCode;
+#else
+	int retCode = nrf_drv_twi_tx((nrf_drv_twi_t const *)context, address, &reg, 1, true);
+	if (retCode == NRF_SUCCESS)
+	{
+		retCode = nrf_drv_twi_rx((nrf_drv_twi_t const *)context, address, data, len);
+	}
+	if (handler != NULL)
+	{
+		handler(retCode, p_context);
+	}
+	return NRF_SUCCESS;
+#endif
+}
+
+static int nrf_pin_init(void *context, uint32_t pin, i2c_touch_pin_handler_t handler, void *p_context)
+{
+	ret_code_t retCode = NRF_SUCCESS;
+
+	if (false == nrf_drv_gpiote_is_init())
+	{
+		retCode = nrf_drv_gpiote_init();
+	}
+
+	if (retCode != NRF_SUCCESS)
+	{
+		return retCode;
+	}
+
+	if (handler == NULL)
+	{
+		nrf_drv_gpiote_in_config_t pin_config_in = GPIOTE_CONFIG_IN_SENSE_TOGGLE(true);
+		return nrf_drv_gpiote_in_init(pin, &pin_config_in, NULL);
+	}
+
+	// A pin that is initialised again keeps its slot and its GPIOTE channel,
+	// only the handler changes. Otherwise take the first free slot.
+	nrf_pin_slot_t *slot = NULL;
+	for (uint32_t i = 0; i < I2C_TOUCH_NRF_MAX_PINS; i++)
+	{
+		if ((pinSlots[i].handler != NULL) && (pinSlots[i].pin == pin))
+		{
+			nrf_drv_gpiote_in_event_disable(pin);
+			pinSlots[i].p_context = p_context;
+			pinSlots[i].handler = handler;
+			nrf_drv_gpiote_in_event_enable(pin, true);
+			return NRF_SUCCESS;
+		}
+		if ((slot == NULL) && (pinSlots[i].handler == NULL))
+		{
+			slot = &pinSlots[i];
+		}
+	}
+	if (slot == NULL)
+	{
+		return NRF_ERROR_NO_MEM;
+	}
+
+	slot->pin = pin;
+	slot->p_context = p_context;
+	slot->handler = handler;
+	nrf_drv_gpiote_in_config_t rdy_pin_interrupt_cfg = GPIOTE_CONFIG_IN_SENSE_HITOLO(true);
+	retCode = nrf_drv_gpiote_in_init(pin, &rdy_pin_interrupt_cfg, nrf_pin_event);
+	if (retCode == NRF_SUCCESS)
+	{
+		nrf_drv_gpiote_in_event_enable(pin, true);
+	}
+	else
+	{
+		slot->handler = NULL;
+	}
+	return retCode;
+}
+
+static void nrf_pin_uninit(void *context, uint32_t pin)
+{
+	nrf_drv_gpiote_in_uninit(pin);
+	for (uint32_t i = 0; i < I2C_TOUCH_NRF_MAX_PINS; i++)
+	{
+		if (pinSlots[i].pin == pin)
+		{
+			pinSlots[i].handler = NULL;
+		}
+	}
+}
+
+static bool nrf_pin_is_set(void *context, uint32_t pin)
+{
+	return nrf_drv_gpiote_in_is_set(pin);
+}
+
+static void nrf_delay(void *context, uint32_t us)
+{
+	nrf_delay_us(us);
+}
+
+/* app_timer counter is 24 bit at APP_TIMER_CLOCK_FREQ, accumulate the
+ * differences so the returned value wraps at 2^32 us instead. Must be called
+ * at least once per counter period (512 s with prescaler 0). Called from both
+ * thread and interrupt context, hence the critical region. */
+static uint32_t nrf_time_us(void *context)
+{
+	uint64_t ticks;
+
+	CRITICAL_REGION_ENTER();
+	uint32_t now = app_timer_cnt_get();
+	elapsedTicks += app_timer_cnt_diff_compute(now, lastTicks);
+	lastTicks = now;
+	ticks = elapsedTicks;
+	CRITICAL_REGION_EXIT();
+
+	return (uint32_t)((ticks * 1000000ULL) / APP_TIMER_CLOCK_FREQ);
+}
+
+/* app_timer resolution is used in whole milliseconds, enough for the RDY and
+ * reset timeouts of the init sequence. The app_timer instance lives in the
+ * caller's i2c_touch_timer_t and is created on first use. */
+static int nrf_timer_start(void *context, i2c_touch_timer_t *timer, uint32_t us,
+                           i2c_touch_timer_handler_t handler, void *p_context)
+{
+	ret_code_t retCode;
+
+	if (timer->id == NULL)
+	{
+		timer->id = &timer->data;
+		retCode = app_timer_create(&timer->id, APP_TIMER_MODE_SINGLE_SHOT, nrf_timer_event);
+		if (retCode != NRF_SUCCESS)
+		{
+			timer->id = NULL;
+			return retCode;
+		}
+	}
+
+	uint32_t ms = (us + 999) / 1000;
+	timer->handler = handler;
+	timer->p_context = p_context;
+	app_timer_stop(timer->id);
+	return app_timer_start(timer->id, APP_TIMER_TICKS(ms ? ms : 1), timer);
+}
+
+static void nrf_timer_stop(void *context, i2c_touch_timer_t *timer)
+{
+	if (timer->id != NULL)
+	{
+		app_timer_stop(timer->id);
+	}
+}
+
+//--------------------------- INTERRUPT HANDLERS ------------------------------
+#if I2C_TOUCH_TWI_ASYNC
+/* TWI event handler, pass it to nrf_drv_twi_init with the nrf_drv_twi_t
+ * instance as p_context, or call it from the application's own handler. */
+void i2c_touch_nrf_twi_handler(nrf_drv_twi_evt_t const *p_event, void *p_context)
+{
+	nrf_drv_twi_t const *twi = p_context;
+	nrf_xfer_t *xfer = &xfers[twi->inst_idx];
+
+	switch (p_event->type)
+	{
+	case NRF_DRV_TWI_EVT_DONE:
+		xfer->result = I2C_TOUCH_SUCCESS;
+		break;
+	case NRF_DRV_TWI_EVT_ADDRESS_NACK:
+		xfer->result = I2C_TOUCH_ERROR_ANACK;
+		break;
+	default:
+		xfer->result = I2C_TOUCH_ERROR_DNACK;
+		break;
+	}
+
+	i2c_touch_xfer_handler_t handler = xfer->handler;
+	xfer->handler = NULL;
+	xfer->pending = false;
+	if (handler != NULL)
+	{
+		handler(xfer->result, xfer->p_context);
+	}
+}
+#endif
+
+static void nrf_timer_event(void *p_context)
+{
+	i2c_touch_timer_t *timer = p_context;
+	if (timer->handler != NULL)
+	{
+		timer->handler(timer->p_context);
+	}
+}
+
+static void nrf_pin_event(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
+{
+	for (uint32_t i = 0; i < I2C_TOUCH_NRF_MAX_PINS; i++)
+	{
+		if ((pinSlots[i].pin == pin) && (pinSlots[i].handler != NULL))
+		{
+			pinSlots[i].handler(pin, pinSlots[i].p_context);
+			return;
+		}
+	}
+}
+
+#endif // !I2C_TOUCH_HOST
@@ -0,0 +1,349 @@
+/** @file i2c_touch_trace.c
+*
+* @brief i2c_touch backend that records the traffic of another backend. Every
+* write, read, asynchronous read and RDY falling edge is passed on unchanged
+* and written to a sink as a binary record with the inner backend's time.
+* Asynchronous reads are recorded when they complete. GPIO, clock and timer
+* calls are passed through. The trace is replayed on the host with
+* i2c_touch_replay.
+*
+* RDY edges and asynchronous read completions arrive in interrupt context.
+* They are only latched into a small single producer ring there and written
+* to the sink from thread context, before the next blocking transfer or by
+* i2c_touch_trace_flush, so the sink never runs in an interrupt and records
+* never interleave. Edge and completion interrupts must not preempt each
+* other (same priority).
+*
+* @par
+* COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+* All rights reserved.
+*/
+
+//------------------------------ INCLUDES -------------------------------------
+#include <i2c_touch_trace.h>
+#include <stddef.h>
+#include <string.h>
+
+//-------------------------------- MACROS -------------------------------------
+#if (I2C_TOUCH_TRACE_MAX_PENDING & (I2C_TOUCH_TRACE_MAX_PENDING - 1)) != 0
+#error "I2C_TOUCH_TRACE_MAX_PENDING must be a power of two"
+#endif
+#define PENDING_MASK (I2C_TOUCH_TRACE_MAX_PENDING - 1)
+
+/* Orders the pending slot against the index update. */
+#define PENDING_BARRIER() __sync_synchronize()
+
+//----------------------------- DATA TYPES ------------------------------------
+
+//--------------------- PRIVATE FUNCTION PROTOTYPES ---------------------------
+static int trace_tx(void *context, uint8_t address, uint8_t const *prefix, uint32_t prefix_len,
+                    uint8_t const *data, uint32_t len, bool stop);
+static int trace_rx(void *context, uint8_t address, uint8_t *data, uint32_t len);
+static int trace_pin_init(void *context, uint32_t pin, i2c_touch_pin_handler_t handler, void *p_context);
+static void trace_pin_uninit(void *context, uint32_t pin);
+static bool trace_pin_is_set(void *context, uint32_t pin);
+static void trace_delay_us(void *context, uint32_t us);
+static uint32_t trace_time_us(void *context);
+static int trace_timer_start(void *context, i2c_touch_timer_t *timer, uint32_t us,
+                             i2c_touch_timer_handler_t handler, void *p_context);
+static void trace_timer_stop(void *context, i2c_touch_timer_t *timer);
+static int trace_read_async(void *context, uint8_t address, uint8_t reg, uint8_t *data, uint32_t len,
+                            i2c_touch_xfer_handler_t handler, void *p_context);
+static void trace_record(i2c_touch_trace_t *trace, uint8_t type, uint32_t timeUs, uint8_t address,
+                         uint8_t flags, int result, const uint8_t *first, uint32_t firstLen,
+                         const uint8_t *second, uint32_t secondLen);
+static i2c_touch_trace_pending_t *trace_pending_slot(i2c_touch_trace_t *trace);
+static void trace_pending_push(i2c_touch_trace_t *trace);
+static void trace_edge(uint32_t pin, void *p_context);
+static void trace_xfer_done(int result, void *p_context);
+
+//----------------------- STATIC DATA & CONSTANTS -----------------------------
+static const uint8_t traceHeader[I2C_TOUCH_TRACE_HEADER_BYTES] = {'I', '2', 'C', 'T',
+                                                                  I2C_TOUCH_TRACE_VERSION};
+
+//------------------------------ GLOBAL DATA ----------------------------------
+
+const i2c_touch_backend_t i2c_touch_trace_backend = {
+	.tx = trace_tx,
+	.rx = trace_rx,
+	.pin_init = trace_pin_init,
+	.pin_uninit = trace_pin_uninit,
+	.pin_is_set = trace_pin_is_set,
+	.delay_us = trace_delay_us,
+	.time_us = trace_time_us,
+	.timer_start = trace_timer_start,
+	.timer_stop = trace_timer_stop,
+	.read_async = trace_read_async,
+};
+
+//---------------------------- PUBLIC FUNCTIONS -------------------------------
+
+/* Record the traffic of backend / context into sink, starting with the file
+ * header. Hand i2c_touch_trace_backend and the trace to the driver instead
+ * of the inner backend, e.g. with iqs7222c_beginBackend. */
+void i2c_touch_trace_init(i2c_touch_trace_t *trace, const i2c_touch_backend_t *backend,
+                          void *context, i2c_touch_trace_sink_t sink, void *sink_context)
+{
+	trace->inner.backend = backend;
+	trace->inner.context = context;
+	trace->sink = sink;
+	trace->sink_context = sink_context;
+	trace->records = 0;
+	trace->dropped = 0;
+	trace->pin_count = 0;
+	trace->xfer_handler = NULL;
+	trace->pending_head = 0;
+	trace->pending_tail = 0;
+	sink(sink_context, traceHeader, sizeof(traceHeader));
+}
+
+/* Write the edges and asynchronous reads latched since the last transfer.
+ * Call from thread context, e.g. after iqs7222c_run in the main loop, when
+ * the driver reads its windows asynchronously. */
+void i2c_touch_trace_flush(i2c_touch_trace_t *trace)
+{
+	while (trace->pending_tail != trace->pending_head)
+	{
+		const i2c_touch_trace_pending_t *pending = &trace->pending[trace->pending_tail & PENDING_MASK];
+
+		if (pending->type == I2C_TOUCH_TRACE_EDGE)
+		{
+			trace_record(trace, I2C_TOUCH_TRACE_EDGE, pending->time_us, pending->address, 0,
+			             I2C_TOUCH_SUCCESS, NULL, 0, NULL, 0);
+		}
+		else
+		{
+			// The register write and the read, both stamped with the start.
+			trace_record(trace, I2C_TOUCH_TRACE_TX, pending->time_us, pending->address,
+			             I2C_TOUCH_TRACE_READ,
+			             (pending->result == I2C_TOUCH_ERROR_ANACK) ? pending->result : I2C_TOUCH_SUCCESS,
+			             &pending->reg, 1, NULL, 0);
+			trace_record(trace, I2C_TOUCH_TRACE_RX, pending->time_us, pending->address, 0,
+			             pending->result, pending->data, pending->len, NULL, 0);
+		}
+		PENDING_BARRIER();
+		trace->pending_tail++;
+	}
+}
+
+//--------------------------- PRIVATE FUNCTIONS -------------------------------
+static int trace_tx(void *context, uint8_t address, uint8_t const *prefix, uint32_t prefix_len,
+                    uint8_t const *data, uint32_t len, bool stop)
+{
+	i2c_touch_trace_t *trace = context;
+	i2c_touch_trace_flush(trace);
+	uint32_t timeUs = i2c_touch_time_us(&trace->inner);
+	int retCode = trace->inner.backend->tx(trace->inner.context, address, prefix, prefix_len, data,
+	                                       len, stop);
+	uint8_t flags = (stop ? I2C_TOUCH_TRACE_STOP : 0) | ((len == 0) ? I2C_TOUCH_TRACE_READ : 0);
+
+	trace_record(trace, I2C_TOUCH_TRACE_TX, timeUs, address, flags, retCode, prefix, prefix_len,
+	             data, len);
+	return retCode;
+}
+
+static int trace_rx(void *context, uint8_t address, uint8_t *data, uint32_t len)
+{
+	i2c_touch_trace_t *trace = context;
+	i2c_touch_trace_flush(trace);
+	uint32_t timeUs = i2c_touch_time_us(&trace->inner);
+	int retCode = trace->inner.backend->rx(trace->inner.context, address, data, len);
+
+	trace_record(trace, I2C_TOUCH_TRACE_RX, timeUs, address, 0, retCode, data, len, NULL, 0);
+	return retCode;
+}
+
+/* Edges reach the caller's handler through trace_edge. */
+static int trace_pin_init(void *context, uint32_t pin, i2c_touch_pin_handler_t handler, void *p_context)
+{
+	i2c_touch_trace_t *trace = context;
+	i2c_touch_trace_pin_t *slot = NULL;
+
+	if (handler == NULL)
+	{
+		return i2c_touch_pin_init(&trace->inner, pin, NULL, NULL);
+	}
+
+	for (uint8_t i = 0; i < trace->pin_count; i++)
+	{
+		if (trace->pins[i].pin == pin)
+		{
+			slot = &trace->pins[i];
+		}
+	}
+	if (slot == NULL)
+	{
+		if (trace->pin_count >= I2C_TOUCH_TRACE_MAX_PINS)
+		{
+			return I2C_TOUCH_ERROR_INVALID_PARAM;
+		}
+		slot = &trace->pins[trace->pin_count++];
+	}
+
+	slot->pin = pin;
+	slot->handler = handler;
+	slot->p_context = p_context;
+	return i2c_touch_pin_init(&trace->inner, pin, trace_edge, trace);
+}
+
+static void trace_pin_uninit(void *context, uint32_t pin)
+{
+	i2c_touch_trace_t *trace = context;
+	i2c_touch_pin_uninit(&trace->inner, pin);
+}
+
+static bool trace_pin_is_set(void *context, uint32_t pin)
+{
+	i2c_touch_trace_t *trace = context;
+	return i2c_touch_pin_is_set(&trace->inner, pin);
+}
+
+static void trace_delay_us(void *context, uint32_t us)
+{
+	i2c_touch_trace_t *trace = context;
+	i2c_touch_delay_us(&trace->inner, us);
+}
+
+static uint32_t trace_time_us(void *context)
+{
+	i2c_touch_trace_t *trace = context;
+	return i2c_touch_time_us(&trace->inner);
+}
+
+static int trace_timer_start(void *context, i2c_touch_timer_t *timer, uint32_t us,
+                             i2c_touch_timer_handler_t handler, void *p_context)
+{
+	i2c_touch_trace_t *trace = context;
+	return i2c_touch_timer_start(&trace->inner, timer, us, handler, p_context);
+}
+
+static void trace_timer_stop(void *context, i2c_touch_timer_t *timer)
+{
+	i2c_touch_trace_t *trace = context;
+	i2c_touch_timer_stop(&trace->inner, timer);
+}
+
+static int trace_read_async(void *context, uint8_t address, uint8_t reg, uint8_t *data, uint32_t len,
+                            i2c_touch_xfer_handler_t handler, void *p_context)
+{
+	i2c_touch_trace_t *trace = context;
+
+	if (trace->xfer_handler != NULL)
+	{
+		return I2C_TOUCH_ERROR_BUSY;
+	}
+	if (len > I2C_TOUCH_TRACE_MAX_ASYNC_BYTES)
+	{
+		return I2C_TOUCH_ERROR_INVALID_PARAM;
+	}
+
+	trace->xfer_handler = handler;
+	trace->xfer_p_context = p_context;
+	trace->xfer_data = data;
+	trace->xfer_len = len;
+	trace->xfer_address = address;
+	trace->xfer_reg = reg;
+	trace->xfer_start_us = i2c_touch_time_us(&trace->inner);
+	int retCode = i2c_touch_read_register_async(&trace->inner, address, reg, len, data,
+	                                            trace_xfer_done, trace);
+	if (retCode != I2C_TOUCH_SUCCESS)
+	{
+		trace->xfer_handler = NULL;
+	}
+	return retCode;
+}
+
+static void trace_record(i2c_touch_trace_t *trace, uint8_t type, uint32_t timeUs, uint8_t address,
+                         uint8_t flags, int result, const uint8_t *first, uint32_t firstLen,
+                         const uint8_t *second, uint32_t secondLen)
+{
+	uint32_t len = firstLen + secondLen;
+	uint8_t record[I2C_TOUCH_TRACE_RECORD_BYTES] = {
+	    type,
+	    (uint8_t)timeUs,
+	    (uint8_t)(timeUs >> 8),
+	    (uint8_t)(timeUs >> 16),
+	    (uint8_t)(timeUs >> 24),
+	    address,
+	    flags,
+	    (uint8_t)result,
+	    (uint8_t)((uint32_t)result >> 8),
+	    (uint8_t)len,
+	    (uint8_t)(len >> 8),
+	};
+
+	trace->sink(trace->sink_context, record, sizeof(record));
+	if (firstLen > 0)
+	{
+		trace->sink(trace->sink_context, first, firstLen);
+	}
+	if (secondLen > 0)
+	{
+		trace->sink(trace->sink_context, second, secondLen);
+	}
+	trace->records++;
+}
+
+/* Next free pending slot, NULL when the ring is full. */
+static i2c_touch_trace_pending_t *trace_pending_slot(i2c_touch_trace_t *trace)
+{
+	if ((uint8_t)(trace->pending_head - trace->pending_tail) >= I2C_TOUCH_TRACE_MAX_PENDING)
+	{
+		trace->dropped++;
+		return NULL;
+	}
+	return &trace->pending[trace->pending_head & PENDING_MASK];
+}
+
+static void trace_pending_push(i2c_touch_trace_t *trace)
+{
+	PENDING_BARRIER();
+	trace->pending_head++;
+}
+
+//--------------------------- INTERRUPT HANDLERS ------------------------------
+static void trace_edge(uint32_t pin, void *p_context)
+{
+	i2c_touch_trace_t *trace = p_context;
+
+	for (uint8_t i = 0; i < trace->pin_count; i++)
+	{
+		i2c_touch_trace_pin_t *slot = &trace->pins[i];
+		if (slot->pin == pin)
+		{
+			i2c_touch_trace_pending_t *pending = trace_pending_slot(trace);
+			if (pending != NULL)
+			{
+				pending->type = I2C_TOUCH_TRACE_EDGE;
+				pending->time_us = i2c_touch_time_us(&trace->inner);
+				pending->address = (uint8_t)pin;
+				trace_pending_push(trace);
+			}
+			slot->handler(pin, slot->p_context);
+			return;
+		}
+	}
+}
+
+/* The data is copied before the handler can start the next read into the
+ * same buffer. */
+static void trace_xfer_done(int result, void *p_context)
+{
+	i2c_touch_trace_t *trace = p_context;
+	i2c_touch_xfer_handler_t handler = trace->xfer_handler;
+	i2c_touch_trace_pending_t *pending = trace_pending_slot(trace);
+
+	trace->xfer_handler = NULL;
+	if (pending != NULL)
+	{
+		pending->type = I2C_TOUCH_TRACE_RX;
+		pending->time_us = trace->xfer_start_us;
+		pending->address = trace->xfer_address;
+		pending->reg = trace->xfer_reg;
+		pending->result = result;
+		pending->len = (uint8_t)trace->xfer_len;
+		memcpy(pending->data, trace->xfer_data, trace->xfer_len);
+		trace_pending_push(trace);
+	}
+	handler(result, trace->xfer_p_context);
+}
@@ -0,0 +1,116 @@
+/** @file i2c_touch_trace.h
+ *
+ * @brief See source file.
+ *
+ * @par
+ * COPYRIGHT NOTICE: (c) 2020 Smart Lumies d.o.o.
+ * All rights reserved.
+ */
+
+#ifndef I2C_TOUCH_TRACE_H
+#define I2C_TOUCH_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ INCLUDES -------------------------------------
+#include "i2c_touch.h"
+
+//-------------------------- CONSTANTS & MACROS -------------------------------
+
+/* RDY pins forwarded per trace. */
+#ifndef I2C_TOUCH_TRACE_MAX_PINS
+#define I2C_TOUCH_TRACE_MAX_PINS 4
+#endif
+
+/* Edges and asynchronous reads held between interrupt and thread context,
+ * power of two. */
+#ifndef I2C_TOUCH_TRACE_MAX_PENDING
+#define I2C_TOUCH_TRACE_MAX_PENDING 8
+#endif
+
+/* Longest asynchronous read that can be traced. */
+#ifndef I2C_TOUCH_TRACE_MAX_ASYNC_BYTES
+#define I2C_TOUCH_TRACE_MAX_ASYNC_BYTES 16
+#endif
+
+/* File header: "I2CT" and the format version. */
+#define I2C_TOUCH_TRACE_VERSION 1
+#define I2C_TOUCH_TRACE_HEADER_BYTES 5
+
+/* Every record starts with type, time_us (4), address or pin, flags,
+ * result (2) and payload length (2), little endian, then the payload. */
+#define I2C_TOUCH_TRACE_RECORD_BYTES 11
+
+/* Record types */
+#define I2C_TOUCH_TRACE_TX 0x01   /* register address and written data */
+#define I2C_TOUCH_TRACE_RX 0x02   /* data read */
+#define I2C_TOUCH_TRACE_EDGE 0x03 /* RDY falling edge, address holds the pin */
+
+/* Record flags */
+#define I2C_TOUCH_TRACE_STOP 0x01 /* tx ended with a stop, reads always end with one */
+#define I2C_TOUCH_TRACE_READ 0x02 /* tx only set the register address of a read */
+
+//----------------------------- DATA TYPES ------------------------------------
+
+/* Receives the trace bytes in order. Only called from thread context: the
+ * blocking transfers and i2c_touch_trace_flush. */
+typedef void (*i2c_touch_trace_sink_t)(void *p_context, const uint8_t *data, uint32_t len);
+
+typedef struct
+{
+	uint32_t pin;
+	i2c_touch_pin_handler_t handler;
+	void *p_context;
+} i2c_touch_trace_pin_t;
+
+/* An RDY edge or a completed asynchronous read, latched in interrupt
+ * context. */
+typedef struct
+{
+	uint32_t time_us;
+	uint8_t type;    // I2C_TOUCH_TRACE_EDGE, or I2C_TOUCH_TRACE_RX for a read
+	uint8_t address; // pin of an edge
+	uint8_t reg;
+	uint8_t len;
+	int result;
+	uint8_t data[I2C_TOUCH_TRACE_MAX_ASYNC_BYTES];
+} i2c_touch_trace_pending_t;
+
+/* Recording backend wrapped around another one. */
+typedef struct
+{
+	i2c_touch_t inner;
+	i2c_touch_trace_sink_t sink;
+	void *sink_context;
+	uint32_t records;
+	uint32_t dropped; // edges and asynchronous reads lost to a full pending ring
+
+	/* Private. */
+	i2c_touch_trace_pin_t pins[I2C_TOUCH_TRACE_MAX_PINS];
+	uint8_t pin_count;
+	i2c_touch_xfer_handler_t xfer_handler;
+	void *xfer_p_context;
+	uint8_t *xfer_data;
+	uint32_t xfer_len;
+	uint32_t xfer_start_us;
+	uint8_t xfer_address;
+	uint8_t xfer_reg;
+	i2c_touch_trace_pending_t pending[I2C_TOUCH_TRACE_MAX_PENDING];
+	volatile uint8_t pending_head; // written in interrupt context
+	volatile uint8_t pending_tail; // written in thread context
+} i2c_touch_trace_t;
+
+extern const i2c_touch_backend_t i2c_touch_trace_backend;
+
+//---------------------- PUBLIC FUNCTION PROTOTYPES ---------------------------
+void i2c_touch_trace_init(i2c_touch_trace_t *trace, const i2c_touch_backend_t *backend,
+                          void *context, i2c_touch_trace_sink_t sink, void *sink_context);
+void i2c_touch_trace_flush(i2c_touch_trace_t *trace);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2C_TOUCH_TRACE_H